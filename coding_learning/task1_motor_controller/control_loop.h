@@ -0,0 +1,261 @@
+// Fixed-rate control loop. A dedicated thread ticks the motor on absolute deadlines (1-10 kHz); commands arrive
+// through a lock-free mailbox and results go back through another, so the tick path never waits on the menu,
+// never touches the console and never allocates.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "motor_controller.h"
+#include "spsc_mailbox.h"
+#include "telemetry.h"
+
+struct CommandResult {
+	MotorCommand command;
+	MotorController::Status status = MotorController::Status::Ok;
+	MotorController::State state; // motor state right after the command
+};
+
+struct LoopStats {
+	int rateHz = 0;
+	bool realtimePriority = false;
+	uint64_t ticks = 0;
+	uint64_t missedDeadlines = 0; // ticks that could not start before the following deadline
+	uint64_t commands = 0;
+	double meanJitterUs = 0;      // wake-up lateness relative to the deadline
+	int64_t p99JitterUs = 0;      // upper bound of the bucket holding the 99th percentile
+	int64_t maxJitterUs = 0;
+};
+
+class ControlLoop {
+public:
+	static constexpr int kMinRateHz = 1000;
+	static constexpr int kMaxRateHz = 10000;
+
+	explicit ControlLoop(MotorController& motor, int rateHz = kMinRateHz)
+		: motor_(motor), rateHz_(std::clamp(rateHz, kMinRateHz, kMaxRateHz)), dt_(1.0 / rateHz_)
+	{
+		publish(motor_.state());
+	}
+
+	~ControlLoop() { stop(); }
+
+	ControlLoop(const ControlLoop&) = delete;
+	ControlLoop& operator=(const ControlLoop&) = delete;
+
+	void start()
+	{
+		if (thread_.joinable()) {
+			return;
+		}
+		running_.store(true, std::memory_order_relaxed);
+		thread_ = std::thread(&ControlLoop::run, this);
+	}
+
+	void stop()
+	{
+		running_.store(false, std::memory_order_relaxed);
+		if (thread_.joinable()) {
+			thread_.join();
+		}
+	}
+
+	// Records the motor every tick it changes and every recorder.sampleEvery ticks otherwise, from the loop thread.
+	// Attach before start(); the recorder must outlive the loop.
+	void attachRecorder(TelemetryRecorder* recorder) { recorder_ = recorder; }
+
+	// Producer side of the command mailbox: call from a single thread (the menu). False when full.
+	bool post(const MotorCommand& command) { return commands_.push(command); }
+
+	// Consumer side of the result mailbox: call from the same thread that posts.
+	bool takeResult(CommandResult& result) { return results_.pop(result); }
+
+	// Latest published state, safe to read from any thread.
+	MotorController::State snapshot() const { return unpack(packedState_.load(std::memory_order_acquire)); }
+
+	LoopStats stats() const
+	{
+		LoopStats s;
+		s.rateHz = rateHz_;
+		s.realtimePriority = realtime_.load(std::memory_order_relaxed);
+		s.ticks = ticks_.load(std::memory_order_relaxed);
+		s.missedDeadlines = missed_.load(std::memory_order_relaxed);
+		s.commands = commandCount_.load(std::memory_order_relaxed);
+		s.maxJitterUs = maxJitterUs_.load(std::memory_order_relaxed);
+		s.meanJitterUs = s.ticks ? (double)jitterSumUs_.load(std::memory_order_relaxed) / s.ticks : 0.0;
+		const uint64_t rank = s.ticks - s.ticks / 100;
+		uint64_t seen = 0;
+		for (int i = 0; i < kBuckets; ++i) {
+			seen += jitterBuckets_[i].load(std::memory_order_relaxed);
+			if (seen >= rank) {
+				s.p99JitterUs = std::min<int64_t>(int64_t(1) << i, s.maxJitterUs);
+				break;
+			}
+		}
+		return s;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+	static constexpr int kBuckets = 32; // bucket i counts lateness in [2^(i-1), 2^i) microseconds
+
+	// The OS sleep is coarse, so sleep until shortly before the deadline and spin the rest of the way.
+	// Windows timers tick at ~1 ms or worse, so there the loop spins for the whole period.
+#ifdef _WIN32
+	static constexpr std::chrono::microseconds kSpinMargin{2000};
+#else
+	static constexpr std::chrono::microseconds kSpinMargin{100};
+#endif
+
+	static uint64_t pack(const MotorController::State& s)
+	{
+		return (uint64_t)(uint8_t)s.speed | (uint64_t)(uint8_t)s.speedLimit << 8 | (uint64_t)s.poweredOn << 16
+			| (uint64_t)s.isSpeedLimited << 17 | (uint64_t)(s.direction == MotorController::Direction::CounterClockwise) << 18
+			| (uint64_t)(s.targetDirection == MotorController::Direction::CounterClockwise) << 19
+			| (uint64_t)(uint8_t)s.targetSpeed << 24;
+	}
+
+	static MotorController::State unpack(uint64_t v)
+	{
+		MotorController::State s;
+		s.speed = (int)(v & 0xFF);
+		s.speedLimit = (int)(v >> 8 & 0xFF);
+		s.poweredOn = (v >> 16 & 1) != 0;
+		s.isSpeedLimited = (v >> 17 & 1) != 0;
+		s.direction = (v >> 18 & 1) ? MotorController::Direction::CounterClockwise : MotorController::Direction::Clockwise;
+		s.targetDirection = (v >> 19 & 1) ? MotorController::Direction::CounterClockwise : MotorController::Direction::Clockwise;
+		s.targetSpeed = (int)(v >> 24 & 0xFF);
+		return s;
+	}
+
+	void publish(const MotorController::State& s) { packedState_.store(pack(s), std::memory_order_release); }
+
+	bool raisePriority()
+	{
+#ifdef _WIN32
+		return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+		// SCHED_FIFO needs CAP_SYS_NICE (or root); without it the loop still runs, just with more jitter
+		sched_param param{};
+		param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
+		return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+	}
+
+	void run()
+	{
+		realtime_.store(raisePriority(), std::memory_order_relaxed);
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / rateHz_;
+		// at 10 kHz still hand the core back for half of every period
+		const auto spin = std::min<Clock::duration>(kSpinMargin, period / 2);
+		auto deadline = Clock::now() + period;
+		while (running_.load(std::memory_order_relaxed)) {
+			std::this_thread::sleep_until(deadline - spin);
+			Clock::time_point now = Clock::now();
+			while (now < deadline) {
+				now = Clock::now();
+			}
+			record(std::chrono::duration_cast<std::chrono::microseconds>(now - deadline).count());
+
+			tick(now);
+
+			// Next deadline stays on the original grid; if the tick overran, skip the slots it ate
+			// instead of firing a burst of catch-up ticks.
+			deadline += period;
+			now = Clock::now();
+			if (now >= deadline) {
+				const int64_t behind = (now - deadline) / period + 1;
+				missed_.fetch_add((uint64_t)behind, std::memory_order_relaxed);
+				overrun_ = true;
+				deadline += period * behind;
+			}
+		}
+	}
+
+	void tick(Clock::time_point now)
+	{
+		uint16_t events = 0;
+		MotorCommand command;
+		while (commands_.pop(command)) {
+			CommandResult result;
+			result.command = command;
+			result.status = motor_.apply(command);
+			result.state = motor_.state();
+			results_.push(result); // menu not draining: drop the reply, the command itself was applied
+			commandCount_.fetch_add(1, std::memory_order_relaxed);
+			events |= telemetryEventFor(command.type, result.status);
+		}
+		if (!recorder_) {
+			motor_.advance(dt_);
+			publish(motor_.state());
+			return;
+		}
+
+		const bool wasRamping = motor_.isRamping();
+		const MotorController::Direction wasDirection = motor_.getDirection();
+		motor_.advance(dt_);
+		const MotorController::State state = motor_.state();
+		publish(state);
+		if (wasRamping && !motor_.isRamping()) {
+			events |= kEventRampDone;
+		}
+		if (state.direction != wasDirection) {
+			events |= kEventReversal;
+		}
+		if (overrun_) {
+			events |= kEventOverrun;
+			overrun_ = false;
+		}
+		if (recorder_->shouldSample(tickIndex_++, events)) {
+			recorder_->record(motor_, events, recorder_->nowNs(now));
+		}
+	}
+
+	void record(int64_t lateUs)
+	{
+		lateUs = std::max<int64_t>(lateUs, 0);
+		int bucket = 0;
+		while (bucket < kBuckets - 1 && (int64_t(1) << bucket) <= lateUs) {
+			++bucket;
+		}
+		// Only this thread writes; relaxed stores are enough for the menu to read approximate stats
+		jitterBuckets_[bucket].store(jitterBuckets_[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		jitterSumUs_.store(jitterSumUs_.load(std::memory_order_relaxed) + lateUs, std::memory_order_relaxed);
+		if (lateUs > maxJitterUs_.load(std::memory_order_relaxed)) {
+			maxJitterUs_.store(lateUs, std::memory_order_relaxed);
+		}
+		ticks_.store(ticks_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	MotorController& motor_;
+	const int rateHz_;
+	const double dt_; // ramp time per tick; missed slots are not replayed, so a late loop ramps slower
+	TelemetryRecorder* recorder_ = nullptr;
+	uint64_t tickIndex_ = 0; // loop thread only
+	bool overrun_ = false;   // loop thread only
+	std::thread thread_;
+	std::atomic<bool> running_{false};
+	std::atomic<bool> realtime_{false};
+
+	SpscMailbox<MotorCommand, 64> commands_;
+	SpscMailbox<CommandResult, 64> results_;
+	std::atomic<uint64_t> packedState_{0};
+
+	std::atomic<uint64_t> ticks_{0};
+	std::atomic<uint64_t> missed_{0};
+	std::atomic<uint64_t> commandCount_{0};
+	std::atomic<int64_t> jitterSumUs_{0};
+	std::atomic<int64_t> maxJitterUs_{0};
+	std::atomic<uint64_t> jitterBuckets_[kBuckets] = {};
+};
@@ -0,0 +1,104 @@
+// Fleet simulation benchmark: N motors ramping under a steady stream of commands, ticks per second with the
+// SSE2 path and with the scalar path.
+//   fleet_bench [motors ...] [-s seconds]     (default: 10000 30000 100000 motors, 1 s each)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fleet_controller.h"
+
+namespace {
+constexpr float kTickSeconds = 0.001f; // simulated time per tick (1 kHz control loop)
+constexpr int kBlock = 256;            // motors per batched command
+
+struct Result {
+	double ticksPerSecond = 0;
+	uint64_t ticks = 0;
+	double checksum = 0; // sum of signed speeds at the end; identical for both paths when they agree
+};
+
+// Every tick: a few individual commands at random motors, and every 50 ticks a batched speed / direction /
+// limit change for one block of motors, so a good share of the fleet is always mid-ramp.
+// Runs for `seconds`, or for exactly `ticks` ticks when that is non-zero.
+Result simulate(std::size_t motors, bool simd, double seconds, uint64_t ticks = 0)
+{
+	FleetController fleet(motors);
+	fleet.setSimdEnabled(simd);
+	fleet.powerOnRange(0, motors);
+	fleet.setSpeedRange(0, motors, 50);
+
+	std::mt19937 rng(42);
+	const std::size_t perTick = motors / 1000 + 1;
+	std::vector<FleetCommand> commands(perTick);
+	std::vector<MotorStatus> statuses(perTick);
+
+	using Clock = std::chrono::steady_clock;
+	const auto begin = Clock::now();
+	const auto stop = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	Result r;
+	while (ticks ? r.ticks < ticks : Clock::now() < stop) {
+		for (int batch = 0; batch < 64; ++batch, ++r.ticks) {
+			for (FleetCommand& c : commands) {
+				c.motor = (uint32_t)(rng() % motors);
+				c.command.type = MotorCommand::Type::SetSpeed;
+				c.command.value = (int)(rng() % (kMaxSpeed + 1));
+			}
+			fleet.apply(commands.data(), commands.size(), statuses.data());
+			if (r.ticks % 50 == 0) {
+				const std::size_t first = (rng() % (motors / kBlock + 1)) * kBlock;
+				switch (rng() % 4) {
+				case 0:
+					fleet.setSpeedRange(first, kBlock, (int)(rng() % (kMaxSpeed + 1)));
+					break;
+				case 1:
+					fleet.setDirectionRange(first, kBlock, (rng() & 1) ? MotorDirection::Clockwise : MotorDirection::CounterClockwise);
+					break;
+				case 2:
+					fleet.setSpeedLimitRange(first, kBlock, 20 + (int)(rng() % 60));
+					break;
+				default:
+					fleet.clearSpeedLimitRange(first, kBlock);
+					break;
+				}
+			}
+			fleet.tick(kTickSeconds);
+		}
+	}
+	r.ticksPerSecond = r.ticks / std::chrono::duration<double>(Clock::now() - begin).count();
+	for (std::size_t i = 0; i < motors; ++i) {
+		r.checksum += fleet.speedValue(i);
+	}
+	return r;
+}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::size_t> sizes;
+	double seconds = 1.0;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seconds = std::atof(argv[++i]);
+		} else if (std::atol(argv[i]) > 0) {
+			sizes.push_back((std::size_t)std::atol(argv[i]));
+		}
+	}
+	if (sizes.empty()) {
+		sizes = {10000, 30000, 100000};
+	}
+
+	std::printf("每个规模各跑 %.1f 秒，每周期模拟 %.0f ms%s\n", seconds, kTickSeconds * 1000.0,
+			MOTOR_FLEET_SSE2 ? "" : "（编译目标不支持 SSE2，两列都是标量）");
+	std::printf("%10s %14s %14s %10s %16s  %s\n", "电机数", "SSE2 周期/s", "标量 周期/s", "加速", "电机更新/s", "1 kHz 余量");
+	for (std::size_t motors : sizes) {
+		const Result simd = simulate(motors, true, seconds);
+		const Result scalar = simulate(motors, false, seconds, simd.ticks); // same command stream, so same result
+		std::printf("%10zu %14.0f %14.0f %9.2fx %15.1fM  %.1fx%s\n", motors, simd.ticksPerSecond, scalar.ticksPerSecond,
+				simd.ticksPerSecond / scalar.ticksPerSecond, simd.ticksPerSecond * motors / 1e6, simd.ticksPerSecond / 1000.0,
+				simd.checksum != scalar.checksum ? "  (两条路径结果不同!)" : "");
+	}
+	return 0;
+}
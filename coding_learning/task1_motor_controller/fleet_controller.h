@@ -0,0 +1,605 @@
+// Many motors in one object. Every field lives in its own array (structure-of-arrays), so the per-tick ramp step,
+// the limit clamp and batched commands walk contiguous floats and run four motors per SSE2 instruction.
+// Per-motor commands follow exactly the rules of the single-motor menu; MotorController is a view on one slot.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOTOR_FLEET_SSE2 1
+#include <emmintrin.h>
+#else
+#define MOTOR_FLEET_SSE2 0
+#endif
+
+#include "ramp_profile.h"
+
+constexpr int kMinSpeed = 0;
+constexpr int kMaxSpeed = 100;
+
+enum class MotorDirection { Clockwise = 1, CounterClockwise = -1 };
+
+enum class MotorStatus {
+	Ok,
+	AlreadyOn,
+	AlreadyOff,
+	NotPowered,
+	SpeedOutOfRange,
+	LimitOutOfRange,
+	LimitClampedSpeed, // limit accepted and the current speed was lowered to it
+	NoLimit,
+};
+
+struct MotorState {
+	bool poweredOn = false;
+	int speed = 0;                                     // actual speed, follows the ramp
+	MotorDirection direction = MotorDirection::Clockwise; // actual rotation (kept while stopped)
+	int targetSpeed = 0;
+	MotorDirection targetDirection = MotorDirection::Clockwise;
+	bool isSpeedLimited = false;
+	int speedLimit = kMaxSpeed;
+};
+
+struct MotorCommand {
+	enum class Type : uint8_t { PowerOn, PowerOff, SetSpeed, SetDirection, ToggleDirection, SetSpeedLimit, ClearSpeedLimit };
+
+	Type type = Type::PowerOn;
+	int value = 0; // speed, limit, or direction (1 / -1) depending on type
+};
+
+struct FleetCommand {
+	uint32_t motor = 0;
+	MotorCommand command;
+};
+
+class FleetController {
+public:
+	explicit FleetController(std::size_t count, const RampLimits& limits = RampLimits())
+		: size_(count), limits_(limits)
+	{
+		const std::size_t lanes = (count + 3) & ~std::size_t(3); // whole SSE vectors, the padding stays idle
+		for (std::vector<float>* field : floatFields()) {
+			field->assign(lanes, 0.0f);
+		}
+		limit_.assign(lanes, (float)kMaxSpeed);
+		dir_.assign(lanes, 1.0f);
+		targetDir_.assign(lanes, 1.0f);
+		targetSpeed_.assign(lanes, 0);
+		speedLimit_.assign(lanes, (uint8_t)kMaxSpeed);
+		flags_.assign(lanes, 0);
+		pending_.assign(lanes, 0);
+	}
+
+	std::size_t size() const { return size_; }
+
+	// --- one motor ---
+
+	MotorStatus powerOn(std::size_t i)
+	{
+		if (flags_[i] & kPowered) {
+			return MotorStatus::AlreadyOn;
+		}
+		flags_[i] |= kPowered;
+		return MotorStatus::Ok;
+	}
+
+	// Cutting power stops immediately; there is nothing to ramp with.
+	MotorStatus powerOff(std::size_t i)
+	{
+		if (!(flags_[i] & kPowered)) {
+			return MotorStatus::AlreadyOff;
+		}
+		flags_[i] &= ~kPowered;
+		targetSpeed_[i] = 0;
+		value_[i] = target_[i] = 0;
+		storePlan(i, RampPlan());
+		return MotorStatus::Ok;
+	}
+
+	MotorStatus setSpeed(std::size_t i, int speed)
+	{
+		if (!(flags_[i] & kPowered)) {
+			return MotorStatus::NotPowered;
+		}
+		if (speed < kMinSpeed || speed > speedLimit_[i]) {
+			return MotorStatus::SpeedOutOfRange;
+		}
+		targetSpeed_[i] = (uint8_t)speed;
+		replan(i);
+		return MotorStatus::Ok;
+	}
+
+	// A reversal ramps through zero: the signed setpoint crosses 0 and the actual direction flips there.
+	MotorStatus setDirection(std::size_t i, MotorDirection dir)
+	{
+		if (!(flags_[i] & kPowered)) {
+			return MotorStatus::NotPowered;
+		}
+		targetDir_[i] = (float)static_cast<int>(dir);
+		replan(i);
+		return MotorStatus::Ok;
+	}
+
+	MotorStatus toggleDirection(std::size_t i)
+	{
+		return setDirection(i, targetDir_[i] > 0 ? MotorDirection::CounterClockwise : MotorDirection::Clockwise);
+	}
+
+	// Lowers the target, and if the motor is already above the new limit it is clamped right away, even mid-ramp.
+	MotorStatus setSpeedLimit(std::size_t i, int limit)
+	{
+		if (limit < kMinSpeed || limit > kMaxSpeed) {
+			return MotorStatus::LimitOutOfRange;
+		}
+		setLimitFields(i, limit);
+		const float l = (float)limit;
+		if (!(flags_[i] & kPowered) || (targetSpeed_[i] <= limit && std::fabs(value_[i]) <= l)) {
+			return MotorStatus::Ok;
+		}
+		value_[i] = std::max(-l, std::min(l, value_[i]));
+		targetSpeed_[i] = (uint8_t)std::min<int>(targetSpeed_[i], limit);
+		replan(i);
+		return MotorStatus::LimitClampedSpeed;
+	}
+
+	MotorStatus clearSpeedLimit(std::size_t i)
+	{
+		if (!(flags_[i] & kLimited)) {
+			return MotorStatus::NoLimit;
+		}
+		flags_[i] &= ~kLimited;
+		speedLimit_[i] = (uint8_t)kMaxSpeed;
+		limit_[i] = (float)kMaxSpeed;
+		return MotorStatus::Ok;
+	}
+
+	MotorStatus apply(std::size_t i, const MotorCommand& command)
+	{
+		switch (command.type) {
+		case MotorCommand::Type::PowerOn:
+			return powerOn(i);
+		case MotorCommand::Type::PowerOff:
+			return powerOff(i);
+		case MotorCommand::Type::SetSpeed:
+			return setSpeed(i, command.value);
+		case MotorCommand::Type::SetDirection:
+			return setDirection(i, command.value < 0 ? MotorDirection::CounterClockwise : MotorDirection::Clockwise);
+		case MotorCommand::Type::ToggleDirection:
+			return toggleDirection(i);
+		case MotorCommand::Type::SetSpeedLimit:
+			return setSpeedLimit(i, command.value);
+		case MotorCommand::Type::ClearSpeedLimit:
+			return clearSpeedLimit(i);
+		}
+		return MotorStatus::Ok;
+	}
+
+	// Mixed commands for arbitrary motors; statuses (optional) receives one result per command.
+	void apply(const FleetCommand* commands, std::size_t count, MotorStatus* statuses = nullptr)
+	{
+		for (std::size_t k = 0; k < count; ++k) {
+			const MotorStatus status = apply(commands[k].motor, commands[k].command);
+			if (statuses) {
+				statuses[k] = status;
+			}
+		}
+	}
+
+	// --- the same command on motors [first, first + count) ---
+	// Validation stays per motor, the ramp planning and clamping run vectorised. Each returns how many motors the
+	// command took effect on (for setSpeedLimitRange: how many had their speed lowered).
+
+	std::size_t powerOnRange(std::size_t first, std::size_t count)
+	{
+		std::size_t changed = 0;
+		for (std::size_t i = first, end = rangeEnd(first, count); i < end; ++i) {
+			changed += (flags_[i] & kPowered) == 0;
+			flags_[i] |= kPowered;
+		}
+		return changed;
+	}
+
+	std::size_t powerOffRange(std::size_t first, std::size_t count)
+	{
+		std::size_t changed = 0;
+		for (std::size_t i = first, end = rangeEnd(first, count); i < end; ++i) {
+			changed += powerOff(i) == MotorStatus::Ok;
+		}
+		return changed;
+	}
+
+	std::size_t setSpeedRange(std::size_t first, std::size_t count, int speed)
+	{
+		if (speed < kMinSpeed || speed > kMaxSpeed) {
+			return 0;
+		}
+		std::size_t accepted = 0;
+		const std::size_t end = rangeEnd(first, count);
+		for (std::size_t i = first; i < end; ++i) {
+			const bool ok = (flags_[i] & kPowered) && speed <= speedLimit_[i];
+			if (ok) {
+				targetSpeed_[i] = (uint8_t)speed;
+				target_[i] = speed * targetDir_[i];
+			}
+			pending_[i] = ok;
+			accepted += ok;
+		}
+		planPending(first, end);
+		return accepted;
+	}
+
+	std::size_t setDirectionRange(std::size_t first, std::size_t count, MotorDirection dir)
+	{
+		const float sign = (float)static_cast<int>(dir);
+		std::size_t accepted = 0;
+		const std::size_t end = rangeEnd(first, count);
+		for (std::size_t i = first; i < end; ++i) {
+			const bool ok = (flags_[i] & kPowered) != 0;
+			if (ok) {
+				targetDir_[i] = sign;
+				target_[i] = targetSpeed_[i] * sign;
+			}
+			pending_[i] = ok;
+			accepted += ok;
+		}
+		planPending(first, end);
+		return accepted;
+	}
+
+	std::size_t setSpeedLimitRange(std::size_t first, std::size_t count, int limit)
+	{
+		if (limit < kMinSpeed || limit > kMaxSpeed) {
+			return 0;
+		}
+		const std::size_t end = rangeEnd(first, count);
+		for (std::size_t i = first; i < end; ++i) {
+			setLimitFields(i, limit);
+			targetSpeed_[i] = (uint8_t)std::min<int>(targetSpeed_[i], limit);
+		}
+		std::size_t i = first;
+		if (simd_) {
+			i = clampSse2(first, end, (float)limit);
+		}
+		clampScalar(i, end, (float)limit);
+		std::size_t clamped = 0;
+		for (i = first; i < end; ++i) {
+			clamped += pending_[i];
+		}
+		planPending(first, end);
+		return clamped;
+	}
+
+	std::size_t clearSpeedLimitRange(std::size_t first, std::size_t count)
+	{
+		std::size_t changed = 0;
+		for (std::size_t i = first, end = rangeEnd(first, count); i < end; ++i) {
+			changed += clearSpeedLimit(i) == MotorStatus::Ok;
+		}
+		return changed;
+	}
+
+	// Changing the limits re-plans every move in flight from where it currently is.
+	void setRampLimits(const RampLimits& limits)
+	{
+		limits_ = limits;
+		std::fill(pending_.begin(), pending_.begin() + size_, uint8_t(1));
+		planPending(0, size_);
+	}
+
+	const RampLimits& rampLimits() const { return limits_; }
+
+	// --- control tick ---
+
+	// Moves every motor dt seconds along its ramp and clamps it to its limit. O(motors), no allocation.
+	void tick(float dt)
+	{
+		std::size_t i = 0;
+		if (simd_) {
+			i = tickSse2(dt);
+		}
+		tickScalar(i, value_.size(), dt);
+	}
+
+	MotorState state(std::size_t i) const
+	{
+		MotorState s;
+		s.poweredOn = (flags_[i] & kPowered) != 0;
+		s.speed = (int)std::lround(std::fabs(value_[i]));
+		s.direction = dir_[i] > 0 ? MotorDirection::Clockwise : MotorDirection::CounterClockwise;
+		s.targetSpeed = targetSpeed_[i];
+		s.targetDirection = targetDir_[i] > 0 ? MotorDirection::Clockwise : MotorDirection::CounterClockwise;
+		s.isSpeedLimited = (flags_[i] & kLimited) != 0;
+		s.speedLimit = speedLimit_[i];
+		return s;
+	}
+
+	float speedValue(std::size_t i) const { return value_[i]; } // signed, unrounded
+	float targetValue(std::size_t i) const { return target_[i]; }
+	bool isRamping(std::size_t i) const { return time_[i] < duration_[i]; }
+	float rampRemaining(std::size_t i) const { return duration_[i] - time_[i]; }
+	int maxAllowedSpeed(std::size_t i) const { return speedLimit_[i]; }
+
+	// The SSE2 paths are on whenever the compiler targets SSE2; switching them off is for benchmarks only.
+	void setSimdEnabled(bool enabled) { simd_ = enabled && MOTOR_FLEET_SSE2; }
+	bool simdEnabled() const { return simd_; }
+
+private:
+	static constexpr uint8_t kPowered = 1;
+	static constexpr uint8_t kLimited = 2;
+
+	std::vector<std::vector<float>*> floatFields()
+	{
+		return {&value_, &target_, &time_, &duration_, &t1_, &t2_, &v0_[0], &v0_[1], &v0_[2], &a0_[0], &a0_[1],
+				&a0_[2], &jerk_[0], &jerk_[1], &jerk_[2], &limit_, &dir_, &targetDir_};
+	}
+
+	std::size_t rangeEnd(std::size_t first, std::size_t count) const
+	{
+		return first >= size_ ? first : first + std::min(count, size_ - first);
+	}
+
+	void setLimitFields(std::size_t i, int limit)
+	{
+		flags_[i] |= kLimited;
+		speedLimit_[i] = (uint8_t)limit;
+		limit_[i] = (float)limit;
+	}
+
+	void storePlan(std::size_t i, const RampPlan& p)
+	{
+		time_[i] = 0;
+		duration_[i] = p.duration;
+		t1_[i] = p.t1;
+		t2_[i] = p.t2;
+		for (int k = 0; k < 3; ++k) {
+			v0_[k][i] = p.v0[k];
+			a0_[k][i] = p.a0[k];
+			jerk_[k][i] = p.jerk[k];
+		}
+	}
+
+	// A move that needs no time lands at once; a stopped motor takes the commanded direction right away.
+	void settle(std::size_t i)
+	{
+		if (duration_[i] <= 0) {
+			value_[i] = target_[i];
+		}
+		if (value_[i] != 0) {
+			dir_[i] = value_[i] > 0 ? 1.0f : -1.0f;
+		} else if (time_[i] >= duration_[i]) {
+			dir_[i] = targetDir_[i];
+		}
+	}
+
+	void replan(std::size_t i)
+	{
+		target_[i] = targetSpeed_[i] * targetDir_[i];
+		storePlan(i, planRamp(value_[i], target_[i], limits_));
+		settle(i);
+	}
+
+	// Re-plans every motor in [first, end) whose pending_ flag is set, then clears the flags.
+	void planPending(std::size_t first, std::size_t end)
+	{
+		std::size_t i = first;
+		if (simd_) {
+			i = planSse2(first, end);
+		}
+		for (; i < end; ++i) {
+			if (pending_[i]) {
+				storePlan(i, planRamp(value_[i], target_[i], limits_));
+			}
+		}
+		for (i = first; i < end; ++i) {
+			if (pending_[i]) {
+				settle(i);
+				pending_[i] = 0;
+			}
+		}
+	}
+
+	// Pulls value and target into [-limit, limit]; motors whose speed or target changed are marked pending.
+	void clampScalar(std::size_t i, std::size_t end, float limit)
+	{
+		for (; i < end; ++i) {
+			const float v = std::max(-limit, std::min(limit, value_[i]));
+			const float t = std::max(-limit, std::min(limit, target_[i]));
+			pending_[i] = v != value_[i];
+			if (t != target_[i]) {
+				pending_[i] = 1;
+			}
+			value_[i] = v;
+			target_[i] = t;
+		}
+	}
+
+	void tickScalar(std::size_t i, std::size_t end, float dt)
+	{
+		for (; i < end; ++i) {
+			const float t = std::min(time_[i] + dt, duration_[i]);
+			time_[i] = t;
+			RampPlan p;
+			p.t1 = t1_[i];
+			p.t2 = t2_[i];
+			p.duration = duration_[i];
+			p.target = target_[i];
+			for (int k = 0; k < 3; ++k) {
+				p.v0[k] = v0_[k][i];
+				p.a0[k] = a0_[k][i];
+				p.jerk[k] = jerk_[k][i];
+			}
+			const float v = std::max(-limit_[i], std::min(limit_[i], evalRamp(p, t)));
+			value_[i] = v;
+			if (v != 0) {
+				dir_[i] = v > 0 ? 1.0f : -1.0f;
+			} else if (t >= duration_[i]) {
+				dir_[i] = targetDir_[i];
+			}
+		}
+	}
+
+#if MOTOR_FLEET_SSE2
+	static __m128 select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+	// pending_ bytes of four motors -> all-ones lanes
+	__m128 pendingMask(std::size_t i) const
+	{
+		int32_t bytes;
+		std::memcpy(&bytes, &pending_[i], sizeof(bytes));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+		return _mm_castsi128_ps(_mm_cmpgt_epi32(wide, zero));
+	}
+
+	void storeMasked(std::vector<float>& field, std::size_t i, __m128 mask, __m128 value)
+	{
+		_mm_storeu_ps(&field[i], select(mask, value, _mm_loadu_ps(&field[i])));
+	}
+
+	// planRamp() for four motors at once, written back only where pending_ is set.
+	std::size_t planSse2(std::size_t i, std::size_t end)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 a = _mm_set1_ps(limits_.maxAccel);
+		const __m128 j = _mm_set1_ps(limits_.maxJerk);
+		const bool instant = limits_.maxAccel <= 0;
+		const bool trapezoid = limits_.maxJerk <= 0;
+		for (; i + 4 <= end; i += 4) {
+			const __m128 pending = pendingMask(i);
+			if (_mm_movemask_ps(pending) == 0) {
+				continue;
+			}
+			const __m128 from = _mm_loadu_ps(&value_[i]);
+			const __m128 target = _mm_loadu_ps(&target_[i]);
+			const __m128 dv = _mm_sub_ps(target, from);
+			const __m128 s = _mm_or_ps(one, _mm_and_ps(dv, signBit));
+			const __m128 size = _mm_andnot_ps(signBit, dv);
+			const __m128 moving = instant ? zero : _mm_cmpneq_ps(size, zero);
+
+			__m128 t1, t2, duration, v1 = zero, v2 = zero, a0 = zero, a12 = zero, j0 = zero, j2 = zero;
+			if (trapezoid) {
+				duration = t1 = t2 = _mm_div_ps(size, a);
+				a0 = _mm_mul_ps(s, a);
+			} else {
+				const __m128 peak = _mm_min_ps(a, _mm_sqrt_ps(_mm_mul_ps(size, j)));
+				const __m128 tj = _mm_div_ps(peak, j);
+				const __m128 tc = _mm_max_ps(_mm_sub_ps(_mm_div_ps(size, peak), tj), zero);
+				const __m128 offset = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(s, peak), tj), half);
+				t1 = tj;
+				t2 = _mm_add_ps(tj, tc);
+				duration = _mm_add_ps(t2, tj);
+				v1 = _mm_add_ps(from, offset);
+				v2 = _mm_sub_ps(target, offset);
+				a12 = _mm_mul_ps(s, peak);
+				j0 = _mm_mul_ps(s, j);
+				j2 = _mm_mul_ps(_mm_xor_ps(s, signBit), j);
+			}
+			// motors that are already at their target get the all-zero plan, like planRamp()
+			storeMasked(time_, i, pending, zero);
+			storeMasked(duration_, i, pending, _mm_and_ps(moving, duration));
+			storeMasked(t1_, i, pending, _mm_and_ps(moving, t1));
+			storeMasked(t2_, i, pending, _mm_and_ps(moving, t2));
+			storeMasked(v0_[0], i, pending, _mm_and_ps(moving, from));
+			storeMasked(v0_[1], i, pending, _mm_and_ps(moving, v1));
+			storeMasked(v0_[2], i, pending, _mm_and_ps(moving, v2));
+			storeMasked(a0_[0], i, pending, _mm_and_ps(moving, a0));
+			storeMasked(a0_[1], i, pending, _mm_and_ps(moving, a12));
+			storeMasked(a0_[2], i, pending, _mm_and_ps(moving, a12));
+			storeMasked(jerk_[0], i, pending, _mm_and_ps(moving, j0));
+			storeMasked(jerk_[1], i, pending, zero);
+			storeMasked(jerk_[2], i, pending, _mm_and_ps(moving, j2));
+		}
+		return i;
+	}
+
+	std::size_t clampSse2(std::size_t i, std::size_t end, float limit)
+	{
+		const __m128 hi = _mm_set1_ps(limit);
+		const __m128 lo = _mm_set1_ps(-limit);
+		for (; i + 4 <= end; i += 4) {
+			const __m128 value = _mm_loadu_ps(&value_[i]);
+			const __m128 target = _mm_loadu_ps(&target_[i]);
+			const __m128 v = _mm_max_ps(lo, _mm_min_ps(hi, value));
+			const __m128 t = _mm_max_ps(lo, _mm_min_ps(hi, target));
+			const int changed = _mm_movemask_ps(_mm_or_ps(_mm_cmpneq_ps(v, value), _mm_cmpneq_ps(t, target)));
+			_mm_storeu_ps(&value_[i], v);
+			_mm_storeu_ps(&target_[i], t);
+			for (int k = 0; k < 4; ++k) {
+				pending_[i + k] = (changed >> k) & 1;
+			}
+		}
+		return i;
+	}
+
+	// tickScalar() for four motors at once; value_ has padded length so the whole array is covered.
+	std::size_t tickSse2(float dt)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 step = _mm_set1_ps(dt);
+		const std::size_t end = value_.size();
+		std::size_t i = 0;
+		for (; i + 4 <= end; i += 4) {
+			const __m128 duration = _mm_loadu_ps(&duration_[i]);
+			const __m128 t = _mm_min_ps(_mm_add_ps(_mm_loadu_ps(&time_[i]), step), duration);
+			_mm_storeu_ps(&time_[i], t);
+
+			const __m128 t1 = _mm_loadu_ps(&t1_[i]);
+			const __m128 t2 = _mm_loadu_ps(&t2_[i]);
+			const __m128 in1 = _mm_cmpge_ps(t, t1);
+			const __m128 in2 = _mm_cmpge_ps(t, t2);
+			const __m128 t0 = select(in2, t2, _mm_and_ps(in1, t1));
+			const __m128 v0 = select(in2, _mm_loadu_ps(&v0_[2][i]), select(in1, _mm_loadu_ps(&v0_[1][i]), _mm_loadu_ps(&v0_[0][i])));
+			const __m128 a0 = select(in2, _mm_loadu_ps(&a0_[2][i]), select(in1, _mm_loadu_ps(&a0_[1][i]), _mm_loadu_ps(&a0_[0][i])));
+			const __m128 jk = select(in2, _mm_loadu_ps(&jerk_[2][i]), select(in1, _mm_loadu_ps(&jerk_[1][i]), _mm_loadu_ps(&jerk_[0][i])));
+			const __m128 u = _mm_sub_ps(t, t0);
+			__m128 v = _mm_add_ps(v0, _mm_mul_ps(u, _mm_add_ps(a0, _mm_mul_ps(_mm_mul_ps(half, jk), u))));
+			const __m128 done = _mm_cmpge_ps(t, duration);
+			v = select(done, _mm_loadu_ps(&target_[i]), v);
+
+			const __m128 limit = _mm_loadu_ps(&limit_[i]);
+			v = _mm_max_ps(_mm_xor_ps(limit, signBit), _mm_min_ps(limit, v));
+			_mm_storeu_ps(&value_[i], v);
+
+			// direction: sign of the speed, or the commanded one once stopped at the end of a move
+			const __m128 nonZero = _mm_cmpneq_ps(v, zero);
+			const __m128 sign = _mm_or_ps(one, _mm_and_ps(v, signBit));
+			const __m128 dir = select(nonZero, sign, select(done, _mm_loadu_ps(&targetDir_[i]), _mm_loadu_ps(&dir_[i])));
+			_mm_storeu_ps(&dir_[i], dir);
+		}
+		return i;
+	}
+#else
+	std::size_t planSse2(std::size_t i, std::size_t) { return i; }
+	std::size_t clampSse2(std::size_t i, std::size_t, float) { return i; }
+	std::size_t tickSse2(float) { return 0; }
+#endif
+
+	std::size_t size_;
+	RampLimits limits_;
+	bool simd_ = MOTOR_FLEET_SSE2;
+
+	// ramp state, signed speed units
+	std::vector<float> value_;    // actual
+	std::vector<float> target_;   // targetSpeed_ * targetDir_, limit applied
+	std::vector<float> time_;     // time into the current move
+	std::vector<float> duration_;
+	std::vector<float> t1_, t2_;
+	std::vector<float> v0_[3], a0_[3], jerk_[3];
+
+	std::vector<float> limit_;    // speedLimit_ as float for the clamp
+	std::vector<float> dir_;      // actual direction, +1 / -1
+	std::vector<float> targetDir_;
+	std::vector<uint8_t> targetSpeed_;
+	std::vector<uint8_t> speedLimit_;
+	std::vector<uint8_t> flags_;
+	std::vector<uint8_t> pending_; // scratch: motors a batched command needs to re-plan
+};
@@ -1,8 +1,13 @@
 // Motor controller demo that offers an interactive menu to manage speed and direction.
+#include <chrono>
 #include <clocale>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <string>
+#include <thread>
 #ifdef _WIN32
 #ifndef NOMINMAX
 #define NOMINMAX
@@ -10,11 +15,13 @@
 #include <windows.h>
 #endif
 
+#include "control_loop.h"
+#include "motor_controller.h"
+#include "telemetry.h"
+
 namespace {
-constexpr int kMinSpeed = 0;
-constexpr int kMaxSpeed = 100;
 constexpr int kMenuMin = 0;
-constexpr int kMenuMax = 6;
+constexpr int kMenuMax = 7;
 constexpr int kCruiseSpeed = 60;
 
 #ifdef _WIN32
@@ -28,114 +35,6 @@ constexpr const char* kAnsiGreen = "\x1b[32m";
 constexpr const char* kAnsiReset = "\x1b[0m";
 }
 
-class MotorController {
-public:
-	enum class Direction { Clockwise = 1, CounterClockwise = -1 };
-
-	bool powerOn()
-	{
-		if (poweredOn) {
-			std::cout << "电机已经开启。\n";
-			return false;
-		}
-		poweredOn = true;
-		std::cout << "电机已启动。\n";
-		return true;
-	}
-
-	void powerOff()
-	{
-		if (!poweredOn) {
-			std::cout << "电机已经关闭。\n";
-			return;
-		}
-		poweredOn = false;
-		speed = 0;
-		std::cout << "电机已停止，速度重置为 0。\n";
-	}
-
-	bool isPowered() const { return poweredOn; }
-
-	bool setSpeed(int newSpeed)
-	{
-		if (!poweredOn) {
-			std::cout << "请先开启电机再调整速度。\n";
-			return false;
-		}
-		const int maxAllowed = isSpeedLimited ? speedLimit : kMaxSpeed;
-		if (newSpeed < kMinSpeed || newSpeed > maxAllowed) {
-			std::cout << "速度必须在 " << kMinSpeed << " 到 " << maxAllowed << " 之间。\n";
-			return false;
-		}
-		speed = newSpeed;
-		std::cout << "速度已设置为 " << speed << "。\n";
-		return true;
-	}
-
-	int getSpeed() const { return speed; }
-
-	bool setDirection(Direction dir)
-	{
-		if (!poweredOn) {
-			std::cout << "请先开启电机再调整方向。\n";
-			return false;
-		}
-		direction = dir;
-		std::cout << "方向已调整为 " << directionToString() << "。\n";
-		return true;
-	}
-
-	Direction getDirection() const { return direction; }
-
-	std::string directionToString() const
-	{
-		return direction == Direction::Clockwise ? "顺时针" : "逆时针";
-	}
-
-	bool toggleDirection()
-	{
-		const auto next = (direction == Direction::Clockwise) ? Direction::CounterClockwise : Direction::Clockwise;
-		return setDirection(next);
-	}
-
-	bool setSpeedLimit(int limit)
-	{
-		if (limit < kMinSpeed || limit > kMaxSpeed) {
-			std::cout << "最大速度限制必须在 " << kMinSpeed << " 到 " << kMaxSpeed << " 之间。\n";
-			return false;
-		}
-		isSpeedLimited = true;
-		speedLimit = limit;
-		std::cout << "已设置最大速度限制为 " << speedLimit << "。\n";
-		if (poweredOn && speed > speedLimit) {
-			speed = speedLimit;
-			std::cout << "当前速度已被限制到 " << speed << "。\n";
-		}
-		return true;
-	}
-
-	void clearSpeedLimit()
-	{
-		if (!isSpeedLimited) {
-			std::cout << "当前没有启用最大速度限制。\n";
-			return;
-		}
-		isSpeedLimited = false;
-		speedLimit = kMaxSpeed;
-		std::cout << "已解除最大速度限制。\n";
-	}
-
-	bool isMaxSpeedLimited() const { return isSpeedLimited; }
-	int getSpeedLimit() const { return speedLimit; }
-
-private:
-	bool poweredOn = false;
-	int speed = 0;
-	Direction direction = Direction::Clockwise;
-	bool isSpeedLimited = false;
-	int speedLimit = kMaxSpeed;
-};
-
 std::string colorize(const std::string& text, const char* ansiColor)
 {
 	if (!gUseAnsiColors) {
@@ -165,14 +64,23 @@ std::string makeSpeedBar(int speed, std::size_t width = 20)
 	return bar;
 }
 
-void showMenu(const MotorController& motor)
+std::string directionText(MotorController::Direction direction)
+{
+	return direction == MotorController::Direction::Clockwise ? "顺时针" : "逆时针";
+}
+
+void showMenu(const MotorController::State& motor)
 {
 	std::cout << "\n================ 电机控制台 ================\n";
-	std::cout << "当前电机状态 => 电源:" << powerStateText(motor.isPowered())
-			<< " | 方向:" << motor.directionToString()
-			<< " | 限速:" << (motor.isMaxSpeedLimited() ? std::to_string(motor.getSpeedLimit()) : std::string("不限"))
+	std::cout << "当前电机状态 => 电源:" << powerStateText(motor.poweredOn)
+			<< " | 方向:" << directionText(motor.direction)
+			<< " | 限速:" << (motor.isSpeedLimited ? std::to_string(motor.speedLimit) : std::string("不限"))
 			<< "\n";
-	std::cout << "速度进度条   => [" << makeSpeedBar(motor.getSpeed()) << "] " << motor.getSpeed() << "%\n\n";
+	std::cout << "速度进度条   => [" << makeSpeedBar(motor.speed) << "] " << motor.speed << "%";
+	if (motor.speed != motor.targetSpeed || motor.direction != motor.targetDirection) {
+		std::cout << " -> 目标 " << motor.targetSpeed << "% " << directionText(motor.targetDirection) << "（加减速中）";
+	}
+	std::cout << "\n\n";
 
 	std::cout << "0. 关闭电机（退出程序）\n";
 	std::cout << "1. 开启电机\n";
@@ -181,6 +89,92 @@ void showMenu(const MotorController& motor)
 	std::cout << "4. 一键巡航（速度 60，顺时针）\n";
 	std::cout << "5. 设置最大速度限制\n";
 	std::cout << "6. 解除最大速度限制\n";
+	std::cout << "7. 查看控制循环统计\n";
+}
+
+void printResult(const CommandResult& result)
+{
+	using Status = MotorController::Status;
+	using Type = MotorCommand::Type;
+	const MotorController::State& state = result.state;
+	switch (result.command.type) {
+	case Type::PowerOn:
+		std::cout << (result.status == Status::AlreadyOn ? "电机已经开启。\n" : "电机已启动。\n");
+		break;
+	case Type::PowerOff:
+		std::cout << (result.status == Status::AlreadyOff ? "电机已经关闭。\n" : "电机已停止，速度重置为 0。\n");
+		break;
+	case Type::SetSpeed:
+		if (result.status == Status::NotPowered) {
+			std::cout << "请先开启电机再调整速度。\n";
+		} else if (result.status == Status::SpeedOutOfRange) {
+			std::cout << "速度必须在 " << kMinSpeed << " 到 " << (state.isSpeedLimited ? state.speedLimit : kMaxSpeed)
+					<< " 之间。\n";
+		} else {
+			std::cout << "速度已设置为 " << state.targetSpeed << "。\n";
+		}
+		break;
+	case Type::SetDirection:
+	case Type::ToggleDirection:
+		if (result.status == Status::NotPowered) {
+			std::cout << "请先开启电机再调整方向。\n";
+		} else {
+			std::cout << "方向已调整为 " << directionText(state.targetDirection) << "。\n";
+		}
+		break;
+	case Type::SetSpeedLimit:
+		if (result.status == Status::LimitOutOfRange) {
+			std::cout << "最大速度限制必须在 " << kMinSpeed << " 到 " << kMaxSpeed << " 之间。\n";
+			break;
+		}
+		std::cout << "已设置最大速度限制为 " << state.speedLimit << "。\n";
+		if (result.status == Status::LimitClampedSpeed) {
+			std::cout << "当前速度已被限制到 " << state.targetSpeed << "。\n";
+		}
+		break;
+	case Type::ClearSpeedLimit:
+		std::cout << (result.status == Status::NoLimit ? "当前没有启用最大速度限制。\n" : "已解除最大速度限制。\n");
+		break;
+	}
+}
+
+// Applies a command directly, or (in control-loop mode) posts it to the loop and waits for its reply,
+// then prints the outcome. The loop answers within one tick, so the wait is well under a millisecond.
+CommandResult execute(MotorController& motor, ControlLoop* loop, const MotorCommand& command)
+{
+	CommandResult result;
+	result.command = command;
+	if (loop) {
+		while (!loop->post(command)) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		while (!loop->takeResult(result)) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	} else {
+		result.status = motor.apply(command);
+		result.state = motor.state();
+	}
+	printResult(result);
+	return result;
+}
+
+void printLoopStats(const ControlLoop* loop)
+{
+	if (!loop) {
+		std::cout << "控制循环未启用（使用 --loop [频率Hz] 启动）。\n";
+		return;
+	}
+	const LoopStats s = loop->stats();
+	std::cout << "控制循环 " << s.rateHz << " Hz" << (s.realtimePriority ? "（实时优先级）" : "（普通优先级）")
+			<< " | 周期 " << s.ticks << " | 超时 " << s.missedDeadlines << " | 命令 " << s.commands << "\n";
+	std::cout << "唤醒抖动 => 平均 " << s.meanJitterUs << " us | p99 <= " << s.p99JitterUs << " us | 最大 "
+			<< s.maxJitterUs << " us\n";
+}
+
+void printTelemetryStats(const TelemetryRecorder& recorder)
+{
+	std::cout << "遥测记录 => 已写入 " << recorder.written() << " 条 | 丢弃 " << recorder.dropped() << " 条\n";
 }
 
 int readInt(const std::string& prompt, int minValue, int maxValue)
@@ -222,53 +216,128 @@ void configureConsoleEncoding()
 	std::setlocale(LC_ALL, ".UTF-8");
 }
 
-int main()
+int main(int argc, char** argv)
 {
 	configureConsoleEncoding();
-	MotorController motor;
-	bool running = true;
+	FleetController fleet(1);
+	MotorController motor(fleet, 0);
 
+	// --ramp scurve|trapezoid|off: how speed and direction changes are ramped (default S-curve)
+	// --loop [rateHz]: the motor is owned by a fixed-rate control thread and the menu only sends commands
+	// --record file [sampleEvery]: binary telemetry log, read it back with telemetry_dump
+	RampLimits ramp;
+	int loopRate = 0;
+	const char* recordPath = nullptr;
+	int sampleEvery = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--ramp") == 0 && i + 1 < argc) {
+			const char* kind = argv[++i];
+			if (std::strcmp(kind, "trapezoid") == 0) {
+				ramp.maxJerk = 0;
+			} else if (std::strcmp(kind, "off") == 0) {
+				ramp.maxAccel = 0;
+			}
+		} else if (std::strcmp(argv[i], "--loop") == 0) {
+			const int rate = (i + 1 < argc) ? std::atoi(argv[i + 1]) : ControlLoop::kMinRateHz;
+			loopRate = rate > 0 ? rate : ControlLoop::kMinRateHz;
+		} else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+				sampleEvery = std::atoi(argv[++i]);
+			}
+		}
+	}
+	motor.setRampLimits(ramp);
+	TelemetryRecorder recorder;
+	if (recordPath && !recorder.open(recordPath, (uint32_t)loopRate, (uint32_t)sampleEvery)) {
+		std::cout << "无法创建遥测文件 " << recordPath << "，不记录。\n";
+	}
+	std::unique_ptr<ControlLoop> loop;
+	if (loopRate > 0) {
+		loop.reset(new ControlLoop(motor, loopRate));
+		if (recorder.isOpen()) {
+			loop->attachRecorder(&recorder);
+		}
+		loop->start();
+	}
+
+	// Without the control loop the ramp follows wall-clock time, advanced whenever the menu touches the motor,
+	// and telemetry is sampled at those same moments.
+	auto lastAdvance = std::chrono::steady_clock::now();
+	auto currentState = [&]() {
+		if (loop) {
+			return loop->snapshot();
+		}
+		const auto now = std::chrono::steady_clock::now();
+		motor.advance(std::chrono::duration<double>(now - lastAdvance).count());
+		lastAdvance = now;
+		if (recorder.isOpen()) {
+			recorder.record(motor, 0, recorder.nowNs(now));
+		}
+		return motor.state();
+	};
+	auto run = [&](MotorCommand::Type type, int value = 0) {
+		currentState();
+		MotorCommand command;
+		command.type = type;
+		command.value = value;
+		const CommandResult result = execute(motor, loop.get(), command);
+		if (!loop && recorder.isOpen()) {
+			recorder.record(motor, telemetryEventFor(type, result.status), recorder.nowNs());
+		}
+		return result;
+	};
+
+	bool running = true;
 	while (running) {
-		showMenu(motor);
+		showMenu(currentState());
 		int choice = readInt("请选择操作：", kMenuMin, kMenuMax);
 
 		switch (choice) {
 		case 0:
-			motor.powerOff();
+			run(MotorCommand::Type::PowerOff);
 			std::cout << "程序结束，再见！\n";
 			running = false;
 			break;
 		case 1:
-			motor.powerOn();
+			run(MotorCommand::Type::PowerOn);
 			break;
 		case 2: {
 			int newSpeed = readInt("请输入目标速度：", kMinSpeed, kMaxSpeed);
-			motor.setSpeed(newSpeed);
+			run(MotorCommand::Type::SetSpeed, newSpeed);
 			break;
 		}
 		case 3: {
-			motor.toggleDirection();
+			run(MotorCommand::Type::ToggleDirection);
 			break;
 		}
-		case 4:
-			if (!motor.isPowered()) {
-				motor.powerOn();
+		case 4: {
+			if (!currentState().poweredOn) {
+				run(MotorCommand::Type::PowerOn);
 			}
-			motor.setDirection(MotorController::Direction::Clockwise);
-			if (motor.setSpeed(kCruiseSpeed)) {
+			run(MotorCommand::Type::SetDirection, static_cast<int>(MotorController::Direction::Clockwise));
+			const CommandResult cruise = run(MotorCommand::Type::SetSpeed, kCruiseSpeed);
+			if (cruise.status == MotorController::Status::Ok) {
 				std::cout << "一键巡航已启用。\n";
-			} else if (motor.isMaxSpeedLimited()) {
-				motor.setSpeed(motor.getSpeedLimit());
-				std::cout << "因限速，一键巡航速度调整为 " << motor.getSpeedLimit() << "。\n";
+			} else if (cruise.state.isSpeedLimited) {
+				run(MotorCommand::Type::SetSpeed, cruise.state.speedLimit);
+				std::cout << "因限速，一键巡航速度调整为 " << cruise.state.speedLimit << "。\n";
 			}
 			break;
+		}
 		case 5: {
 			int limit = readInt("请输入最大速度限制 (0-100)：", kMinSpeed, kMaxSpeed);
-			motor.setSpeedLimit(limit);
+			run(MotorCommand::Type::SetSpeedLimit, limit);
 			break;
 		}
 		case 6:
-			motor.clearSpeedLimit();
+			run(MotorCommand::Type::ClearSpeedLimit);
+			break;
+		case 7:
+			printLoopStats(loop.get());
+			if (recorder.isOpen()) {
+				printTelemetryStats(recorder);
+			}
 			break;
 		default:
 			std::cout << "无效的菜单选项。\n";
@@ -276,5 +345,13 @@ int main()
 		}
 	}
 
+	if (loop) {
+		loop->stop();
+		printLoopStats(loop.get());
+	}
+	if (recorder.isOpen()) {
+		recorder.close();
+		printTelemetryStats(recorder);
+	}
 	return 0;
 }
@@ -0,0 +1,49 @@
+// Single-motor view on one slot of a FleetController. No console I/O: every operation returns a Status and the
+// caller decides what to print, so the same code runs in the interactive menu and inside the real-time control loop.
+// Speed and direction commands only set a target; advance() moves the actual speed towards it along a ramp.
+#pragma once
+#include <cstddef>
+
+#include "fleet_controller.h"
+
+class MotorController {
+public:
+	using Direction = MotorDirection;
+	using Status = MotorStatus;
+	using State = MotorState;
+
+	MotorController(FleetController& fleet, std::size_t index) : fleet_(fleet), index_(index) {}
+
+	Status powerOn() { return fleet_.powerOn(index_); }
+	Status powerOff() { return fleet_.powerOff(index_); }
+	Status setSpeed(int newSpeed) { return fleet_.setSpeed(index_, newSpeed); }
+	Status setDirection(Direction dir) { return fleet_.setDirection(index_, dir); }
+	Status toggleDirection() { return fleet_.toggleDirection(index_); }
+	Status setSpeedLimit(int limit) { return fleet_.setSpeedLimit(index_, limit); }
+	Status clearSpeedLimit() { return fleet_.clearSpeedLimit(index_); }
+	Status apply(const MotorCommand& command) { return fleet_.apply(index_, command); }
+
+	void setRampLimits(const RampLimits& limits) { fleet_.setRampLimits(limits); }
+	const RampLimits& rampLimits() const { return fleet_.rampLimits(); }
+
+	// Ticks the whole fleet this motor belongs to; the menu and the control loop own a fleet of one.
+	void advance(double dt) { fleet_.tick(static_cast<float>(dt)); }
+
+	bool isRamping() const { return fleet_.isRamping(index_); }
+	double rampRemaining() const { return fleet_.rampRemaining(index_); }
+
+	State state() const { return fleet_.state(index_); }
+	std::size_t index() const { return index_; }
+	float speedValue() const { return fleet_.speedValue(index_); }
+	float targetValue() const { return fleet_.targetValue(index_); }
+	bool isPowered() const { return state().poweredOn; }
+	int getSpeed() const { return state().speed; }
+	Direction getDirection() const { return state().direction; }
+	bool isMaxSpeedLimited() const { return state().isSpeedLimited; }
+	int getSpeedLimit() const { return state().speedLimit; }
+	int maxAllowedSpeed() const { return fleet_.maxAllowedSpeed(index_); }
+
+private:
+	FleetController& fleet_;
+	std::size_t index_;
+};
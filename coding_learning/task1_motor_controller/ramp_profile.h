@@ -0,0 +1,72 @@
+// Acceleration-limited speed setpoints. Each command plans its whole move once, as three polynomial pieces
+// (a jerk-limited S-curve) or a single linear piece (trapezoid, constant acceleration); every control tick then
+// only evaluates one piece at the current time, so a step costs the same whether the move lasts 10 ms or 10 s.
+// Speeds here are signed (+ clockwise, - counter-clockwise), so a reversal is just a move that crosses zero.
+// The fleet keeps these fields as separate arrays and runs the same formulas four motors at a time.
+#pragma once
+#include <cmath>
+
+struct RampLimits {
+	float maxAccel = 100.0f; // speed units (%) per second
+	float maxJerk = 400.0f;  // per second squared; <= 0 gives a trapezoidal profile
+};
+
+struct RampPlan {
+	float t1 = 0;       // start of piece 1 (piece 0 starts at 0)
+	float t2 = 0;       // start of piece 2
+	float duration = 0; // the move reaches its target here
+	float target = 0;
+	float v0[3] = {};   // value at the start of each piece
+	float a0[3] = {};   // slope at the start of each piece
+	float jerk[3] = {}; // second derivative over each piece
+};
+
+// Plan a move from `from` to `target`, starting at zero acceleration. Re-planning in the middle of an S-curve
+// therefore restarts the jerk phase instead of continuing the old acceleration.
+// The S-curve is always written as jerk up / cruise at peak acceleration / jerk down; a short move simply has a
+// peak below maxAccel and a zero-length cruise, so there is no separate triangular case to branch on.
+inline RampPlan planRamp(float from, float target, const RampLimits& limits)
+{
+	RampPlan p;
+	p.target = target;
+	const float dv = target - from;
+	const float s = dv < 0 ? -1.0f : 1.0f;
+	const float size = std::fabs(dv);
+	const float a = limits.maxAccel;
+	const float j = limits.maxJerk;
+	if (size == 0 || a <= 0) {
+		return p;
+	}
+	if (j <= 0) {
+		p.duration = p.t1 = p.t2 = size / a;
+		p.v0[0] = from;
+		p.a0[0] = s * a;
+		return p;
+	}
+	const float peak = std::fmin(a, std::sqrt(size * j));
+	const float tj = peak / j;
+	const float tc = std::fmax(size / peak - tj, 0.0f);
+	const float half = s * peak * tj * 0.5f;
+	p.t1 = tj;
+	p.t2 = tj + tc;
+	p.duration = tj + tc + tj;
+	p.v0[0] = from;
+	p.v0[1] = from + half;
+	p.v0[2] = target - half;
+	p.a0[1] = p.a0[2] = s * peak;
+	p.jerk[0] = s * j;
+	p.jerk[2] = -s * j;
+	return p;
+}
+
+// Value of a planned move at time t (clamped to the move's end).
+inline float evalRamp(const RampPlan& p, float t)
+{
+	if (t >= p.duration) {
+		return p.target;
+	}
+	const int k = (t >= p.t1) + (t >= p.t2);
+	const float t0 = k == 0 ? 0.0f : (k == 1 ? p.t1 : p.t2);
+	const float u = t - t0;
+	return p.v0[k] + u * (p.a0[k] + 0.5f * p.jerk[k] * u);
+}
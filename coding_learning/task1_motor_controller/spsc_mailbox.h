@@ -0,0 +1,50 @@
+// Bounded lock-free single-producer / single-consumer queue.
+// One thread calls push, one (other) thread calls pop; neither ever blocks or allocates.
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+template <typename T, std::size_t Capacity>
+class SpscMailbox {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	// Producer side. Returns false when the mailbox is full.
+	bool push(const T& value)
+	{
+		const std::size_t head = head_.load(std::memory_order_relaxed);
+		if (head - cachedTail_ == Capacity) {
+			cachedTail_ = tail_.load(std::memory_order_acquire);
+			if (head - cachedTail_ == Capacity) {
+				return false;
+			}
+		}
+		slots_[head & (Capacity - 1)] = value;
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false when the mailbox is empty.
+	bool pop(T& value)
+	{
+		const std::size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == cachedHead_) {
+			cachedHead_ = head_.load(std::memory_order_acquire);
+			if (tail == cachedHead_) {
+				return false;
+			}
+		}
+		value = slots_[tail & (Capacity - 1)];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	// Producer and consumer indices live on separate cache lines; each side keeps a private copy of the
+	// other side's index and only reloads it when the mailbox looks full / empty.
+	alignas(64) std::atomic<std::size_t> head_{0};
+	std::size_t cachedTail_ = 0;
+	alignas(64) std::atomic<std::size_t> tail_{0};
+	std::size_t cachedHead_ = 0;
+	alignas(64) T slots_[Capacity] = {};
+};
@@ -0,0 +1,225 @@
+// Motor telemetry: fixed-size binary records pushed from the control path into a lock-free ring, and a recorder
+// thread that drains the ring into a compact log file (decoded offline by telemetry_dump). The producer side is one
+// branch and a 24-byte copy; a full ring drops the record and flags the gap instead of ever blocking.
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "motor_controller.h"
+#include "spsc_mailbox.h"
+
+// Event bits; a record is written every `sampleEvery` ticks and additionally on any tick that has events.
+enum TelemetryEvent : uint16_t {
+	kEventPowerOn = 1 << 0,
+	kEventPowerOff = 1 << 1,
+	kEventSetSpeed = 1 << 2,
+	kEventSetDirection = 1 << 3, // also toggle
+	kEventSetLimit = 1 << 4,
+	kEventClearLimit = 1 << 5,
+	kEventRejected = 1 << 6,   // a command on this tick returned an error status
+	kEventLimitClamp = 1 << 7, // a new limit lowered the running speed
+	kEventRampDone = 1 << 8,   // the actual speed reached the target on this tick
+	kEventReversal = 1 << 9,   // actual rotation changed direction
+	kEventOverrun = 1 << 10,   // the control loop missed deadlines since the previous tick
+	kEventGap = 1 << 11,       // the ring was full and records before this one were lost
+};
+
+constexpr int kTelemetryEventCount = 12;
+constexpr const char* kTelemetryEventNames[kTelemetryEventCount] = {
+	"power_on", "power_off", "set_speed", "set_direction", "set_limit", "clear_limit",
+	"rejected", "limit_clamp", "ramp_done", "reversal", "overrun", "gap",
+};
+
+enum TelemetryFlag : uint8_t {
+	kFlagPowered = 1 << 0,
+	kFlagLimited = 1 << 1,
+	kFlagCcw = 1 << 2,       // actual direction
+	kFlagTargetCcw = 1 << 3, // commanded direction
+};
+
+struct TelemetryRecord {
+	uint64_t timeNs = 0; // since the recording started (steady clock)
+	uint32_t motor = 0;
+	float setpoint = 0;  // signed target speed, + clockwise
+	float actual = 0;    // signed actual speed
+	uint8_t limit = 0;   // speed limit (kMaxSpeed when not limited)
+	uint8_t flags = 0;   // TelemetryFlag bits
+	uint16_t events = 0; // TelemetryEvent bits
+};
+static_assert(sizeof(TelemetryRecord) == 24, "log format depends on the record layout");
+
+// File layout: this header, then TelemetryRecord after TelemetryRecord until the end of the file.
+struct TelemetryLogHeader {
+	char magic[4] = {'M', 'T', 'L', 'G'};
+	uint16_t version = 1;
+	uint16_t recordSize = sizeof(TelemetryRecord);
+	uint32_t tickRateHz = 0;   // 0: menu-driven, no fixed rate
+	uint32_t sampleEvery = 1;  // ticks between periodic samples
+	int64_t startUnixNs = 0;   // wall-clock time of timeNs == 0
+};
+static_assert(sizeof(TelemetryLogHeader) == 24, "log format depends on the header layout");
+
+inline uint16_t telemetryEventFor(MotorCommand::Type type)
+{
+	switch (type) {
+	case MotorCommand::Type::PowerOn:
+		return kEventPowerOn;
+	case MotorCommand::Type::PowerOff:
+		return kEventPowerOff;
+	case MotorCommand::Type::SetSpeed:
+		return kEventSetSpeed;
+	case MotorCommand::Type::SetDirection:
+	case MotorCommand::Type::ToggleDirection:
+		return kEventSetDirection;
+	case MotorCommand::Type::SetSpeedLimit:
+		return kEventSetLimit;
+	case MotorCommand::Type::ClearSpeedLimit:
+		return kEventClearLimit;
+	}
+	return 0;
+}
+
+inline uint16_t telemetryEventFor(MotorCommand::Type type, MotorController::Status status)
+{
+	uint16_t events = telemetryEventFor(type);
+	if (status == MotorController::Status::LimitClampedSpeed) {
+		events |= kEventLimitClamp;
+	} else if (status != MotorController::Status::Ok) {
+		events |= kEventRejected;
+	}
+	return events;
+}
+
+class TelemetryRecorder {
+public:
+	static constexpr std::size_t kRingCapacity = 1 << 16; // ~1.5 MB, about a minute of 1 kHz samples
+
+	~TelemetryRecorder() { close(); }
+
+	// Creates the log and starts the drain thread. Call before the producer starts recording.
+	bool open(const std::string& path, uint32_t tickRateHz, uint32_t sampleEvery = 1)
+	{
+		close();
+		file_ = std::fopen(path.c_str(), "wb");
+		if (!file_) {
+			return false;
+		}
+		TelemetryLogHeader header;
+		header.tickRateHz = tickRateHz;
+		header.sampleEvery = sampleEvery > 0 ? sampleEvery : 1;
+		header.startUnixNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		std::fwrite(&header, sizeof(header), 1, file_);
+		sampleEvery_ = header.sampleEvery;
+		start_ = std::chrono::steady_clock::now();
+		ring_.reset(new SpscMailbox<TelemetryRecord, kRingCapacity>());
+		running_.store(true, std::memory_order_relaxed);
+		thread_ = std::thread(&TelemetryRecorder::drainLoop, this);
+		return true;
+	}
+
+	// Stops the drain thread after it has written everything already recorded.
+	void close()
+	{
+		running_.store(false, std::memory_order_release);
+		if (thread_.joinable()) {
+			thread_.join();
+		}
+		if (file_) {
+			std::fclose(file_);
+			file_ = nullptr;
+		}
+	}
+
+	bool isOpen() const { return file_ != nullptr; }
+
+	// --- producer side: one thread only ---
+
+	bool shouldSample(uint64_t tick, uint16_t events) const { return events != 0 || tick % sampleEvery_ == 0; }
+
+	uint64_t nowNs(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count();
+	}
+
+	void record(TelemetryRecord r)
+	{
+		if (gap_) {
+			r.events |= kEventGap;
+		}
+		gap_ = !ring_->push(r);
+		if (gap_) {
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void record(const MotorController& motor, uint16_t events, uint64_t timeNs)
+	{
+		const MotorController::State s = motor.state();
+		TelemetryRecord r;
+		r.timeNs = timeNs;
+		r.motor = (uint32_t)motor.index();
+		r.setpoint = motor.targetValue();
+		r.actual = motor.speedValue();
+		r.limit = (uint8_t)s.speedLimit;
+		r.flags = (s.poweredOn ? kFlagPowered : 0) | (s.isSpeedLimited ? kFlagLimited : 0)
+			| (s.direction == MotorController::Direction::CounterClockwise ? kFlagCcw : 0)
+			| (s.targetDirection == MotorController::Direction::CounterClockwise ? kFlagTargetCcw : 0);
+		r.events = events;
+		record(r);
+	}
+
+	// --- stats, any thread ---
+
+	uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+	uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	void drainLoop()
+	{
+		std::vector<TelemetryRecord> batch(4096);
+		auto lastFlush = std::chrono::steady_clock::now();
+		while (true) {
+			// read the flag first so a record pushed just before close() is still drained below
+			const bool stopping = !running_.load(std::memory_order_acquire);
+			std::size_t n = 0;
+			while (n < batch.size() && ring_->pop(batch[n])) {
+				++n;
+			}
+			if (n > 0) {
+				std::fwrite(batch.data(), sizeof(TelemetryRecord), n, file_);
+				written_.fetch_add(n, std::memory_order_relaxed);
+			}
+			if (n == batch.size()) {
+				continue;
+			}
+			if (stopping) {
+				break;
+			}
+			// flush once a second so a crash loses at most that much of an hours-long run
+			const auto now = std::chrono::steady_clock::now();
+			if (now - lastFlush > std::chrono::seconds(1)) {
+				std::fflush(file_);
+				lastFlush = now;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	std::FILE* file_ = nullptr;
+	std::unique_ptr<SpscMailbox<TelemetryRecord, kRingCapacity>> ring_;
+	std::thread thread_;
+	std::atomic<bool> running_{false};
+	std::chrono::steady_clock::time_point start_;
+	uint32_t sampleEvery_ = 1;
+	bool gap_ = false; // producer-only
+	std::atomic<uint64_t> written_{0};
+	std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,137 @@
+// Telemetry log decoder: summary by default, or every record as CSV for offline analysis.
+//   telemetry_dump <file.tlog> [--csv] [--motor N] [--from 秒] [--to 秒]
+// The log is read in blocks, so hours-long recordings never have to fit in memory.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "telemetry.h"
+
+namespace {
+struct MotorSummary {
+	uint64_t records = 0;
+	double firstSeconds = 0;
+	double lastSeconds = 0;
+	float maxSpeed = 0;
+	double speedSum = 0;
+	uint64_t events[kTelemetryEventCount] = {};
+};
+
+std::string eventText(uint16_t events)
+{
+	std::string text;
+	for (int b = 0; b < kTelemetryEventCount; ++b) {
+		if (events & (1u << b)) {
+			if (!text.empty()) {
+				text += '|';
+			}
+			text += kTelemetryEventNames[b];
+		}
+	}
+	return text;
+}
+}
+
+int main(int argc, char** argv)
+{
+	const char* path = nullptr;
+	bool csv = false;
+	long motorFilter = -1;
+	double from = 0, to = INFINITY;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--csv") == 0) {
+			csv = true;
+		} else if (std::strcmp(argv[i], "--motor") == 0 && i + 1 < argc) {
+			motorFilter = std::atol(argv[++i]);
+		} else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+			from = std::atof(argv[++i]);
+		} else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+			to = std::atof(argv[++i]);
+		} else {
+			path = argv[i];
+		}
+	}
+	if (!path) {
+		std::fprintf(stderr, "用法: telemetry_dump <file.tlog> [--csv] [--motor N] [--from 秒] [--to 秒]\n");
+		return 2;
+	}
+
+	std::FILE* file = std::fopen(path, "rb");
+	if (!file) {
+		std::fprintf(stderr, "无法打开 %s\n", path);
+		return 1;
+	}
+	TelemetryLogHeader header;
+	if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "MTLG", 4) != 0) {
+		std::fprintf(stderr, "%s 不是遥测日志\n", path);
+		std::fclose(file);
+		return 1;
+	}
+	if (header.version != 1 || header.recordSize != sizeof(TelemetryRecord)) {
+		std::fprintf(stderr, "不支持的日志版本 %u (记录 %u 字节)\n", (unsigned)header.version, (unsigned)header.recordSize);
+		std::fclose(file);
+		return 1;
+	}
+
+	if (csv) {
+		std::printf("time_s,motor,setpoint,actual,direction,target_direction,limit,powered,limited,events\n");
+	}
+	std::map<uint32_t, MotorSummary> motors;
+	uint64_t total = 0, gaps = 0;
+	std::vector<TelemetryRecord> block(4096);
+	std::size_t n;
+	while ((n = std::fread(block.data(), sizeof(TelemetryRecord), block.size(), file)) > 0) {
+		for (std::size_t k = 0; k < n; ++k) {
+			const TelemetryRecord& r = block[k];
+			const double seconds = r.timeNs / 1e9;
+			if ((motorFilter >= 0 && r.motor != (uint32_t)motorFilter) || seconds < from || seconds > to) {
+				continue;
+			}
+			++total;
+			gaps += (r.events & kEventGap) != 0;
+			if (csv) {
+				std::printf("%.6f,%u,%.3f,%.3f,%s,%s,%u,%d,%d,%s\n", seconds, r.motor, r.setpoint, r.actual,
+						(r.flags & kFlagCcw) ? "ccw" : "cw", (r.flags & kFlagTargetCcw) ? "ccw" : "cw", (unsigned)r.limit,
+						(r.flags & kFlagPowered) ? 1 : 0, (r.flags & kFlagLimited) ? 1 : 0, eventText(r.events).c_str());
+				continue;
+			}
+			MotorSummary& m = motors[r.motor];
+			if (m.records++ == 0) {
+				m.firstSeconds = seconds;
+			}
+			m.lastSeconds = seconds;
+			m.maxSpeed = std::fmax(m.maxSpeed, std::fabs(r.actual));
+			m.speedSum += std::fabs(r.actual);
+			for (int b = 0; b < kTelemetryEventCount; ++b) {
+				m.events[b] += (r.events >> b) & 1;
+			}
+		}
+	}
+	std::fclose(file);
+	if (csv) {
+		return 0;
+	}
+
+	const std::time_t start = (std::time_t)(header.startUnixNs / 1000000000);
+	char startText[64];
+	std::strftime(startText, sizeof(startText), "%Y-%m-%d %H:%M:%S", std::localtime(&start));
+	std::printf("日志 %s\n开始 %s | 控制频率 %s | 每 %u 周期采样一次\n", path, startText,
+			header.tickRateHz ? (std::to_string(header.tickRateHz) + " Hz").c_str() : "菜单驱动", header.sampleEvery);
+	std::printf("记录 %llu 条 | 断档 %llu 处 (记录环满，之前有记录丢失)\n", (unsigned long long)total, (unsigned long long)gaps);
+	for (const auto& item : motors) {
+		const MotorSummary& m = item.second;
+		std::printf("\n电机 %u: %llu 条, %.3f ~ %.3f 秒, 最高速度 %.1f, 平均速度 %.1f\n", item.first,
+				(unsigned long long)m.records, m.firstSeconds, m.lastSeconds, m.maxSpeed, m.speedSum / m.records);
+		for (int b = 0; b < kTelemetryEventCount; ++b) {
+			if (m.events[b]) {
+				std::printf("  %-14s %llu\n", kTelemetryEventNames[b], (unsigned long long)m.events[b]);
+			}
+		}
+	}
+	return 0;
+}
@@ -15,6 +15,25 @@
 #include <filesystem> // C++17 标准库
 #include <fstream>    // 用于文件读写
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h> // GlobalMemoryStatusEx
+#else
+#include <unistd.h>  // sysconf
+#endif
+#ifdef __linux__
+#include <pthread.h> // pthread_setaffinity_np
+#include <sched.h>   // sched_getaffinity / sched_getcpu
+#endif
+
+// 追踪 / 指标 (和 task2_photo_system 共用，见 vcxproj 里的包含目录)
+#include "rt_vision/trace.h"
 
 // 使用 C++17 文件系统命名空间
 namespace fs = std::filesystem;
@@ -47,6 +66,17 @@ public:
     // 这里的 buffer 暴露给处理器
     std::vector<char>& getData() { return rawData_; }
     const std::vector<char>& getData() const { return rawData_; }
+
+    // 换入一块用过的缓冲 (保留容量，load 时不用重新分配)，处理完用 releaseBuffer 拿回来放回池子
+    void adoptBuffer(std::vector<char>&& buffer) {
+        rawData_ = std::move(buffer);
+        rawData_.clear();
+        loaded_ = false;
+    }
+    std::vector<char> releaseBuffer() {
+        loaded_ = false;
+        return std::move(rawData_);
+    }
 };
 
 // ==========================================
@@ -159,30 +189,242 @@ public:
 };
 
 // ==========================================
-// 4. concurrent_base.hpp - 并发管理 (核心考点)
+// 4. image_probe.hpp - 只读文件头估算解码后的大小
 // ==========================================
 
-template<typename T>
-class ThreadSafeQueue {
-    std::queue<T> queue_;
-    mutable std::mutex mutex_;
-    std::condition_variable cond_;
+// 插件解码后每像素 3 字节左右，处理时输入图和输出图同时在内存里，按 2 份算
+// 文件头读不出尺寸时按压缩率 1:10 粗估
+static uint64_t estimateDecodedBytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char h[32] = {};
+    if (!in.read(reinterpret_cast<char*>(h), sizeof(h))) return 0;
+    auto be16 = [](const unsigned char* p) { return (uint32_t)(p[0] << 8 | p[1]); };
+    auto le32 = [](const unsigned char* p) { return (uint32_t)p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; };
+
+    uint64_t w = 0, ht = 0, c = 3;
+    if (h[0] == 0x89 && h[1] == 'P' && h[2] == 'N' && h[3] == 'G') {
+        // IHDR：宽、高 (大端)、位深、颜色类型
+        w = (uint64_t)be16(h + 16) << 16 | be16(h + 18);
+        ht = (uint64_t)be16(h + 20) << 16 | be16(h + 22);
+        static const int kChannels[7] = { 1, 0, 3, 3, 2, 0, 4 };
+        c = (h[25] < 7 && kChannels[h[25]] ? kChannels[h[25]] : 4) * (h[24] == 16 ? 2 : 1);
+    }
+    else if (h[0] == 'B' && h[1] == 'M') {
+        w = le32(h + 18);
+        ht = (uint64_t)std::llabs((int32_t)le32(h + 22));
+        c = (h[28] | h[29] << 8) >= 32 ? 4 : 3;
+    }
+    else if (h[0] == 0xFF && h[1] == 0xD8) {
+        // 逐个跳过标记段直到 SOFn (EXIF 缩略图可能很大，所以按段长度跳而不是只读开头一块)
+        in.seekg(2);
+        unsigned char m[9];
+        while (in.read(reinterpret_cast<char*>(m), 4) && m[0] == 0xFF) {
+            const int marker = m[1];
+            const uint32_t len = be16(m + 2);
+            const bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+            if (sof) {
+                if (!in.read(reinterpret_cast<char*>(m), 6)) break;
+                ht = be16(m + 1);
+                w = be16(m + 3);
+                c = m[5];
+                break;
+            }
+            if (len < 2) break;
+            in.seekg(len - 2, std::ios::cur);
+        }
+    }
+    if (w && ht) return w * ht * c * 2;
+
+    std::error_code ec;
+    const uintmax_t fileSize = fs::file_size(path, ec);
+    return ec ? 0 : (uint64_t)fileSize * 10;
+}
+
+static uint64_t physicalMemoryBytes() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && pageSize > 0 ? (uint64_t)pages * pageSize : 0;
+#endif
+}
+
+// ==========================================
+// 5. cpu_topology.hpp - CPU 拓扑 (NUMA 节点) 与绑核
+// ==========================================
+
+// sysfs 的 CPU 列表格式，如 "0-3,8-11"
+static std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        int first = 0, last = 0;
+        const int n = std::sscanf(part.c_str(), "%d-%d", &first, &last);
+        if (n < 1) continue;
+        if (n == 1) last = first;
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// 每个 NUMA 节点有哪些 CPU。Linux 上读 /sys/devices/system/node/node*/cpulist，
+// 只保留本进程允许运行的 CPU (taskset / cgroup 限制过的不算)，只有内存没有 CPU 的节点跳过；
+// 读不到 (Windows、容器里没挂 sysfs) 时当作一个节点
+struct CpuTopology {
+    struct Node {
+        int id = 0;
+        std::vector<int> cpus;
+    };
+    std::vector<Node> nodes;
+
+    static CpuTopology discover() {
+        CpuTopology topo;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || !std::isdigit((unsigned char)name[4])) continue;
+            std::ifstream in(entry.path() / "cpulist");
+            std::string text;
+            std::getline(in, text);
+            Node node;
+            node.id = std::atoi(name.c_str() + 4);
+            for (int cpu : parseCpuList(text)) {
+                if (!haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty()) topo.nodes.push_back(std::move(node));
+        }
+        std::sort(topo.nodes.begin(), topo.nodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+#endif
+        if (topo.nodes.empty()) {
+            Node node;
+            const int cores = std::max(1u, std::thread::hardware_concurrency());
+            for (int cpu = 0; cpu < cores; ++cpu) node.cpus.push_back(cpu);
+            topo.nodes.push_back(std::move(node));
+        }
+        return topo;
+    }
+
+    // CPU 所在节点在 nodes 里的下标，不认识的 CPU 返回 -1
+    int nodeOfCpu(int cpu) const {
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (std::find(nodes[i].cpus.begin(), nodes[i].cpus.end(), cpu) != nodes[i].cpus.end()) return (int)i;
+        }
+        return -1;
+    }
+
+    std::string describe() const {
+        std::ostringstream out;
+        out << nodes.size() << " 个 NUMA 节点 (";
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            out << (i ? ", " : "") << "node" << nodes[i].id << ": " << nodes[i].cpus.size() << " 核";
+        }
+        out << ")";
+        return out.str();
+    }
+};
+
+// 把当前线程限制在给定的 CPU 上；不支持的平台什么也不做，返回 false
+static bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+// 每个节点一个读文件缓冲池。Linux 按首次写入分配物理页，缓冲第一次由本节点的线程写入，
+// 用完放回同一个节点的池子，之后一直在这个节点上用，不会让另一颗 CPU 隔着互联去读
+// 池子按块数和总字节数两头限制：字节上限从内存预算里预留 (见 ImageProcessingManager::startProcessing)，
+// 放不下的缓冲 (比如一张特别大的图留下的) 直接释放，不会每个节点都攒一堆大缓冲
+class NodeBufferPool {
+    std::mutex mutex_;
+    std::vector<std::vector<char>> free_;
+    size_t limit_ = 8;
+    size_t byteLimit_ = 64ull << 20;
+    size_t freeBytes_ = 0; // free_ 里所有缓冲的容量之和
+
 public:
-    void push(T value) {
+    // 最多留多少块 (同时在用的不会超过线程数，再多留也只是占内存)、总共最多占多少字节
+    void setLimit(size_t limit, size_t byteLimit) {
         std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(std::move(value));
-        cond_.notify_one();
+        limit_ = limit;
+        byteLimit_ = byteLimit;
+        while (!free_.empty() && (free_.size() > limit_ || freeBytes_ > byteLimit_)) {
+            freeBytes_ -= free_.back().capacity();
+            free_.pop_back();
+        }
     }
-    bool pop(T& value) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (queue_.empty()) return false;
-        value = std::move(queue_.front());
-        queue_.pop();
-        return true;
+
+    // 给容量最大的一块 (大图不用再扩容)；池子空时返回空缓冲，由 load 在当前线程上分配
+    std::vector<char> acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) return {};
+        auto it = std::max_element(free_.begin(), free_.end(),
+            [](const std::vector<char>& a, const std::vector<char>& b) { return a.capacity() < b.capacity(); });
+        std::vector<char> buffer = std::move(*it);
+        *it = std::move(free_.back());
+        free_.pop_back();
+        freeBytes_ -= buffer.capacity();
+        return buffer;
     }
-    bool empty() const {
+
+    void release(std::vector<char>&& buffer) {
+        const size_t bytes = buffer.capacity();
+        if (bytes == 0) return;
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        if (free_.size() < limit_ && freeBytes_ + bytes <= byteLimit_) {
+            free_.push_back(std::move(buffer));
+            freeBytes_ += bytes;
+        }
+    }
+};
+
+// ==========================================
+// 6. concurrent_base.hpp - 并发管理 (核心考点)
+// ==========================================
+
+// 工作线程绑核方式：kNode 限制在所属 NUMA 节点的所有核上 (节点内仍由系统调度)，kCore 每个线程一个核
+enum class PinMode { kOff, kNode, kCore };
+
+// 调度参数：线程数在 [minWorkers, maxWorkers] 之间自动调整，
+// 同时在处理的图片估算内存之和不超过 memoryBudget
+struct SchedulerConfig {
+    int minWorkers = 1;
+    int maxWorkers = 8;
+    uint64_t memoryBudget = 1ull << 30;
+    std::chrono::milliseconds interval{ 1000 }; // 多久评估一次吞吐量
+    PinMode pin = PinMode::kOff;
+
+    // 按本机核数和内存给默认值：插件是外部进程，I/O 和进程启动占了不少时间，上限给到核数的 2 倍；
+    // 内存预算取物理内存的 1/4，环境变量 PHOTO_MEMORY_MB 可以覆盖；PHOTO_PIN=node / core 打开绑核
+    static SchedulerConfig defaults() {
+        SchedulerConfig config;
+        const int cores = std::max(1u, std::thread::hardware_concurrency());
+        config.maxWorkers = cores * 2;
+        if (const char* mb = std::getenv("PHOTO_MEMORY_MB")) {
+            config.memoryBudget = std::strtoull(mb, nullptr, 10) << 20;
+        }
+        else if (const uint64_t total = physicalMemoryBytes()) {
+            config.memoryBudget = total / 4;
+        }
+        if (const char* pin = std::getenv("PHOTO_PIN")) {
+            const std::string mode = pin;
+            config.pin = mode == "node" ? PinMode::kNode : mode == "core" ? PinMode::kCore : PinMode::kOff;
+        }
+        return config;
     }
 };
 
@@ -190,68 +432,299 @@ struct Task {
     std::shared_ptr<Image> img;
     std::shared_ptr<ImageProcessor<Image>> processor;
     std::string outputPath;
+    int64_t enqueueUs = 0; // 入队时间，用来算排队等待
+    uint64_t cost = 0;     // 估算的峰值内存 (字节)，同时也是排序依据
 };
 
 class ImageProcessingManager {
-    ThreadSafeQueue<Task> taskQueue_;
+    static constexpr uint64_t kPoolBudgetShare = 8; // 缓冲池占内存预算的 1/kPoolBudgetShare
+
+    // 每个 NUMA 节点一个待处理队列，按 cost 排序：先取放得进内存预算的最大任务 (大任务先做，最后剩下的都是小的，整批结束得更早)
+    // 工作线程按编号轮流分到各个节点，先取本节点的任务，本节点没有可做的才去别的节点偷
+    CpuTopology topology_;
+    std::vector<std::multimap<uint64_t, Task>> pending_;
+    std::vector<uint64_t> pendingBytes_; // 各节点排队任务的 cost 之和，新任务放到最少的节点
+    size_t pendingCount_ = 0;
+    std::vector<std::unique_ptr<NodeBufferPool>> pools_;
+    std::mutex mutex_;
+    std::condition_variable workCv_; // 有新任务 / 内存释放 / 线程数变化
+    std::condition_variable doneCv_; // 任务完成，waitAll 在等
     std::vector<std::thread> workers_;
-    std::atomic<bool> stop_ = false;
-    std::mutex outputMutex_;
+    std::thread controller_;
+    bool stop_ = false;
+
+    SchedulerConfig config_;
+    uint64_t poolReserve_ = 0;  // 从 memoryBudget 里留给各节点缓冲池的字节数，任务只能用剩下的
+    int target_ = 0;            // 当前允许工作的线程数，编号 >= target_ 的线程挂起
+    int inflight_ = 0;          // 正在处理的任务数
+    uint64_t inflightBytes_ = 0;
+    uint64_t doneBytes_ = 0;    // 已完成任务的 cost 之和，用来算吞吐量 (按张数算会被大小不一的图片带偏)
+    int memoryStalls_ = 0;      // 有任务但因为内存预算取不了的次数
+
+    // 指标只在构造时按名字查一次，之后热路径上只有原子加
+    Counter& imagesOk_ = metrics().counter("images_ok");
+    Counter& imagesFailed_ = metrics().counter("images_failed");
+    Counter& inputBytes_ = metrics().counter("input_bytes");
+    Gauge& queueDepth_ = metrics().gauge("queue_depth");
+    Gauge& workerCount_ = metrics().gauge("workers");
+    Gauge& inflightMemory_ = metrics().gauge("inflight_mb");
+    LatencyHistogram& queueWait_ = metrics().histogram("queue_wait");
+    LatencyHistogram& memoryWait_ = metrics().histogram("memory_wait");
+    LatencyHistogram& loadLatency_ = metrics().histogram("load");
+    LatencyHistogram& processLatency_ = metrics().histogram("process");
+    Counter& tasksStolen_ = metrics().counter("tasks_stolen");     // 从别的节点偷来的任务
+    Counter& buffersReused_ = metrics().counter("buffers_reused"); // 从节点缓冲池拿到旧缓冲的次数
 
 public:
-    ImageProcessingManager() {}
+    ImageProcessingManager() : topology_(CpuTopology::discover()) {
+        const size_t nodes = topology_.nodes.size();
+        pending_.resize(nodes);
+        pendingBytes_.assign(nodes, 0);
+        for (size_t i = 0; i < nodes; ++i) pools_.push_back(std::make_unique<NodeBufferPool>());
+    }
     ~ImageProcessingManager() { stopProcessing(); }
 
     void addTask(std::shared_ptr<Image> img, std::shared_ptr<ImageProcessor<Image>> proc, const std::string& outPath) {
-        taskQueue_.push({ img, proc, outPath });
+        const uint64_t cost = estimateDecodedBytes(img->getFilename()); // 只读文件头，在锁外做
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const size_t node = std::min_element(pendingBytes_.begin(), pendingBytes_.end()) - pendingBytes_.begin();
+            pending_[node].emplace(cost, Task{ img, proc, outPath, traceNowUs(), cost });
+            pendingBytes_[node] += cost;
+            ++pendingCount_;
+        }
+        workCv_.notify_all();
+        queueDepth_.add(1);
+        traceCounter("queue_depth", queueDepth_.value());
     }
 
-    void startProcessing(int numThreads = 4) {
+    void startProcessing(const SchedulerConfig& config = SchedulerConfig::defaults()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = config;
+        config_.minWorkers = std::max(1, config_.minWorkers);
+        config_.maxWorkers = std::max(config_.minWorkers, config_.maxWorkers);
         stop_ = false;
-        for (int i = 0; i < numThreads; ++i) {
-            workers_.emplace_back(&ImageProcessingManager::workerThread, this);
-        }
+        // 缓冲池总共占内存预算的 1/8，平分给各节点；这部分不再分给任务，两边加起来不超过预算
+        poolReserve_ = config_.memoryBudget / kPoolBudgetShare;
+        for (auto& pool : pools_) pool->setLimit(config_.maxWorkers, (size_t)(poolReserve_ / pools_.size()));
+        static const char* kPinNames[] = { "不绑核", "按节点绑核", "每线程一个核" };
+        logAsync("[拓扑] " + topology_.describe() + "，" + kPinNames[(int)config_.pin]);
+        // 从核数开始，之后由 controllerThread 按吞吐量增减
+        setTarget(std::clamp((int)std::thread::hardware_concurrency(), config_.minWorkers, config_.maxWorkers));
+        controller_ = std::thread(&ImageProcessingManager::controllerThread, this);
     }
 
     void stopProcessing() {
-        stop_ = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        workCv_.notify_all();
+        if (controller_.joinable()) controller_.join();
         for (auto& t : workers_) {
-            if (t.joinable()) t.detach();
+            if (t.joinable()) t.join();
         }
+        workers_.clear();
     }
 
     void waitAll() {
-        while (!taskQueue_.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            doneCv_.wait(lock, [&] { return pendingCount_ == 0 && inflight_ == 0; });
         }
-        std::this_thread::sleep_for(std::chrono::seconds(1)); // 等待最后一点任务收尾
+        flushLog(std::cout);
+        metrics().report(std::cout); // MetricsReporter 刚输出过就不再重复
     }
 
 private:
-    void workerThread() {
+    // 调用时持有 mutex_；线程只增不减，多出来的线程挂起等待
+    void setTarget(int n) {
+        target_ = n;
+        while ((int)workers_.size() < target_) {
+            workers_.emplace_back(&ImageProcessingManager::workerThread, this, (int)workers_.size());
+        }
+        workerCount_.set(target_);
+        traceCounter("workers", target_);
+        workCv_.notify_all();
+    }
+
+    // 调用时持有 mutex_：从 node 开始依次看各节点的队列，取放得进剩余预算的最大任务；一个都放不进时返回 false
+    bool takeTask(int node, Task& task) {
+        const uint64_t budget = config_.memoryBudget - poolReserve_;
+        const uint64_t available = budget > inflightBytes_ ? budget - inflightBytes_ : 0;
+        const int nodes = (int)pending_.size();
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int k = 0; k < nodes; ++k) {
+                auto& queue = pending_[(node + k) % nodes];
+                auto it = queue.upper_bound(available);
+                if (it == queue.begin()) {
+                    // 单张就超过预算：没有别的任务在处理时照样放行，否则它永远轮不到
+                    if (pass == 0 || inflight_ != 0 || queue.empty()) continue;
+                    it = queue.end();
+                }
+                it = std::prev(it);
+                task = std::move(it->second);
+                queue.erase(it);
+                pendingBytes_[(node + k) % nodes] -= task.cost;
+                --pendingCount_;
+                if (k) tasksStolen_.add();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 绑核时线程一直在自己的节点上；不绑时看一下当前跑在哪个核上，就用那个节点的队列和缓冲池
+    int currentNode(int home, bool pinned) const {
+#ifdef __linux__
+        if (!pinned && topology_.nodes.size() > 1) {
+            const int node = topology_.nodeOfCpu(sched_getcpu());
+            if (node >= 0) return node;
+        }
+#endif
+        (void)pinned;
+        return home;
+    }
+
+    // 线程 index 分到节点 index % 节点数；kCore 时在节点内再按编号轮流分核 (线程比核多时共用)
+    bool pinWorker(int index, int node) {
+        const std::vector<int>& cpus = topology_.nodes[node].cpus;
+        if (config_.pin == PinMode::kNode) return pinCurrentThread(cpus);
+        if (config_.pin == PinMode::kCore) {
+            const size_t slot = index / topology_.nodes.size();
+            return pinCurrentThread({ cpus[slot % cpus.size()] });
+        }
+        return false;
+    }
+
+    void workerThread(int index) {
+        setTraceThreadName("worker " + std::to_string(index));
+        const int home = index % (int)topology_.nodes.size();
+        const bool pinned = pinWorker(index, home);
+        if (config_.pin != PinMode::kOff && !pinned) logAsync("[线程 " + std::to_string(index) + "] 绑核失败");
+        std::unique_lock<std::mutex> lock(mutex_);
+        int64_t memoryWaitBegin = 0; // 因为内存预算等待的起点，0 表示没在等
         while (!stop_) {
+            if (index >= target_ || pendingCount_ == 0) {
+                workCv_.wait(lock);
+                continue;
+            }
+            const int node = currentNode(home, pinned);
             Task task;
-            if (taskQueue_.pop(task)) {
-                if (!task.img->load()) continue; // 读取文件
-                auto result = task.processor->process(*task.img, task.outputPath);
-
-                // 线程安全输出日志
-                std::lock_guard<std::mutex> lock(outputMutex_);
-                std::cout << "[线程 " << std::this_thread::get_id() << "] "
-                    << (result.success ? "成功: " : "失败: ")
-                    << fs::path(result.inputFile).filename().string()
-                    << " -> " << result.operation
-                    << std::endl;
+            if (!takeTask(node, task)) {
+                if (!memoryWaitBegin) {
+                    memoryWaitBegin = traceNowUs();
+                    ++memoryStalls_;
+                }
+                workCv_.wait(lock);
+                continue;
             }
-            else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ++inflight_;
+            inflightBytes_ += task.cost;
+            inflightMemory_.set((int64_t)(inflightBytes_ >> 20));
+            lock.unlock();
+
+            const int64_t dequeueUs = traceNowUs();
+            if (memoryWaitBegin) {
+                memoryWait_.record(dequeueUs - memoryWaitBegin);
+                traceComplete("memory_wait", memoryWaitBegin, dequeueUs);
+                memoryWaitBegin = 0;
             }
+            queueDepth_.add(-1);
+            traceCounter("queue_depth", queueDepth_.value());
+            queueWait_.record(dequeueUs - task.enqueueUs);
+            traceComplete("queue_wait", task.enqueueUs, dequeueUs);
+            runTask(task, index, node);
+
+            lock.lock();
+            --inflight_;
+            inflightBytes_ -= task.cost;
+            doneBytes_ += task.cost;
+            inflightMemory_.set((int64_t)(inflightBytes_ >> 20));
+            workCv_.notify_all(); // 释放了内存，等预算的线程可以再试
+            if (pendingCount_ == 0 && inflight_ == 0) doneCv_.notify_all();
+        }
+    }
+
+    void runTask(Task& task, int index, int node) {
+        // 读文件的缓冲从本节点的池子里拿，用完 (包括读失败) 放回去
+        NodeBufferPool& pool = *pools_[node];
+        std::vector<char> buffer = pool.acquire();
+        if (buffer.capacity()) buffersReused_.add();
+        task.img->adoptBuffer(std::move(buffer));
+
+        bool loaded;
+        {
+            TraceSpan span("load", &loadLatency_); // 读取文件
+            loaded = task.img->load();
+        }
+        if (!loaded) {
+            pool.release(task.img->releaseBuffer());
+            imagesFailed_.add();
+            return;
+        }
+        inputBytes_.add(task.img->getData().size());
+
+        ProcessingResult<std::string> result;
+        {
+            TraceSpan span("process", &processLatency_); // 解码 + 变换 + 编码 + 写文件 (在插件里)
+            result = task.processor->process(*task.img, task.outputPath);
+        }
+        (result.success ? imagesOk_ : imagesFailed_).add();
+        pool.release(task.img->releaseBuffer());
+
+        // 日志先放进队列，由 MetricsReporter 线程统一输出，工作线程不在 stdout 上排队
+        std::ostringstream line;
+        line << "[线程 " << index << "] "
+            << (result.success ? "成功: " : "失败: ")
+            << fs::path(result.inputFile).filename().string()
+            << " -> " << result.operation;
+        logAsync(line.str());
+    }
+
+    // 爬山法：每个周期比较吞吐量 (字节/秒)，上次调整后变快就沿同一方向再走一步，变慢就掉头；
+    // 受内存预算限制时 (有线程在等内存) 加线程没有用，不再增加。空闲时不调整
+    void controllerThread() {
+        setTraceThreadName("scheduler");
+        std::unique_lock<std::mutex> lock(mutex_);
+        int direction = 1;
+        double lastRate = -1;
+        uint64_t lastDone = doneBytes_;
+        int64_t lastUs = traceNowUs();
+        while (!workCv_.wait_for(lock, config_.interval, [&] { return stop_; })) {
+            const int64_t now = traceNowUs();
+            const double rate = (doneBytes_ - lastDone) / ((now - lastUs) / 1e6);
+            const bool busy = pendingCount_ > 0;
+            const int stalls = memoryStalls_;
+            lastDone = doneBytes_;
+            lastUs = now;
+            memoryStalls_ = 0;
+            if (!busy) {
+                lastRate = -1; // 下一批重新开始比较
+                continue;
+            }
+            if (lastRate >= 0 && rate < lastRate * 0.95) direction = -direction;
+            else if (lastRate >= 0 && rate <= lastRate * 1.05) continue; // 差别不大，保持
+            if (direction > 0 && stalls > 0) { // 内存已经是瓶颈：保持线程数，只是不再增加
+                lastRate = rate;
+                continue;
+            }
+            const int next = std::clamp(target_ + direction, config_.minWorkers, config_.maxWorkers);
+            if (next == target_) direction = -direction;
+            lastRate = rate;
+            if (next == target_) continue;
+
+            std::ostringstream line;
+            line << "[调度] 线程 " << target_ << " -> " << next << " (吞吐 " << (int)(rate / 1e6)
+                << " MB/s, 排队 p50 " << queueWait_.percentileUs(0.5) / 1000 << " ms, 等内存 " << stalls << " 次)";
+            logAsync(line.str());
+            setTarget(next);
         }
     }
 };
 
 // ==========================================
-// 5. Main Logic
+// 7. Main Logic
 // ==========================================
 
 void printMenu() {
@@ -270,7 +743,8 @@ int main() {
 
     std::vector<std::string> fileList;
     ImageProcessingManager manager;
-    manager.startProcessing(4); // 启动4个线程
+    manager.startProcessing(); // 线程数按吞吐量自动调整，内存预算默认是物理内存的 1/4
+    MetricsReporter reporter(std::cout, std::chrono::seconds(1)); // 每秒输出日志和吞吐量 (空闲时不输出)
 
     while (true) {
         printMenu();
@@ -340,5 +814,9 @@ int main() {
         }
         else if (choice == 3) break;
     }
+
+    // 设置了 RT_VISION_TRACE=trace.json 时导出时间线，用 ui.perfetto.dev 打开
+    if (!traceOutputPath().empty() && writeChromeTrace(traceOutputPath()))
+        std::cout << "时间线已写入 " << traceOutputPath() << "\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+// JPEG 解码基准：stbi_load (单线程) 对比按重启间隔并行解码
+//   jpeg_bench <a.jpg> [b.jpg ...] [-n 次数]
+// 没有重启标记的文件走不了并行路径，只测 stb (Image::loadFromMemory 会自动退回 stb)。
+// 线程数由 RT_VISION_THREADS 控制，=1 时可以看单线程下两条路径本身的差别。
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "rt_vision/image_system.h"
+#include "rt_vision/jpeg_decoder.h"
+#include "rt_vision/parallel.h"
+#include "rt_vision/trace.h"
+#include "stb_image.h"
+
+// 跑 repeat 次取最快的一次，毫秒
+template <typename F>
+static double bestMs(int repeat, F&& f) {
+    int64_t best = INT64_MAX;
+    for (int i = 0; i < repeat; ++i) {
+        const int64_t begin = traceNowUs();
+        f();
+        best = std::min(best, traceNowUs() - begin);
+    }
+    return best / 1e3;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    int repeat = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        std::cerr << "用法: jpeg_bench <a.jpg> [b.jpg ...] [-n 次数]\n";
+        return 2;
+    }
+
+    std::printf("线程数 %d，每项取 %d 次中最快的一次\n", parallelThreads(), repeat);
+    std::printf("%-28s %11s %8s %10s %10s %8s  %s\n", "文件", "尺寸", "MB", "stb(ms)", "并行(ms)", "加速", "结果");
+    int failed = 0;
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        int w = 0, h = 0, c = 0;
+        unsigned char* reference = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &w, &h, &c, 0);
+        if (!reference) {
+            std::cerr << "无法解码: " << path << "\n";
+            ++failed;
+            continue;
+        }
+        const double stbMs = bestMs(repeat, [&] {
+            int x, y, n;
+            stbi_image_free(stbi_load_from_memory(bytes.data(), (int)bytes.size(), &x, &y, &n, 0));
+        });
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%dx%dx%d", w, h, c);
+        Image img;
+        if (!decodeJpegParallel(bytes.data(), bytes.size(), img)) {
+            std::printf("%-28s %11s %8.1f %10.1f %10s %8s  %s\n", path.c_str(), size, bytes.size() / 1e6, stbMs, "-",
+                        "-", "不能并行 (没有重启标记 / 渐进式 ...)，走 stb");
+        } else {
+            const bool same = img.width == w && img.height == h && img.channels == c &&
+                              std::memcmp(img.data, reference, img.byteSize()) == 0;
+            const double parallelMs = bestMs(repeat, [&] { decodeJpegParallel(bytes.data(), bytes.size(), img); });
+            std::printf("%-28s %11s %8.1f %10.1f %10.1f %7.2fx  %s\n", path.c_str(), size, bytes.size() / 1e6, stbMs,
+                        parallelMs, stbMs / parallelMs, same ? "与 stb 逐字节一致" : "和 stb 结果不同!");
+            if (!same) ++failed;
+        }
+        stbi_image_free(reference);
+    }
+    return failed ? 1 : 0;
+}
@@ -1,13 +1,18 @@
-#include <algorithm>  // 必须引用这个，用于 std::clamp
 #include <chrono>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "rt_vision/color_convert.h"
 #include "rt_vision/image_system.h"
+#include "rt_vision/pixel_expr.h"
+#include "rt_vision/shard.h"
+#include "rt_vision/trace.h"
+#include "rt_vision/warp.h"
 
 namespace fs = std::filesystem;
 
@@ -15,52 +20,32 @@ namespace fs = std::filesystem;
 std::vector<std::string> scannedFiles;
 std::string inputFolder = "train1";
 std::string outputFolder = "processed_images";
+// 有 train1.shard (shard_tool pack 打出来的) 时优先从它读：一次映射，不再逐个打开小文件
+ShardReader inputShard;
 
 void clearScreen() {
     system("clear");
 }
 
-// === 核心算法：数码变焦 (Digital Zoom) ===
-// 找回了这个函数，用来替代普通的 resize
-void digitalZoom(const Image& src, Image& dst, int outW, int outH, float centerX_ratio, float centerY_ratio,
-                 float zoomLevel) {
-    dst.width = outW;
-    dst.height = outH;
-    dst.channels = src.channels;
-
-    // 手动分配内存
-    dst.data = (unsigned char*)malloc(outW * outH * src.channels);
-
-    // 计算裁剪框
-    float cropW = src.width / zoomLevel;
-    float cropH = src.height / zoomLevel;
-
-    // 计算起点 (基于中心点比例)
-    int startX = (int)(src.width * centerX_ratio - cropW / 2);
-    int startY = (int)(src.height * centerY_ratio - cropH / 2);
-
-    for (int y = 0; y < outH; ++y) {
-        for (int x = 0; x < outW; ++x) {
-            // 映射公式
-            int srcX = startX + (int)((float)x / outW * cropW);
-            int srcY = startY + (int)((float)y / outH * cropH);
-
-            // 防止越界 (非常重要)
-            srcX = std::clamp(srcX, 0, src.width - 1);
-            srcY = std::clamp(srcY, 0, src.height - 1);
-
-            for (int c = 0; c < src.channels; ++c) {
-                int dstIndex = (y * outW + x) * src.channels + c;
-                int srcIndex = (srcY * src.width + srcX) * src.channels + c;
-                dst.data[dstIndex] = src.data[srcIndex];
-            }
-        }
-    }
-}
-
 // 1. 扫描功能
 void scanDirectory() {
     scannedFiles.clear();
+    inputShard.close();
+    for (const std::string& shardPath : {inputFolder + ".shard", "../" + inputFolder + ".shard"}) {
+        if (!fs::exists(shardPath)) continue;
+        if (!inputShard.open(shardPath)) {
+            std::cout << "警告：" << inputShard.error() << "，改为扫描文件夹\n";
+            break;
+        }
+        std::cout << "\n读取打包数据集 " << shardPath << " ...\n";
+        for (size_t i = 0; i < inputShard.size(); ++i) {
+            scannedFiles.push_back(inputShard.entry(i).name);
+            std::cout << "[" << i + 1 << "] " << inputShard.entry(i).name << "\n";
+        }
+        std::cout << "共 " << scannedFiles.size() << " 张图片。\n";
+        return;
+    }
+
     std::cout << "\n正在扫描 " << inputFolder << " ...\n";
 
     if (!fs::exists(inputFolder)) inputFolder = "../train1";
@@ -86,6 +71,16 @@ void processSelectedImages(const std::vector<int>& indices, int operationType) {
     if (!fs::exists(outputFolder)) fs::create_directory(outputFolder);
     std::cout << "任务已分发到后台线程...\n";
 
+    // 变焦的坐标表只跟图片尺寸有关，同一批里尺寸相同的图片共用一份
+    std::unique_ptr<ZoomPlan> zoomPlan;
+
+    // 各阶段耗时 / 吞吐量 (trace.h)，批处理结束时打印一行摘要
+    Counter& imagesDone = metrics().counter("images");
+    Counter& decodedBytes = metrics().counter("decoded_bytes");
+    LatencyHistogram& loadLatency = metrics().histogram("load");
+    LatencyHistogram& transformLatency = metrics().histogram("transform");
+    LatencyHistogram& saveLatency = metrics().histogram("save");
+
     for (int idx : indices) {
         int vectorIdx = idx - 1;
         if (vectorIdx < 0 || vectorIdx >= scannedFiles.size()) continue;
@@ -94,18 +89,30 @@ void processSelectedImages(const std::vector<int>& indices, int operationType) {
         std::string fileName = fs::path(srcPath).filename().string();
 
         Image img;
-        if (!img.load(srcPath)) {
+        bool loaded;
+        {
+            TraceSpan span("load", &loadLatency);  // 读文件 + 解码
+            if (inputShard.isOpen())
+                loaded = img.loadFromMemory(inputShard.data(vectorIdx), inputShard.entry(vectorIdx).size, srcPath);
+            else
+                loaded = img.load(srcPath);
+        }
+        if (!loaded) {
             std::cout << "[失败] 无法加载: " << fileName << "\n";
             continue;
         }
+        decodedBytes.add(img.byteSize());
 
         Image outImg;
         std::string suffix = "";
 
+        const int64_t transformBegin = traceNowUs();
         switch (operationType) {
             case 1:  // === 修改处：现在调用数码变焦 ===
-                // 参数：输出 500x500，聚焦中心(0.5, 0.5)，放大 2.0 倍
-                digitalZoom(img, outImg, 500, 500, 0.5f, 0.5f, 2.0f);
+                // 参数：输出 500x500，聚焦中心(0.5, 0.5)，放大 2.0 倍，双线性插值
+                if (!zoomPlan || !zoomPlan->matches(img))
+                    zoomPlan.reset(new ZoomPlan(img.width, img.height, 500, 500, 0.5f, 0.5f, {2.0f}));
+                zoomPlan->apply(img, 0, outImg);
                 suffix = "_zoom.jpg";  // 后缀改叫 zoom
                 break;
             case 2:  // 旋转
@@ -116,9 +123,26 @@ void processSelectedImages(const std::vector<int>& indices, int operationType) {
                 resizeImage(img, outImg, img.width, img.height);
                 suffix = ".png";
                 break;
+            case 4:  // 灰度 (16 位 / HDR 图先转成 8 位，带透明通道的 PNG 先去掉 alpha)
+                if (img.type != PixelType::kU8) convertDepth(img, img, PixelType::kU8);
+                if (img.channels == 4) convertColor(img, img, ColorConversion::kRgbaToRgb);
+                if (!convertColor(img, outImg, ColorConversion::kRgbToGray)) {
+                    std::cout << "[失败] 不支持的通道数: " << fileName << "\n";
+                    continue;
+                }
+                suffix = "_gray.jpg";
+                break;
+            case 5:  // 增强：对比度 x1.2、亮度 +10，一次遍历完成
+                if (img.type != PixelType::kU8) convertDepth(img, img, PixelType::kU8);
+                px::evaluate(px::clamp(px::in(img) * 1.2f + 10), outImg);
+                suffix = "_enhance.jpg";
+                break;
             default:
                 return;
         }
+        const int64_t transformEnd = traceNowUs();
+        transformLatency.record(transformEnd - transformBegin);
+        traceComplete("transform", transformBegin, transformEnd);
 
         // 保存逻辑
         std::string outPath;
@@ -129,7 +153,13 @@ void processSelectedImages(const std::vector<int>& indices, int operationType) {
             outPath = outputFolder + "/processed_" + fileName + suffix;
         }
 
-        if (outImg.save(outPath)) {
+        bool saved;
+        {
+            TraceSpan span("save", &saveLatency);  // 编码 + 写文件
+            saved = outImg.save(outPath);
+        }
+        if (saved) {
+            imagesDone.add();
             std::cout << "[成功] " << fileName << " -> " << suffix << "\n";
         }
 
@@ -138,10 +168,12 @@ void processSelectedImages(const std::vector<int>& indices, int operationType) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     std::cout << "全部处理完成！\n";
+    metrics().report(std::cout, true);
 }
 
 int main() {
     clearScreen();
+    setTraceThreadName("main");
 
     while (true) {
         std::cout << "\n=== 智能图片管理系统 (无库版 / VS Code) ===\n";
@@ -176,7 +208,7 @@ int main() {
             if (selectedIndices.empty()) continue;
 
             // 这里的文案修改了，更准确
-            std::cout << "选择操作: 1.放大(聚焦中心)  2.旋转  3.转格式\n";
+            std::cout << "选择操作: 1.放大(聚焦中心)  2.旋转  3.转格式  4.灰度  5.增强\n";
             int opType;
             std::cin >> opType;
             processSelectedImages(selectedIndices, opType);
@@ -184,5 +216,9 @@ int main() {
             break;
         }
     }
+
+    // RT_VISION_TRACE=trace.json 时导出时间线，用 ui.perfetto.dev 打开
+    if (!traceOutputPath().empty() && writeChromeTrace(traceOutputPath()))
+        std::cout << "时间线已写入 " << traceOutputPath() << "\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+// shard 打包 / 解包工具
+//   shard_tool pack   <图片文件夹> <输出.shard> [对齐字节数]
+//   shard_tool unpack <输入.shard> <输出文件夹>
+//   shard_tool list   <输入.shard>
+//   shard_tool verify <输入.shard>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "rt_vision/image_system.h"
+#include "rt_vision/shard.h"
+
+namespace fs = std::filesystem;
+
+static bool isImageFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".hdr";
+}
+
+static int pack(const std::string& dir, const std::string& out, uint32_t alignment) {
+    // 按文件名排序，同一个文件夹打出来的 shard 内容固定
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.is_regular_file() && isImageFile(entry.path())) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    ShardWriter writer;
+    if (!writer.open(out, alignment)) {
+        std::cerr << writer.error() << "\n";
+        return 1;
+    }
+    std::vector<unsigned char> bytes;
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        int w = 0, h = 0, c = 0;
+        if (!imageInfo(bytes.data(), bytes.size(), w, h, c)) std::cerr << "警告: 无法识别 " << path << "\n";
+        if (!writer.add(path.filename().string(), bytes.data(), bytes.size(), w, h, c)) {
+            std::cerr << writer.error() << "\n";
+            return 1;
+        }
+    }
+    if (!writer.finish()) {
+        std::cerr << writer.error() << "\n";
+        return 1;
+    }
+    std::cout << "已打包 " << writer.count() << " 张图片 -> " << out << "\n";
+    return 0;
+}
+
+// 索引里的名字来自文件本身，不能信：绝对路径、带 .. 的路径会写到输出文件夹外面去
+static bool isSafeEntryName(const std::string& name) {
+    if (name.empty() || name.find('\0') != std::string::npos) return false;
+    const fs::path path(name);
+    if (path.is_absolute() || path.has_root_name() || path.has_root_directory()) return false;
+    for (const auto& part : path) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+static int unpack(const ShardReader& reader, const std::string& dir) {
+    for (size_t i = 0; i < reader.size(); ++i) {
+        if (!isSafeEntryName(reader.entry(i).name)) {
+            std::cerr << "拒绝解包: 文件名不安全 \"" << reader.entry(i).name << "\"\n";
+            return 1;
+        }
+    }
+    fs::create_directories(dir);
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const ShardEntry& e = reader.entry(i);
+        const fs::path target = fs::path(dir) / e.name;
+        if (target.has_parent_path()) fs::create_directories(target.parent_path());
+        std::ofstream out(target, std::ios::binary);
+        if (!out.write(reinterpret_cast<const char*>(reader.data(i)), (std::streamsize)e.size)) {
+            std::cerr << "写入失败: " << e.name << "\n";
+            return 1;
+        }
+    }
+    std::cout << "已解包 " << reader.size() << " 张图片 -> " << dir << "\n";
+    return 0;
+}
+
+static int list(const ShardReader& reader) {
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const ShardEntry& e = reader.entry(i);
+        std::cout << e.name << "  " << e.width << "x" << e.height << "x" << e.channels << "  " << e.size
+                  << " bytes @" << e.offset << "\n";
+    }
+    return 0;
+}
+
+static int verify(const ShardReader& reader) {
+    int bad = 0;
+    for (size_t i = 0; i < reader.size(); ++i) {
+        if (!reader.verify(i)) {
+            std::cerr << "校验失败: " << reader.entry(i).name << "\n";
+            ++bad;
+        }
+    }
+    std::cout << reader.size() - bad << "/" << reader.size() << " 校验通过\n";
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    const std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd == "pack" && argc >= 4) {
+        return pack(argv[2], argv[3], argc > 4 ? (uint32_t)std::stoul(argv[4]) : 4096);
+    }
+    if ((cmd == "unpack" && argc >= 4) || ((cmd == "list" || cmd == "verify") && argc >= 3)) {
+        ShardReader reader;
+        if (!reader.open(argv[2])) {
+            std::cerr << reader.error() << "\n";
+            return 1;
+        }
+        if (cmd == "unpack") return unpack(reader, argv[3]);
+        if (cmd == "list") return list(reader);
+        return verify(reader);
+    }
+    std::cerr << "用法:\n"
+              << "  shard_tool pack   <图片文件夹> <输出.shard> [对齐字节数]\n"
+              << "  shard_tool unpack <输入.shard> <输出文件夹>\n"
+              << "  shard_tool list   <输入.shard>\n"
+              << "  shard_tool verify <输入.shard>\n";
+    return 2;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "rt_vision/image_system.h"
+
+// === 颜色空间转换 ===
+// 逐像素的转换内核，结果和 OpenCV cvtColor 的 8 位版本逐字节一致 (同样的定点系数和舍入)，
+// 可以直接替换 opencv 作业里的 COLOR_BGR2GRAY / COLOR_BGR2HSV。
+// 有 AVX2 / SSE4.1 时自动走 SIMD 实现，否则走普通实现，两者结果相同。
+//
+// 约定：src / dst 都是紧密排列的像素 (行与行之间没有填充)，count 是像素个数。
+// 注意 stbi_load 读出来的是 RGB 顺序，OpenCV 的 imread 是 BGR 顺序。
+
+// 灰度：Y = 0.299 R + 0.587 G + 0.114 B (15 位定点)
+void bgrToGray(const uint8_t* src, uint8_t* dst, size_t count);
+void rgbToGray(const uint8_t* src, uint8_t* dst, size_t count);
+
+// HSV：H 范围 0..179 (和 OpenCV 一样除以 2 存进一个字节)，S / V 范围 0..255
+void bgrToHsv(const uint8_t* src, uint8_t* dst, size_t count);
+void rgbToHsv(const uint8_t* src, uint8_t* dst, size_t count);
+
+// 转 HSV 的同时做 inRange，不保存 HSV 图：lower <= (H,S,V) <= upper 的像素 mask 为 255，否则为 0
+void bgrHsvInRange(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3], const uint8_t upper[3]);
+void rgbHsvInRange(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3], const uint8_t upper[3]);
+
+// RGB <-> BGR (交换第 0、2 通道)，src 和 dst 可以是同一块内存
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t count);
+
+// RGBA -> RGB (丢掉 alpha)，RGB -> RGBA (alpha 填固定值)
+void rgbaToRgb(const uint8_t* src, uint8_t* dst, size_t count);
+void rgbToRgba(const uint8_t* src, uint8_t* dst, size_t count, uint8_t alpha = 255);
+
+// NV12 (摄像头 / 硬件解码器常用)：先是 width*height 的 Y 平面，再是 (width/2)*(height/2) 组交错的 U,V
+// BT.601 有限范围，和 OpenCV 的 COLOR_YUV2RGB_NV12 / COLOR_YUV2BGR_NV12 一致；width、height 必须是偶数
+void nv12ToRgb(const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst);
+void nv12ToBgr(const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst);
+
+// === Image 版本 ===
+// Image 是 stbi_load 读出来的，默认按 RGB / RGBA 顺序解释
+enum class ColorConversion {
+    kRgbToGray,  // 3 通道 -> 1 通道
+    kRgbToHsv,   // 3 通道 -> 3 通道
+    kRgbToBgr,   // 3 通道 -> 3 通道 (反过来也是同一个操作)
+    kRgbaToRgb,  // 4 通道 -> 3 通道
+    kRgbToRgba,  // 3 通道 -> 4 通道
+};
+
+// 通道数不符合要求时返回 false，dst 不变；dst 可以和 src 是同一个对象
+bool convertColor(const Image& src, Image& dst, ColorConversion code);
@@ -0,0 +1,11 @@
+#pragma once
+
+// === 运行时指令集检测 ===
+// SIMD 内核在第一次调用时根据这里的结果选择实现 (AVX2 / SSE4.1 / 普通 C++)。
+// 设置环境变量 RT_VISION_DISABLE_SIMD=1 可以强制走普通实现，=avx2 只关掉 AVX2 (走 SSE4.1)，方便对比结果和性能。
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx2 = false;
+};
+
+const CpuFeatures& cpuFeatures();
@@ -1,23 +1,45 @@
 #pragma once
+#include <cstddef>
 #include <string>
 
+// 每个通道的数据类型：普通图片是 8 位；16 位 PNG 读成 kU16 (0..65535)；
+// Radiance HDR 读成 kF32 (线性亮度，可能大于 1)。stbi_load 只有 8 位，高位深的扫描件会被截断。
+enum class PixelType { kU8, kU16, kF32 };
+
+int bytesPerChannel(PixelType type);
+
 class Image {
 public:
     int width = 0;
     int height = 0;
     int channels = 0;
-    unsigned char* data = nullptr;
+    PixelType type = PixelType::kU8;
+    unsigned char* data = nullptr;  // 按 type 解释，紧密排列，没有行填充
 
     Image();
     ~Image();
 
     bool load(const std::string& filename);
+    // 从内存里的文件内容解码 (比如 shard 里映射出来的一段)，name 只用于报错
+    bool loadFromMemory(const unsigned char* bytes, size_t size, const std::string& name = "");
     bool save(const std::string& filename) const;
+
+    size_t pixelBytes() const { return (size_t)channels * bytesPerChannel(type); }
+    size_t byteSize() const { return pixelBytes() * width * height; }
+
+    // 接管一块 malloc 出来的内存并释放原来的 (先算出新数据再调用，所以输出可以覆盖输入)
+    void adopt(unsigned char* newData, int w, int h, int c, PixelType t);
 };
 
+// 只解析文件头取尺寸和通道数，不解码
+bool imageInfo(const unsigned char* bytes, size_t size, int& width, int& height, int& channels);
+
 // === 新增：图像处理算法声明 ===
 // 1. 调整大小 (Resize)
 void resizeImage(const Image& src, Image& dst, int newW, int newH);
 
 // 2. 旋转 90 度 (Rotate)
-void rotateImage90(const Image& src, Image& dst);
\ No newline at end of file
+void rotateImage90(const Image& src, Image& dst);
+
+// 3. 位深转换：整数之间按满量程缩放 (8 位 255 <-> 16 位 65535)，浮点用 0..1 表示满量程，转整数时截断到范围内
+bool convertDepth(const Image& src, Image& dst, PixelType type);
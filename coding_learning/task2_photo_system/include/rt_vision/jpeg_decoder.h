@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+#include "rt_vision/image_system.h"
+
+// === 按重启间隔并行解码 JPEG ===
+// stbi_load 解一张 5000 万 ~ 1 亿像素的 JPEG 只用一个线程，批处理的尾巴全卡在这一张上。
+// 带重启标记的 JPEG (文件头里有 DRI，熵编码数据每隔 N 个 MCU 插一个 RSTn) 每段都从零开始解码
+// (DC 预测清零、比特流重新对齐)，所以可以先扫出所有 RSTn 的位置，各段交给不同线程做霍夫曼解码 + 反量化 + IDCT，
+// 再按行带并行做色度上采样和 YCbCr -> RGB。
+//
+// 各个内核直接用 stb_image 里的 (同一份 stb_image.h，只编译 JPEG 部分)，结果和 stbi_load(..., 0) 逐字节一致。
+// 只处理最常见的情况：基线 / 扩展霍夫曼 (SOF0 / SOF1)、8 位、1 或 3 个分量、一个交织的扫描、有 DRI 且 RSTn 数目对得上。
+// 其余情况 (渐进式、没有重启标记、多扫描、CMYK、数据损坏 ...) 返回 false，由调用方退回 stbi_load。
+
+// 成功时把解码结果交给 dst (8 位，1 或 3 通道)
+bool decodeJpegParallel(const unsigned char* bytes, size_t size, Image& dst);
@@ -0,0 +1,12 @@
+#pragma once
+#include <functional>
+
+// === 按行带并行 ===
+// 把 [0, rows) 切成几段连续的行 (行带)，交给常驻的线程池执行 body(begin, end)，调用线程也领一份，
+// 全部行带完成后才返回。每个行带只写自己那几行，内核不需要加锁。
+// 线程数默认是硬件线程数，环境变量 RT_VISION_THREADS 可以覆盖 (=1 时完全串行，方便对比)。
+// 在 body 里嵌套调用、或者线程池正被别的线程占用时，直接在当前线程串行执行，不会死锁。
+void parallelForRows(int rows, const std::function<void(int, int)>& body, int minRowsPerBand = 16);
+
+// 参与计算的线程数 (包括调用线程)
+int parallelThreads();
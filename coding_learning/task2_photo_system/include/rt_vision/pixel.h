@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+
+#include "rt_vision/image_system.h"
+
+// === 编译期确定通道数和类型的像素 ===
+// 内核写成 template <typename P> 的形式，通道循环的次数 P::kChannels 是常量，编译器会完全展开并向量化；
+// 运行时的 Image 在每次调用时用 visitPixel 按 (通道数, 类型) 选一次实例，不在逐像素循环里判断。
+template <int N, typename T>
+struct Pixel {
+    static constexpr int kChannels = N;
+    using Type = T;
+
+    T v[N];
+
+    T& operator[](int i) { return v[i]; }
+    const T& operator[](int i) const { return v[i]; }
+};
+
+template <typename T>
+struct PixelTraits;
+
+template <>
+struct PixelTraits<uint8_t> {
+    static constexpr PixelType kType = PixelType::kU8;
+    static constexpr float kMax = 255.0f;
+};
+
+template <>
+struct PixelTraits<uint16_t> {
+    static constexpr PixelType kType = PixelType::kU16;
+    static constexpr float kMax = 65535.0f;
+};
+
+template <>
+struct PixelTraits<float> {
+    static constexpr PixelType kType = PixelType::kF32;
+    static constexpr float kMax = 1.0f;
+};
+
+// 传给 visitPixel 回调的标签，回调里用 typename decltype(tag)::type 取出像素类型
+template <typename P>
+struct PixelTag {
+    using type = P;
+};
+
+template <typename T, typename F>
+bool visitChannels(int channels, F&& f) {
+    switch (channels) {
+        case 1: f(PixelTag<Pixel<1, T>>()); return true;
+        case 2: f(PixelTag<Pixel<2, T>>()); return true;
+        case 3: f(PixelTag<Pixel<3, T>>()); return true;
+        case 4: f(PixelTag<Pixel<4, T>>()); return true;
+        default: return false;
+    }
+}
+
+// 支持 1..4 通道 x (uint8 / uint16 / float)，不支持的组合返回 false
+template <typename F>
+bool visitPixel(int channels, PixelType type, F&& f) {
+    switch (type) {
+        case PixelType::kU8: return visitChannels<uint8_t>(channels, f);
+        case PixelType::kU16: return visitChannels<uint16_t>(channels, f);
+        case PixelType::kF32: return visitChannels<float>(channels, f);
+    }
+    return false;
+}
+
+template <typename F>
+bool visitPixel(const Image& img, F&& f) {
+    return visitPixel(img.channels, img.type, f);
+}
+
+template <typename P>
+const P* pixelsOf(const Image& img) {
+    return reinterpret_cast<const P*>(img.data);
+}
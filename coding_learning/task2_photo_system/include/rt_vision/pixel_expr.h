@@ -0,0 +1,384 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "rt_vision/image_system.h"
+#include "rt_vision/parallel.h"
+#include "rt_vision/pixel.h"
+
+// === 逐像素表达式 (惰性求值 + 融合) ===
+// 多步的逐像素调整如果一步一个函数，每一步都要把整张图读写一遍、再多一张临时图。这里的运算符只构造表达式树
+// (编译期的类型)，px::evaluate 时整棵树内联成一个循环：每个像素只读一次输入、写一次输出，中间值都在寄存器里，
+// 编译器可以把这个循环向量化；再按行带交给 parallelForRows 多线程执行。
+//
+//     Image mask;
+//     px::evaluate(px::clamp(px::in(gray) * 1.2f + 10) > 128, mask);              // 对比度 + 亮度 + 二值化
+//     px::evaluate(px::channel(rgb, 0) * 0.5f + px::channel(rgb, 1) * 0.5f, rg);   // 通道混合
+//
+// 约定：
+// - 中间值都是 float，数值就是输入的原始值 (8 位是 0..255，16 位 0..65535，float 图 0..1)；
+// - 比较 / inRange / 逻辑运算的结果和 OpenCV 的 mask 一样是 255 / 0，select 把非 0 当作真；
+// - 所有图像输入的宽高必须相同，通道数为 1 的输入广播到每个输出通道，其余输入的通道数必须等于输出通道数；
+// - 写回整数类型时四舍五入并截断到类型范围，NaN 写成 0。
+namespace px {
+
+struct ExprBase {};
+
+template <typename E>
+constexpr bool kIsExpr = std::is_base_of_v<ExprBase, E>;
+
+// 遍历表达式树收集的输入形状
+struct Shape {
+    int width = -1;
+    int height = -1;
+    int channels = 1;        // 非广播输入的通道数
+    bool broadcast = false;  // 有没有需要广播的单通道输入
+    bool ok = true;
+
+    void add(bool valid, int w, int h, int c) {
+        if (!valid) ok = false;
+        if (width < 0) {
+            width = w;
+            height = h;
+        } else if (w != width || h != height) {
+            ok = false;
+        }
+        if (c == 1) {
+            broadcast = true;
+        } else if (channels == 1) {
+            channels = c;
+        } else if (c != channels) {
+            ok = false;
+        }
+    }
+};
+
+// === 叶子节点 ===
+// eval<CN, kBroadcast>(p, c)：第 p 个像素、第 c 个输出通道的值。没有广播输入时 kBroadcast 为 false，
+// 图像输入的下标就是 p * CN + c，循环里没有分支。
+struct Constant : ExprBase {
+    float value;
+
+    explicit Constant(float v) : value(v) {}
+    void shape(Shape&) const {}
+    template <int CN, bool kBroadcast>
+    float eval(size_t, int) const {
+        return value;
+    }
+};
+
+template <typename T>
+struct ImageRef : ExprBase {
+    const T* data;
+    int width, height, channels;
+
+    explicit ImageRef(const Image& img)
+        : data(img.type == PixelTraits<T>::kType ? reinterpret_cast<const T*>(img.data) : nullptr),
+          width(img.width),
+          height(img.height),
+          channels(img.channels) {}
+    void shape(Shape& s) const { s.add(data != nullptr, width, height, channels); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        if constexpr (CN == 1) {
+            return (float)data[p];
+        } else if constexpr (kBroadcast) {
+            return channels == 1 ? (float)data[p] : (float)data[p * CN + c];
+        } else {
+            return (float)data[p * CN + c];
+        }
+    }
+};
+
+// 取出某一个通道，当作单通道输入 (会广播到每个输出通道)
+template <typename T>
+struct ChannelRef : ExprBase {
+    const T* data;
+    int width, height, channels, index;
+
+    ChannelRef(const Image& img, int k)
+        : data(img.type == PixelTraits<T>::kType ? reinterpret_cast<const T*>(img.data) : nullptr),
+          width(img.width),
+          height(img.height),
+          channels(img.channels),
+          index(k) {}
+    void shape(Shape& s) const { s.add(data != nullptr && index >= 0 && index < channels, width, height, 1); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int) const {
+        return (float)data[p * channels + index];
+    }
+};
+
+// === 运算 ===
+// 写成不带分支的形式 (min / max / 条件选择)，编译器能生成向量指令
+namespace op {
+struct Add { static float apply(float a, float b) { return a + b; } };
+struct Sub { static float apply(float a, float b) { return a - b; } };
+struct Mul { static float apply(float a, float b) { return a * b; } };
+struct Div { static float apply(float a, float b) { return a / b; } };
+struct Min { static float apply(float a, float b) { return std::min(a, b); } };
+struct Max { static float apply(float a, float b) { return std::max(a, b); } };
+struct Greater { static float apply(float a, float b) { return a > b ? 255.0f : 0.0f; } };
+struct Less { static float apply(float a, float b) { return a < b ? 255.0f : 0.0f; } };
+struct GreaterEq { static float apply(float a, float b) { return a >= b ? 255.0f : 0.0f; } };
+struct LessEq { static float apply(float a, float b) { return a <= b ? 255.0f : 0.0f; } };
+struct Equal { static float apply(float a, float b) { return a == b ? 255.0f : 0.0f; } };
+struct NotEqual { static float apply(float a, float b) { return a != b ? 255.0f : 0.0f; } };
+struct And { static float apply(float a, float b) { return (a != 0.0f) & (b != 0.0f) ? 255.0f : 0.0f; } };
+struct Or { static float apply(float a, float b) { return (a != 0.0f) | (b != 0.0f) ? 255.0f : 0.0f; } };
+
+struct Neg { static float apply(float a) { return -a; } };
+struct Abs { static float apply(float a) { return std::fabs(a); } };
+struct Sqrt { static float apply(float a) { return std::sqrt(a); } };
+struct Not { static float apply(float a) { return a != 0.0f ? 0.0f : 255.0f; } };
+}  // namespace op
+
+template <typename Op, typename E>
+struct Unary : ExprBase {
+    E e;
+
+    explicit Unary(const E& x) : e(x) {}
+    void shape(Shape& s) const { e.shape(s); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        return Op::apply(e.template eval<CN, kBroadcast>(p, c));
+    }
+};
+
+template <typename Op, typename L, typename R>
+struct Binary : ExprBase {
+    L l;
+    R r;
+
+    Binary(const L& a, const R& b) : l(a), r(b) {}
+    void shape(Shape& s) const {
+        l.shape(s);
+        r.shape(s);
+    }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        return Op::apply(l.template eval<CN, kBroadcast>(p, c), r.template eval<CN, kBroadcast>(p, c));
+    }
+};
+
+template <typename E>
+struct Clamp : ExprBase {
+    E e;
+    float lo, hi;
+
+    Clamp(const E& x, float l, float h) : e(x), lo(l), hi(h) {}
+    void shape(Shape& s) const { e.shape(s); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        return std::min(std::max(e.template eval<CN, kBroadcast>(p, c), lo), hi);
+    }
+};
+
+template <typename E>
+struct InRange : ExprBase {
+    E e;
+    float lo, hi;
+
+    InRange(const E& x, float l, float h) : e(x), lo(l), hi(h) {}
+    void shape(Shape& s) const { e.shape(s); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        const float v = e.template eval<CN, kBroadcast>(p, c);
+        return (v >= lo) & (v <= hi) ? 255.0f : 0.0f;
+    }
+};
+
+// std::pow 没法向量化，gamma 这类调整对 8 位图更适合查表；这里保留给 float 图和不常用的场景
+template <typename E>
+struct Pow : ExprBase {
+    E e;
+    float exponent;
+
+    Pow(const E& x, float k) : e(x), exponent(k) {}
+    void shape(Shape& s) const { e.shape(s); }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        return std::pow(std::max(e.template eval<CN, kBroadcast>(p, c), 0.0f), exponent);
+    }
+};
+
+template <typename M, typename A, typename B>
+struct Select : ExprBase {
+    M m;
+    A a;
+    B b;
+
+    Select(const M& mask, const A& x, const B& y) : m(mask), a(x), b(y) {}
+    void shape(Shape& s) const {
+        m.shape(s);
+        a.shape(s);
+        b.shape(s);
+    }
+    template <int CN, bool kBroadcast>
+    float eval(size_t p, int c) const {
+        const float x = a.template eval<CN, kBroadcast>(p, c);
+        const float y = b.template eval<CN, kBroadcast>(p, c);
+        return m.template eval<CN, kBroadcast>(p, c) != 0.0f ? x : y;
+    }
+};
+
+// === 构造表达式 ===
+// 数字自动包成 Constant，表达式原样保留
+template <typename T>
+auto wrap(const T& v) {
+    if constexpr (kIsExpr<T>) {
+        return v;
+    } else {
+        return Constant((float)v);
+    }
+}
+
+template <typename T>
+using Wrapped = decltype(wrap(std::declval<T>()));
+
+// 至少一边是表达式、另一边是表达式或数字时才参与重载，不影响其他类型的运算符
+template <typename L, typename R>
+using EnableBinary = std::enable_if_t<(kIsExpr<L> || kIsExpr<R>) && (kIsExpr<L> || std::is_arithmetic_v<L>) &&
+                                      (kIsExpr<R> || std::is_arithmetic_v<R>)>;
+
+#define RTV_PX_BINARY(symbol, Op)                                       \
+    template <typename L, typename R, typename = EnableBinary<L, R>>     \
+    auto symbol(const L& l, const R& r) {                                \
+        return Binary<op::Op, Wrapped<L>, Wrapped<R>>(wrap(l), wrap(r)); \
+    }
+
+RTV_PX_BINARY(operator+, Add)
+RTV_PX_BINARY(operator-, Sub)
+RTV_PX_BINARY(operator*, Mul)
+RTV_PX_BINARY(operator/, Div)
+RTV_PX_BINARY(operator>, Greater)
+RTV_PX_BINARY(operator<, Less)
+RTV_PX_BINARY(operator>=, GreaterEq)
+RTV_PX_BINARY(operator<=, LessEq)
+RTV_PX_BINARY(operator==, Equal)
+RTV_PX_BINARY(operator!=, NotEqual)
+RTV_PX_BINARY(operator&&, And)
+RTV_PX_BINARY(operator||, Or)
+RTV_PX_BINARY(min, Min)
+RTV_PX_BINARY(max, Max)
+
+#undef RTV_PX_BINARY
+
+template <typename E, typename = std::enable_if_t<kIsExpr<E>>>
+auto operator-(const E& e) {
+    return Unary<op::Neg, E>(e);
+}
+
+template <typename E, typename = std::enable_if_t<kIsExpr<E>>>
+auto operator!(const E& e) {
+    return Unary<op::Not, E>(e);
+}
+
+// 图像输入：类型参数必须和图像的 PixelType 一致，否则 evaluate 返回 false
+template <typename T = uint8_t>
+ImageRef<T> in(const Image& img) {
+    return ImageRef<T>(img);
+}
+
+template <typename T = uint8_t>
+ChannelRef<T> channel(const Image& img, int k) {
+    return ChannelRef<T>(img, k);
+}
+
+template <typename E>
+auto abs(const E& e) {
+    return Unary<op::Abs, Wrapped<E>>(wrap(e));
+}
+
+template <typename E>
+auto sqrt(const E& e) {
+    return Unary<op::Sqrt, Wrapped<E>>(wrap(e));
+}
+
+template <typename E>
+auto pow(const E& e, float exponent) {
+    return Pow<Wrapped<E>>(wrap(e), exponent);
+}
+
+// 默认截断到 8 位的范围
+template <typename E>
+auto clamp(const E& e, float lo = 0.0f, float hi = 255.0f) {
+    return Clamp<Wrapped<E>>(wrap(e), lo, hi);
+}
+
+// lo <= v <= hi 时为 255；多通道时每个通道单独判断，要求所有通道都满足就用 && 把各通道的结果连起来
+template <typename E>
+auto inRange(const E& e, float lo, float hi) {
+    return InRange<Wrapped<E>>(wrap(e), lo, hi);
+}
+
+template <typename M, typename A, typename B>
+auto select(const M& mask, const A& a, const B& b) {
+    return Select<Wrapped<M>, Wrapped<A>, Wrapped<B>>(wrap(mask), wrap(a), wrap(b));
+}
+
+// === 求值 ===
+namespace detail {
+
+template <typename T>
+T store(float v) {
+    if constexpr (std::is_same_v<T, float>) {
+        return v;
+    } else {
+        // NaN (sqrt / pow 负数、0/0) 和负数一样记为 0：v > 0 对 NaN 为假，(int)NaN 是未定义行为
+        v = v > 0.0f ? v : 0.0f;
+        return (T)(int)(std::min(v, PixelTraits<T>::kMax) + 0.5f);
+    }
+}
+
+template <int CN, bool kBroadcast, typename T, typename E>
+void run(const E& expr, T* out, size_t begin, size_t end) {
+    // 复制一份到局部变量：写 uint8_t 的输出在编译器看来可能改到表达式里的指针和常数，
+    // 局部副本的地址不外泄，这些值才能留在寄存器里，循环才能向量化
+    const E e = expr;
+    for (size_t p = begin; p < end; ++p) {
+        for (int c = 0; c < CN; ++c) out[p * CN + c] = store<T>(e.template eval<CN, kBroadcast>(p, c));
+    }
+}
+
+}  // namespace detail
+
+// 把表达式算成一张新图：channels 为 0 时取输入的通道数；输入尺寸 / 类型不一致、没有图像输入时返回 false，dst 不变。
+// 总是写进新分配的内存，dst 可以是表达式里的某个输入。
+template <typename E, typename = std::enable_if_t<kIsExpr<E>>>
+bool evaluate(const E& e, Image& dst, int channels = 0, PixelType type = PixelType::kU8) {
+    Shape s;
+    e.shape(s);
+    if (!s.ok || s.width <= 0 || s.height <= 0) return false;
+    if (channels == 0) channels = s.channels;
+    if (s.channels != 1 && s.channels != channels) return false;
+
+    const int width = s.width, height = s.height;
+    unsigned char* out = (unsigned char*)malloc((size_t)width * height * channels * bytesPerChannel(type));
+    const bool ok = visitPixel(channels, type, [&](auto tag) {
+        using P = typename decltype(tag)::type;
+        using T = typename P::Type;
+        constexpr int cn = P::kChannels;
+        T* o = reinterpret_cast<T*>(out);
+        // 行带 [y0, y1) 在紧密排列的图里就是连续的像素区间
+        parallelForRows(height, [&](int y0, int y1) {
+            const size_t begin = (size_t)y0 * width, end = (size_t)y1 * width;
+            if (s.broadcast && cn > 1)
+                detail::run<cn, true>(e, o, begin, end);
+            else
+                detail::run<cn, false>(e, o, begin, end);
+        });
+    });
+    if (!ok) {
+        free(out);
+        return false;
+    }
+    dst.adopt(out, width, height, channels, type);
+    return true;
+}
+
+}  // namespace px
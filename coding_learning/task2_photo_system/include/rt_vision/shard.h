@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// === 打包数据集 (shard) ===
+// train1 这种文件夹里是成千上万张小 JPEG，逐个 open / stat / read 的开销比解码还大。
+// shard 把整个文件夹拼成一个大文件，读的时候 mmap 一次，之后每张图只是一段内存 (顺序读，没有系统调用)。
+//
+// 文件布局 (小端)：
+//   [头 64 字节] magic "RTVSHRD1" | version | count | alignment | indexOffset | indexSize
+//   [数据] 每张图的原始文件内容 (JPEG / PNG 字节，不重新编码)，起始位置按 alignment 对齐
+//   [索引] count 条：offset | size | hash | width | height | channels | nameLen | name
+// 索引放在最后，打包时可以边读边写，不用提前知道总数。hash 是内容的 FNV-1a 64，用来校验。
+
+struct ShardEntry {
+    std::string name;     // 原来的文件名 (不含目录)
+    uint64_t offset = 0;  // 数据在 shard 里的位置
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    int width = 0;  // 打包时从文件头读出来的尺寸，不知道时为 0
+    int height = 0;
+    int channels = 0;
+};
+
+uint64_t shardHash(const void* data, size_t size);
+
+class ShardWriter {
+public:
+    ShardWriter() = default;
+    ~ShardWriter();
+
+    ShardWriter(const ShardWriter&) = delete;
+    ShardWriter& operator=(const ShardWriter&) = delete;
+
+    // alignment 必须是 2 的幂，默认按页对齐
+    bool open(const std::string& path, uint32_t alignment = 4096);
+    bool add(const std::string& name, const void* data, size_t size, int width = 0, int height = 0,
+             int channels = 0);
+    // 写索引并回填文件头，之后 shard 才能被读取
+    bool finish();
+
+    size_t count() const { return entries_.size(); }
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+
+    FILE* file_ = nullptr;
+    uint32_t alignment_ = 4096;
+    uint64_t position_ = 0;
+    std::vector<ShardEntry> entries_;
+    std::string error_;
+};
+
+// 只读映射整个 shard；data(i) 指向映射的内存，reader 存活期间一直有效
+class ShardReader {
+public:
+    ShardReader() = default;
+    ~ShardReader();
+
+    ShardReader(const ShardReader&) = delete;
+    ShardReader& operator=(const ShardReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    size_t size() const { return entries_.size(); }
+    const ShardEntry& entry(size_t i) const { return entries_[i]; }
+    const uint8_t* data(size_t i) const { return base_ + entries_[i].offset; }
+
+    // 按文件名查找，找不到返回 -1
+    int find(const std::string& name) const;
+    // 重新计算哈希，和索引里的比较
+    bool verify(size_t i) const;
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+
+    const uint8_t* base_ = nullptr;
+    size_t mappedSize_ = 0;
+    void* mapping_ = nullptr;  // Windows 的映射句柄
+    std::vector<ShardEntry> entries_;
+    std::string error_;
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// === 追踪与指标 ===
+// 追踪：每个线程有自己的事件缓冲区 (只有本线程写，写完用一次 release 发布计数，不加锁)，
+// 记录各阶段的起止时间 (load / decode / transform / encode / write / queue_wait ...)，
+// 最后导出成 Chrome trace JSON，用 chrome://tracing 或 ui.perfetto.dev 打开就能看到每个线程的时间线。
+// 指标：计数器 / 仪表 / 延迟直方图都是原子变量，热路径上只有几次原子加；
+// MetricsReporter 在后台线程里定期把速率 (张/秒、字节/秒)、队列深度和延迟分位数打印出来，
+// 逐张图片的日志也交给它输出 (logAsync)，工作线程不再抢着往 stdout 写。
+//
+// 事件名、指标名都必须是字符串字面量 (或者生命周期覆盖整个程序的字符串)，缓冲区里只存指针。
+
+// 单调时钟，微秒
+inline int64_t traceNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 追踪默认关闭，关闭时 TraceSpan 只剩一次原子读取；设置环境变量 RT_VISION_TRACE=文件名 会在启动时打开
+void setTracingEnabled(bool enabled);
+bool tracingEnabled();
+
+// RT_VISION_TRACE 指定的输出文件，没有设置时返回空串
+std::string traceOutputPath();
+
+// 延迟直方图：第 i 个桶是 [2^(i-1), 2^i) 微秒，分位数取桶的上界 (误差不超过 2 倍，够看趋势)
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 40;
+
+    void record(int64_t us);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t maxUs() const { return max_.load(std::memory_order_relaxed); }
+    double meanUs() const;
+    int64_t percentileUs(double p) const;
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> sum_{0};
+    std::atomic<int64_t> max_{0};
+};
+
+// 只增不减的计数 (图片数、字节数)
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// 当前值 + 历史峰值 (队列深度、在途任务数)
+class Gauge {
+public:
+    void add(int64_t delta);
+    void set(int64_t v);
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+    int64_t peak() const { return peak_.load(std::memory_order_relaxed); }
+
+private:
+    void updatePeak(int64_t v);
+
+    std::atomic<int64_t> value_{0};
+    std::atomic<int64_t> peak_{0};
+};
+
+// 作用域计时：析构时把 [构造, 析构) 记进当前线程的追踪缓冲区，给了直方图的话同时记一次延迟
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, LatencyHistogram* histogram = nullptr)
+        : name_(name), histogram_(histogram), begin_(traceNowUs()) {}
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    LatencyHistogram* histogram_;
+    int64_t begin_;
+};
+
+// 起止时间已知的区间 (例如排队等待：入队时间是别的线程记下的)
+void traceComplete(const char* name, int64_t beginUs, int64_t endUs);
+
+// 数值曲线 (Perfetto 里显示成单独的轨道)，比如队列深度
+void traceCounter(const char* name, int64_t value);
+
+// 给当前线程起个名字，显示在时间线上 (追踪关闭时什么也不做)
+void setTraceThreadName(const std::string& name);
+
+// 导出所有线程到目前为止的事件；缓冲区满了之后新的事件会被丢弃 (导出时会注明丢了多少)
+bool writeChromeTrace(const std::string& path);
+
+// 按名字取指标，第一次用到时创建，返回的引用一直有效 (取一次缓存起来，热路径上不要反复查)
+class Metrics {
+public:
+    Counter& counter(const char* name);
+    Gauge& gauge(const char* name);
+    LatencyHistogram& histogram(const char* name);
+
+    // 打印一行摘要：计数器给出自上次 report 以来的速率 (字节类的计数器名以 "bytes" 结尾时按 MB/s 显示)
+    // 返回 false 表示和上次相比没有任何变化，什么也没打印
+    bool report(std::ostream& os, bool force = false);
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms_;
+    std::map<std::string, uint64_t> lastCounts_;
+    int64_t lastReportUs_ = traceNowUs();
+};
+
+Metrics& metrics();
+
+// 异步日志：只把字符串放进队列 (临界区里没有 IO)，由 flushLog / MetricsReporter 统一输出
+void logAsync(std::string line);
+void flushLog(std::ostream& os);
+
+// 后台线程：每隔 interval 输出积压的日志和一行指标摘要 (没有变化时不输出，不会刷屏)
+class MetricsReporter {
+public:
+    MetricsReporter(std::ostream& os, std::chrono::milliseconds interval);
+    ~MetricsReporter();
+
+    MetricsReporter(const MetricsReporter&) = delete;
+    MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+private:
+    void loop();
+
+    std::ostream& os_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
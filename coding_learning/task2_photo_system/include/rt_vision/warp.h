@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "rt_vision/image_system.h"
+
+// === 几何变换：裁剪缩放 / 数码变焦 / 仿射 ===
+// 裁剪缩放是可分离的：输出的每一列对应固定的源列，每一行对应固定的源行，
+// 所以坐标和插值权重只在建表时算一次 (ScaleMap)，逐像素循环里只剩查表和定点乘加，
+// 没有浮点除法，也不需要 clamp —— 超出源图的少数边缘列单独处理。
+// 插值权重是 11 位定点数，双线性先做水平方向 (结果按源行缓存，放大时相邻输出行共用)，
+// 再做垂直方向 (8 位图用 SSE4.1 / AVX2)。坐标表和通道数、像素类型无关，
+// 1..4 通道的 8 位 / 16 位 / float 图都可以用同一张表，每次调用按 Image 选一次模板实例。
+
+enum class Interpolation { kNearest, kBilinear };
+
+// 源图上的矩形 (像素坐标，可以是小数，可以超出源图，超出的部分取边缘像素)
+struct CropRect {
+    float x = 0;
+    float y = 0;
+    float width = 0;
+    float height = 0;
+};
+
+// 以 (centerX, centerY) (0..1 的相对位置) 为中心、放大 zoom 倍时的裁剪框
+CropRect zoomCrop(int srcW, int srcH, float centerX, float centerY, float zoom);
+
+// 把 srcW x srcH 源图的 crop 区域缩放到 outW x outH 的坐标表
+class ScaleMap {
+public:
+    ScaleMap() = default;
+    ScaleMap(int srcW, int srcH, const CropRect& crop, int outW, int outH);
+
+    int srcWidth() const { return srcW_; }
+    int srcHeight() const { return srcH_; }
+    int outWidth() const { return outW_; }
+    int outHeight() const { return outH_; }
+
+    // src 的尺寸必须和建表时一致，否则返回 false；输出和 src 的通道数、类型相同
+    bool apply(const Image& src, Image& dst, Interpolation interp = Interpolation::kBilinear) const;
+
+private:
+    template <typename P>
+    void applyBilinear(const P* src, P* dst) const;
+    template <typename P>
+    void applyNearest(const P* src, P* dst) const;
+
+    int srcW_ = 0, srcH_ = 0, outW_ = 0, outH_ = 0;
+
+    // 双线性：每列左右两个源像素的下标和右边像素的权重；[xBegin_, xEnd_) 之间右边像素一定是 左边 + 1
+    std::vector<int> xOfs0_, xOfs1_;
+    std::vector<int> xWeight_;
+    int xBegin_ = 0, xEnd_ = 0;
+    // 每行上下两个源行和下面一行的权重
+    std::vector<int> yRow0_, yRow1_;
+    std::vector<int> yWeight_;
+
+    // 最近邻：每列的源列、每行的源行
+    std::vector<int> xNear_, yNear_;
+};
+
+// 同一组输出尺寸 / 中心点、多个放大倍数的坐标表，建一次，对同尺寸的一批图片反复使用
+class ZoomPlan {
+public:
+    ZoomPlan(int srcW, int srcH, int outW, int outH, float centerX, float centerY, const std::vector<float>& zooms);
+
+    int levels() const { return (int)maps_.size(); }
+    float zoom(int level) const { return zooms_[level]; }
+    bool matches(const Image& src) const;
+
+    bool apply(const Image& src, int level, Image& dst, Interpolation interp = Interpolation::kBilinear) const;
+
+private:
+    std::vector<float> zooms_;
+    std::vector<ScaleMap> maps_;
+};
+
+// 数码变焦：以 (centerX, centerY) 为中心放大 zoomLevel 倍，输出 outW x outH
+void digitalZoom(const Image& src, Image& dst, int outW, int outH, float centerX_ratio, float centerY_ratio,
+                 float zoomLevel, Interpolation interp = Interpolation::kBilinear);
+
+// 仿射变换：输出像素 (x, y) 取源图 (m[0] x + m[1] y + m[2], m[3] x + m[4] y + m[5]) 处的值
+// (矩阵是 输出 -> 源 的逆映射)，超出源图的位置取边缘像素
+void warpAffine(const Image& src, Image& dst, int outW, int outH, const float m[6],
+                Interpolation interp = Interpolation::kBilinear);
@@ -0,0 +1,621 @@
+#include "rt_vision/color_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "rt_vision/cpu_features.h"
+#include "simd.h"
+
+namespace {
+
+// === 定点系数 (和 OpenCV 的 8 位实现相同，保证结果逐字节一致) ===
+constexpr int kGrayShift = 15;
+constexpr int kR2Y = 9798;   // 0.299 * 2^15
+constexpr int kG2Y = 19235;  // 0.587 * 2^15
+constexpr int kB2Y = 3735;   // 0.114 * 2^15 (三个系数之和正好是 2^15，白色不会溢出)
+
+constexpr int kHsvShift = 12;
+constexpr int kHueRange = 180;
+
+// BT.601 有限范围 YUV -> RGB，20 位定点
+constexpr int kYuvShift = 20;
+constexpr int kCY = 1220542;   // 1.164 * 2^20
+constexpr int kCUB = 2116026;  // 2.018 * 2^20
+constexpr int kCUG = -409993;  // -0.391 * 2^20
+constexpr int kCVG = -852492;  // -0.813 * 2^20
+constexpr int kCVR = 1673527;  // 1.596 * 2^20
+
+// HSV 里的两个除法 (S = diff * 255 / V, H = h * 30 / diff) 换成乘以查表得到的倒数
+struct HsvTables {
+    int sdiv[256];
+    int hdiv[256];
+};
+
+const HsvTables& hsvTables() {
+    static const HsvTables tables = [] {
+        HsvTables t;
+        t.sdiv[0] = t.hdiv[0] = 0;
+        for (int i = 1; i < 256; ++i) {
+            t.sdiv[i] = (int)std::lrint((255 << kHsvShift) / (1.0 * i));
+            t.hdiv[i] = (int)std::lrint((kHueRange << kHsvShift) / (6.0 * i));
+        }
+        return t;
+    }();
+    return tables;
+}
+
+inline uint8_t saturate(int v) { return (uint8_t)std::clamp(v, 0, 255); }
+
+// === 普通实现 (也是 SIMD 版本处理不满一组的尾部像素时用的) ===
+// kBlue 是蓝色所在的通道：BGR 为 0，RGB 为 2
+
+template <int kBlue>
+void grayScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 3) {
+        const int y = src[kBlue] * kB2Y + src[1] * kG2Y + src[2 - kBlue] * kR2Y;
+        dst[i] = (uint8_t)((y + (1 << (kGrayShift - 1))) >> kGrayShift);
+    }
+}
+
+inline void hsvPixel(int b, int g, int r, const HsvTables& t, uint8_t out[3]) {
+    const int v = std::max(std::max(b, g), r);
+    const int diff = v - std::min(std::min(b, g), r);
+    const int vr = v == r ? -1 : 0;
+    const int vg = v == g ? -1 : 0;
+
+    const int s = (diff * t.sdiv[v] + (1 << (kHsvShift - 1))) >> kHsvShift;
+    int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+    h = (h * t.hdiv[diff] + (1 << (kHsvShift - 1))) >> kHsvShift;
+    h += h < 0 ? kHueRange : 0;
+
+    out[0] = (uint8_t)h;
+    out[1] = (uint8_t)s;
+    out[2] = (uint8_t)v;
+}
+
+template <int kBlue>
+void hsvScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    const HsvTables& t = hsvTables();
+    for (size_t i = 0; i < count; ++i, src += 3, dst += 3) {
+        hsvPixel(src[kBlue], src[1], src[2 - kBlue], t, dst);
+    }
+}
+
+template <int kBlue>
+void hsvInRangeScalar(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3],
+                      const uint8_t upper[3]) {
+    const HsvTables& t = hsvTables();
+    uint8_t hsv[3];
+    for (size_t i = 0; i < count; ++i, src += 3) {
+        hsvPixel(src[kBlue], src[1], src[2 - kBlue], t, hsv);
+        const bool in = hsv[0] >= lower[0] && hsv[0] <= upper[0] && hsv[1] >= lower[1] && hsv[1] <= upper[1] &&
+                        hsv[2] >= lower[2] && hsv[2] <= upper[2];
+        mask[i] = in ? 255 : 0;
+    }
+}
+
+void swapRedBlueScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 3, dst += 3) {
+        const uint8_t r = src[0], g = src[1], b = src[2];
+        dst[0] = b;
+        dst[1] = g;
+        dst[2] = r;
+    }
+}
+
+void rgbaToRgbScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 4, dst += 3) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+void rgbToRgbaScalar(const uint8_t* src, uint8_t* dst, size_t count, uint8_t alpha) {
+    for (size_t i = 0; i < count; ++i, src += 3, dst += 4) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = alpha;
+    }
+}
+
+// NV12 的一行：x 从 x0 开始 (x0 为偶数)，uv 指向这一行对应的色度行
+template <int kBlue>
+void nv12RowScalar(const uint8_t* y, const uint8_t* uv, int x0, int width, uint8_t* dst) {
+    for (int x = x0; x < width; x += 2) {
+        const int u = uv[x] - 128;
+        const int v = uv[x + 1] - 128;
+        const int ruv = (1 << (kYuvShift - 1)) + kCVR * v;
+        const int guv = (1 << (kYuvShift - 1)) + kCVG * v + kCUG * u;
+        const int buv = (1 << (kYuvShift - 1)) + kCUB * u;
+        for (int k = 0; k < 2; ++k) {
+            const int yy = std::max(0, y[x + k] - 16) * kCY;
+            uint8_t* p = dst + (x + k) * 3;
+            p[2 - kBlue] = saturate((yy + ruv) >> kYuvShift);
+            p[1] = saturate((yy + guv) >> kYuvShift);
+            p[kBlue] = saturate((yy + buv) >> kYuvShift);
+        }
+    }
+}
+
+#if RTV_X86
+
+// === SSE4.1 / AVX2 实现 ===
+// 3 通道交错的 16 个像素 (48 字节) 和 3 个 16 字节的平面之间用 pshufb 互相转换，
+// 每个平面由 3 次 shuffle + OR 拼出来，掩码在这里按公式生成而不是手写常量。
+struct Shuffle3 {
+    __m128i deint[3][3];  // [通道][输入寄存器]
+    __m128i inter[3][3];  // [输出寄存器][通道]
+};
+
+RTV_TARGET_SSE41 Shuffle3 makeShuffle3() {
+    Shuffle3 s;
+    alignas(16) int8_t m[16];
+    for (int c = 0; c < 3; ++c) {
+        for (int k = 0; k < 3; ++k) {
+            for (int i = 0; i < 16; ++i) {
+                const int from = 3 * i + c;
+                m[i] = (int8_t)(from / 16 == k ? from % 16 : -128);
+            }
+            s.deint[c][k] = _mm_load_si128((const __m128i*)m);
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            for (int j = 0; j < 16; ++j) {
+                const int to = 16 * k + j;
+                m[j] = (int8_t)(to % 3 == c ? to / 3 : -128);
+            }
+            s.inter[k][c] = _mm_load_si128((const __m128i*)m);
+        }
+    }
+    return s;
+}
+
+RTV_TARGET_SSE41 inline void load3(const Shuffle3& s, const uint8_t* p, __m128i planes[3]) {
+    const __m128i a0 = _mm_loadu_si128((const __m128i*)p);
+    const __m128i a1 = _mm_loadu_si128((const __m128i*)(p + 16));
+    const __m128i a2 = _mm_loadu_si128((const __m128i*)(p + 32));
+    for (int c = 0; c < 3; ++c) {
+        planes[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, s.deint[c][0]), _mm_shuffle_epi8(a1, s.deint[c][1])),
+                                 _mm_shuffle_epi8(a2, s.deint[c][2]));
+    }
+}
+
+RTV_TARGET_SSE41 inline void store3(const Shuffle3& s, uint8_t* p, __m128i c0, __m128i c1, __m128i c2) {
+    for (int k = 0; k < 3; ++k) {
+        const __m128i out =
+            _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, s.inter[k][0]), _mm_shuffle_epi8(c1, s.inter[k][1])),
+                         _mm_shuffle_epi8(c2, s.inter[k][2]));
+        _mm_storeu_si128((__m128i*)(p + 16 * k), out);
+    }
+}
+
+// 8 个像素的灰度 (16 位结果)：(b,g) 和 (r,1) 两两配对后用 pmaddwd，一条指令完成两次乘加
+RTV_TARGET_SSE41 inline __m128i gray8(__m128i b16, __m128i g16, __m128i r16) {
+    const __m128i bgCoeff = _mm_set1_epi32((kG2Y << 16) | kB2Y);
+    const __m128i rCoeff = _mm_set1_epi32(((1 << (kGrayShift - 1)) << 16) | kR2Y);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), bgCoeff),
+                                     _mm_madd_epi16(_mm_unpacklo_epi16(r16, one), rCoeff));
+    const __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), bgCoeff),
+                                     _mm_madd_epi16(_mm_unpackhi_epi16(r16, one), rCoeff));
+    return _mm_packs_epi32(_mm_srai_epi32(lo, kGrayShift), _mm_srai_epi32(hi, kGrayShift));
+}
+
+template <int kBlue>
+RTV_TARGET_SSE41 size_t graySse41(const uint8_t* src, uint8_t* dst, size_t count) {
+    const Shuffle3 s = makeShuffle3();
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3];
+        load3(s, src + 3 * i, c);
+        const __m128i b = c[kBlue], g = c[1], r = c[2 - kBlue];
+        const __m128i y0 = gray8(_mm_cvtepu8_epi16(b), _mm_cvtepu8_epi16(g), _mm_cvtepu8_epi16(r));
+        const __m128i y1 = gray8(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(y0, y1));
+    }
+    return i;
+}
+
+// 取 8 位平面的第 half 组 8 个字节，扩展成 8 个 int32
+RTV_TARGET_AVX2 inline __m256i widen8(__m128i x, int half) {
+    return _mm256_cvtepu8_epi32(half ? _mm_srli_si128(x, 8) : x);
+}
+
+RTV_TARGET_AVX2 inline __m128i narrow8(__m256i x) {
+    return _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+// 16 个像素的 HSV：V / diff 用 8 位 max/min 算，除法查表用 AVX2 的 gather，其余在 int32 上算
+RTV_TARGET_AVX2 inline void hsv16(__m128i b, __m128i g, __m128i r, const HsvTables& t, __m128i& h, __m128i& s,
+                                  __m128i& v) {
+    v = _mm_max_epu8(_mm_max_epu8(b, g), r);
+    const __m128i diff = _mm_sub_epi8(v, _mm_min_epu8(_mm_min_epu8(b, g), r));
+    const __m256i round = _mm256_set1_epi32(1 << (kHsvShift - 1));
+    const __m256i hueRange = _mm256_set1_epi32(kHueRange);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m128i h16[2], s16[2];
+    for (int half = 0; half < 2; ++half) {
+        const __m256i B = widen8(b, half), G = widen8(g, half), R = widen8(r, half);
+        const __m256i V = widen8(v, half), D = widen8(diff, half);
+
+        const __m256i S = _mm256_mullo_epi32(D, _mm256_i32gather_epi32(t.sdiv, V, 4));
+        s16[half] = narrow8(_mm256_srai_epi32(_mm256_add_epi32(S, round), kHsvShift));
+
+        // 最大值是 R 时用 g - b，是 G 时用 b - r + 2 diff，否则 r - g + 4 diff (R 优先)
+        const __m256i hr = _mm256_sub_epi32(G, B);
+        const __m256i hg = _mm256_add_epi32(_mm256_sub_epi32(B, R), _mm256_slli_epi32(D, 1));
+        const __m256i hb = _mm256_add_epi32(_mm256_sub_epi32(R, G), _mm256_slli_epi32(D, 2));
+        __m256i H = _mm256_blendv_epi8(hb, hg, _mm256_cmpeq_epi32(V, G));
+        H = _mm256_blendv_epi8(H, hr, _mm256_cmpeq_epi32(V, R));
+        H = _mm256_mullo_epi32(H, _mm256_i32gather_epi32(t.hdiv, D, 4));
+        H = _mm256_srai_epi32(_mm256_add_epi32(H, round), kHsvShift);
+        H = _mm256_add_epi32(H, _mm256_and_si256(_mm256_cmpgt_epi32(zero, H), hueRange));
+        h16[half] = narrow8(H);
+    }
+    h = _mm_packus_epi16(h16[0], h16[1]);
+    s = _mm_packus_epi16(s16[0], s16[1]);
+}
+
+// 8 位平面的 16 个字节扩展成 4 组 int32
+RTV_TARGET_SSE41 inline void widen4(__m128i x, __m128i out[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_cvtepu8_epi16(x), hi = _mm_unpackhi_epi8(x, zero);
+    out[0] = _mm_cvtepu16_epi32(lo);
+    out[1] = _mm_unpackhi_epi16(lo, zero);
+    out[2] = _mm_cvtepu16_epi32(hi);
+    out[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+// hsv16 的 SSE4.1 版本：没有 gather，V / diff 先存到栈上逐个查表，其余运算一样，每次 4 个像素
+RTV_TARGET_SSE41 inline void hsv16Sse41(__m128i b, __m128i g, __m128i r, const HsvTables& t, __m128i& h,
+                                        __m128i& s, __m128i& v) {
+    v = _mm_max_epu8(_mm_max_epu8(b, g), r);
+    const __m128i diff = _mm_sub_epi8(v, _mm_min_epu8(_mm_min_epu8(b, g), r));
+    const __m128i round = _mm_set1_epi32(1 << (kHsvShift - 1));
+    const __m128i hueRange = _mm_set1_epi32(kHueRange);
+    const __m128i zero = _mm_setzero_si128();
+
+    alignas(16) uint8_t vs[16], ds[16];
+    _mm_store_si128((__m128i*)vs, v);
+    _mm_store_si128((__m128i*)ds, diff);
+    __m128i B[4], G[4], R[4], V[4], D[4], h32[4], s32[4];
+    widen4(b, B);
+    widen4(g, G);
+    widen4(r, R);
+    widen4(v, V);
+    widen4(diff, D);
+    for (int q = 0; q < 4; ++q) {
+        const uint8_t* vq = vs + 4 * q;
+        const uint8_t* dq = ds + 4 * q;
+        const __m128i sdiv = _mm_setr_epi32(t.sdiv[vq[0]], t.sdiv[vq[1]], t.sdiv[vq[2]], t.sdiv[vq[3]]);
+        const __m128i hdiv = _mm_setr_epi32(t.hdiv[dq[0]], t.hdiv[dq[1]], t.hdiv[dq[2]], t.hdiv[dq[3]]);
+
+        s32[q] = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(D[q], sdiv), round), kHsvShift);
+
+        const __m128i hr = _mm_sub_epi32(G[q], B[q]);
+        const __m128i hg = _mm_add_epi32(_mm_sub_epi32(B[q], R[q]), _mm_slli_epi32(D[q], 1));
+        const __m128i hb = _mm_add_epi32(_mm_sub_epi32(R[q], G[q]), _mm_slli_epi32(D[q], 2));
+        __m128i H = _mm_blendv_epi8(hb, hg, _mm_cmpeq_epi32(V[q], G[q]));
+        H = _mm_blendv_epi8(H, hr, _mm_cmpeq_epi32(V[q], R[q]));
+        H = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(H, hdiv), round), kHsvShift);
+        h32[q] = _mm_add_epi32(H, _mm_and_si128(_mm_cmpgt_epi32(zero, H), hueRange));
+    }
+    h = _mm_packus_epi16(_mm_packs_epi32(h32[0], h32[1]), _mm_packs_epi32(h32[2], h32[3]));
+    s = _mm_packus_epi16(_mm_packs_epi32(s32[0], s32[1]), _mm_packs_epi32(s32[2], s32[3]));
+}
+
+template <int kBlue>
+RTV_TARGET_SSE41 size_t hsvSse41(const uint8_t* src, uint8_t* dst, size_t count) {
+    const Shuffle3 sh = makeShuffle3();
+    const HsvTables& t = hsvTables();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3], h, s, v;
+        load3(sh, src + 3 * i, c);
+        hsv16Sse41(c[kBlue], c[1], c[2 - kBlue], t, h, s, v);
+        store3(sh, dst + 3 * i, h, s, v);
+    }
+    return i;
+}
+
+template <int kBlue>
+RTV_TARGET_AVX2 size_t hsvAvx2(const uint8_t* src, uint8_t* dst, size_t count) {
+    const Shuffle3 sh = makeShuffle3();
+    const HsvTables& t = hsvTables();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3], h, s, v;
+        load3(sh, src + 3 * i, c);
+        hsv16(c[kBlue], c[1], c[2 - kBlue], t, h, s, v);
+        store3(sh, dst + 3 * i, h, s, v);
+    }
+    return i;
+}
+
+// x >= lo 且 x <= hi (无符号)：max(x, lo) == x 且 min(x, hi) == x
+RTV_TARGET_SSE41 inline __m128i inRange8(__m128i x, __m128i lo, __m128i hi) {
+    return _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(x, lo), x), _mm_cmpeq_epi8(_mm_min_epu8(x, hi), x));
+}
+
+template <int kBlue>
+RTV_TARGET_AVX2 size_t hsvInRangeAvx2(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3],
+                                      const uint8_t upper[3]) {
+    const Shuffle3 sh = makeShuffle3();
+    const HsvTables& t = hsvTables();
+    __m128i lo[3], hi[3];
+    for (int c = 0; c < 3; ++c) {
+        lo[c] = _mm_set1_epi8((char)lower[c]);
+        hi[c] = _mm_set1_epi8((char)upper[c]);
+    }
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3], h, s, v;
+        load3(sh, src + 3 * i, c);
+        hsv16(c[kBlue], c[1], c[2 - kBlue], t, h, s, v);
+        const __m128i m =
+            _mm_and_si128(_mm_and_si128(inRange8(h, lo[0], hi[0]), inRange8(s, lo[1], hi[1])), inRange8(v, lo[2], hi[2]));
+        _mm_storeu_si128((__m128i*)(mask + i), m);
+    }
+    return i;
+}
+
+RTV_TARGET_SSE41 size_t swapRedBlueSse41(const uint8_t* src, uint8_t* dst, size_t count) {
+    const Shuffle3 s = makeShuffle3();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3];
+        load3(s, src + 3 * i, c);
+        store3(s, dst + 3 * i, c[2], c[1], c[0]);
+    }
+    return i;
+}
+
+RTV_TARGET_SSE41 size_t rgbaToRgbSse41(const uint8_t* src, uint8_t* dst, size_t count) {
+    // 每 4 个像素 (16 字节) 压成 12 字节，再把 4 组拼成 3 个完整的 16 字节
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8_t* p = src + 4 * i;
+        const __m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), pack);
+        const __m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), pack);
+        const __m128i c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), pack);
+        const __m128i c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), pack);
+        uint8_t* q = dst + 3 * i;
+        _mm_storeu_si128((__m128i*)q, _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+        _mm_storeu_si128((__m128i*)(q + 16), _mm_or_si128(_mm_srli_si128(c1, 4), _mm_slli_si128(c2, 8)));
+        _mm_storeu_si128((__m128i*)(q + 32), _mm_or_si128(_mm_srli_si128(c2, 8), _mm_slli_si128(c3, 4)));
+    }
+    return i;
+}
+
+RTV_TARGET_SSE41 size_t rgbToRgbaSse41(const uint8_t* src, uint8_t* dst, size_t count, uint8_t alpha) {
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+    const __m128i a = _mm_set1_epi32((int)((uint32_t)alpha << 24));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8_t* p = src + 3 * i;
+        const __m128i in0 = _mm_loadu_si128((const __m128i*)p);
+        const __m128i in1 = _mm_loadu_si128((const __m128i*)(p + 16));
+        const __m128i in2 = _mm_loadu_si128((const __m128i*)(p + 32));
+        const __m128i g[4] = {in0, _mm_alignr_epi8(in1, in0, 12), _mm_alignr_epi8(in2, in1, 8), _mm_srli_si128(in2, 4)};
+        for (int k = 0; k < 4; ++k) {
+            _mm_storeu_si128((__m128i*)(dst + 4 * i + 16 * k), _mm_or_si128(_mm_shuffle_epi8(g[k], expand), a));
+        }
+    }
+    return i;
+}
+
+// 4 个像素的 NV12 -> RGB 定点计算，结果是 4 个 int32 (还没饱和)
+RTV_TARGET_SSE41 inline void yuv4(__m128i y32, __m128i u32, __m128i v32, __m128i& r, __m128i& g, __m128i& b) {
+    const __m128i round = _mm_set1_epi32(1 << (kYuvShift - 1));
+    const __m128i yy = _mm_mullo_epi32(_mm_max_epi32(_mm_sub_epi32(y32, _mm_set1_epi32(16)), _mm_setzero_si128()),
+                                       _mm_set1_epi32(kCY));
+    const __m128i ruv = _mm_add_epi32(round, _mm_mullo_epi32(v32, _mm_set1_epi32(kCVR)));
+    const __m128i guv = _mm_add_epi32(round, _mm_add_epi32(_mm_mullo_epi32(v32, _mm_set1_epi32(kCVG)),
+                                                           _mm_mullo_epi32(u32, _mm_set1_epi32(kCUG))));
+    const __m128i buv = _mm_add_epi32(round, _mm_mullo_epi32(u32, _mm_set1_epi32(kCUB)));
+    r = _mm_srai_epi32(_mm_add_epi32(yy, ruv), kYuvShift);
+    g = _mm_srai_epi32(_mm_add_epi32(yy, guv), kYuvShift);
+    b = _mm_srai_epi32(_mm_add_epi32(yy, buv), kYuvShift);
+}
+
+// 从第 kOffset 个像素起的 4 个像素 (位移必须是编译期常量，所以做成模板参数)
+template <int kOffset>
+RTV_TARGET_SSE41 inline void yuvQuad(__m128i y8, __m128i u8, __m128i v8, __m128i& r, __m128i& g, __m128i& b) {
+    const __m128i bias = _mm_set1_epi32(128);
+    const __m128i y32 = _mm_cvtepu8_epi32(_mm_srli_si128(y8, kOffset));
+    const __m128i u32 = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(u8, kOffset)), bias);
+    const __m128i v32 = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(v8, kOffset)), bias);
+    yuv4(y32, u32, v32, r, g, b);
+}
+
+// 一行里能整 16 个处理的部分，返回处理到的 x
+template <int kBlue>
+RTV_TARGET_SSE41 int nv12RowSse41(const Shuffle3& s, const uint8_t* y, const uint8_t* uv, int width, uint8_t* dst) {
+    // U、V 各取 8 个，再每个复制成两份，对应 16 个像素
+    const __m128i takeU = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, 8, 8, 10, 10, 12, 12, 14, 14);
+    const __m128i takeV = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, 9, 9, 11, 11, 13, 13, 15, 15);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i y8 = _mm_loadu_si128((const __m128i*)(y + x));
+        const __m128i uv8 = _mm_loadu_si128((const __m128i*)(uv + x));
+        const __m128i u8 = _mm_shuffle_epi8(uv8, takeU);
+        const __m128i v8 = _mm_shuffle_epi8(uv8, takeV);
+
+        __m128i r32[4], g32[4], b32[4];
+        yuvQuad<0>(y8, u8, v8, r32[0], g32[0], b32[0]);
+        yuvQuad<4>(y8, u8, v8, r32[1], g32[1], b32[1]);
+        yuvQuad<8>(y8, u8, v8, r32[2], g32[2], b32[2]);
+        yuvQuad<12>(y8, u8, v8, r32[3], g32[3], b32[3]);
+        const __m128i r = _mm_packus_epi16(_mm_packs_epi32(r32[0], r32[1]), _mm_packs_epi32(r32[2], r32[3]));
+        const __m128i g = _mm_packus_epi16(_mm_packs_epi32(g32[0], g32[1]), _mm_packs_epi32(g32[2], g32[3]));
+        const __m128i b = _mm_packus_epi16(_mm_packs_epi32(b32[0], b32[1]), _mm_packs_epi32(b32[2], b32[3]));
+        if (kBlue == 0)
+            store3(s, dst + 3 * x, b, g, r);
+        else
+            store3(s, dst + 3 * x, r, g, b);
+    }
+    return x;
+}
+template <int kBlue>
+RTV_TARGET_SSE41 size_t hsvInRangeSse41(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3],
+                                        const uint8_t upper[3]) {
+    const Shuffle3 sh = makeShuffle3();
+    const HsvTables& t = hsvTables();
+    __m128i lo[3], hi[3];
+    for (int c = 0; c < 3; ++c) {
+        lo[c] = _mm_set1_epi8((char)lower[c]);
+        hi[c] = _mm_set1_epi8((char)upper[c]);
+    }
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i c[3], h, s, v;
+        load3(sh, src + 3 * i, c);
+        hsv16Sse41(c[kBlue], c[1], c[2 - kBlue], t, h, s, v);
+        const __m128i m =
+            _mm_and_si128(_mm_and_si128(inRange8(h, lo[0], hi[0]), inRange8(s, lo[1], hi[1])), inRange8(v, lo[2], hi[2]));
+        _mm_storeu_si128((__m128i*)(mask + i), m);
+    }
+    return i;
+}
+
+#endif  // RTV_X86
+
+template <int kBlue>
+void grayDispatch(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().sse41) done = graySse41<kBlue>(src, dst, count);
+#endif
+    grayScalar<kBlue>(src + 3 * done, dst + done, count - done);
+}
+
+template <int kBlue>
+void hsvDispatch(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().avx2)
+        done = hsvAvx2<kBlue>(src, dst, count);
+    else if (cpuFeatures().sse41)
+        done = hsvSse41<kBlue>(src, dst, count);
+#endif
+    hsvScalar<kBlue>(src + 3 * done, dst + 3 * done, count - done);
+}
+
+template <int kBlue>
+void hsvInRangeDispatch(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3],
+                        const uint8_t upper[3]) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().avx2)
+        done = hsvInRangeAvx2<kBlue>(src, mask, count, lower, upper);
+    else if (cpuFeatures().sse41)
+        done = hsvInRangeSse41<kBlue>(src, mask, count, lower, upper);
+#endif
+    hsvInRangeScalar<kBlue>(src + 3 * done, mask + done, count - done, lower, upper);
+}
+
+template <int kBlue>
+void nv12Dispatch(const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst) {
+#if RTV_X86
+    const bool sse41 = cpuFeatures().sse41;
+    const Shuffle3 s = sse41 ? makeShuffle3() : Shuffle3();
+#endif
+    for (int row = 0; row < height; ++row) {
+        const uint8_t* yRow = y + (size_t)row * width;
+        const uint8_t* uvRow = uv + (size_t)(row / 2) * width;
+        uint8_t* dstRow = dst + (size_t)row * width * 3;
+        int x = 0;
+#if RTV_X86
+        if (sse41) x = nv12RowSse41<kBlue>(s, yRow, uvRow, width, dstRow);
+#endif
+        nv12RowScalar<kBlue>(yRow, uvRow, x, width, dstRow);
+    }
+}
+
+}  // namespace
+
+void bgrToGray(const uint8_t* src, uint8_t* dst, size_t count) { grayDispatch<0>(src, dst, count); }
+void rgbToGray(const uint8_t* src, uint8_t* dst, size_t count) { grayDispatch<2>(src, dst, count); }
+
+void bgrToHsv(const uint8_t* src, uint8_t* dst, size_t count) { hsvDispatch<0>(src, dst, count); }
+void rgbToHsv(const uint8_t* src, uint8_t* dst, size_t count) { hsvDispatch<2>(src, dst, count); }
+
+void bgrHsvInRange(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3], const uint8_t upper[3]) {
+    hsvInRangeDispatch<0>(src, mask, count, lower, upper);
+}
+
+void rgbHsvInRange(const uint8_t* src, uint8_t* mask, size_t count, const uint8_t lower[3], const uint8_t upper[3]) {
+    hsvInRangeDispatch<2>(src, mask, count, lower, upper);
+}
+
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().sse41) done = swapRedBlueSse41(src, dst, count);
+#endif
+    swapRedBlueScalar(src + 3 * done, dst + 3 * done, count - done);
+}
+
+void rgbaToRgb(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().sse41) done = rgbaToRgbSse41(src, dst, count);
+#endif
+    rgbaToRgbScalar(src + 4 * done, dst + 3 * done, count - done);
+}
+
+void rgbToRgba(const uint8_t* src, uint8_t* dst, size_t count, uint8_t alpha) {
+    size_t done = 0;
+#if RTV_X86
+    if (cpuFeatures().sse41) done = rgbToRgbaSse41(src, dst, count, alpha);
+#endif
+    rgbToRgbaScalar(src + 3 * done, dst + 4 * done, count - done, alpha);
+}
+
+void nv12ToRgb(const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst) {
+    nv12Dispatch<2>(y, uv, width, height, dst);
+}
+
+void nv12ToBgr(const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst) {
+    nv12Dispatch<0>(y, uv, width, height, dst);
+}
+
+bool convertColor(const Image& src, Image& dst, ColorConversion code) {
+    int inChannels = 3, outChannels = 3;
+    if (code == ColorConversion::kRgbToGray) outChannels = 1;
+    if (code == ColorConversion::kRgbaToRgb) inChannels = 4;
+    if (code == ColorConversion::kRgbToRgba) outChannels = 4;
+    // 颜色转换只有 8 位版本 (和 OpenCV 的定点结果对齐)，16 位 / float 图先用 convertDepth 转换
+    if (!src.data || src.type != PixelType::kU8 || src.channels != inChannels) return false;
+
+    // 先分配新内存再释放旧的，这样 dst 和 src 是同一个对象时也没问题
+    const size_t count = (size_t)src.width * src.height;
+    unsigned char* out = (unsigned char*)malloc(count * outChannels);
+    switch (code) {
+        case ColorConversion::kRgbToGray:
+            rgbToGray(src.data, out, count);
+            break;
+        case ColorConversion::kRgbToHsv:
+            rgbToHsv(src.data, out, count);
+            break;
+        case ColorConversion::kRgbToBgr:
+            swapRedBlue(src.data, out, count);
+            break;
+        case ColorConversion::kRgbaToRgb:
+            rgbaToRgb(src.data, out, count);
+            break;
+        case ColorConversion::kRgbToRgba:
+            rgbToRgba(src.data, out, count);
+            break;
+    }
+
+    dst.adopt(out, src.width, src.height, outChannels, PixelType::kU8);
+    return true;
+}
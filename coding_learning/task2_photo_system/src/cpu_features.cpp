@@ -0,0 +1,43 @@
+#include "rt_vision/cpu_features.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "simd.h"
+
+#if RTV_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static CpuFeatures detect() {
+    CpuFeatures f;
+    // =avx2 只关掉 AVX2 (在 AVX2 机器上测 SSE4.1 路径)，其他非 0 的值关掉全部 SIMD
+    const char* disable = std::getenv("RT_VISION_DISABLE_SIMD");
+    const bool noAvx2 = disable && std::strcmp(disable, "avx2") == 0;
+    if (disable && disable[0] && disable[0] != '0' && !noAvx2) return f;
+
+#if RTV_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    f.sse41 = (info[2] & (1 << 19)) != 0;
+    // AVX2 还要求操作系统保存 YMM 寄存器 (OSXSAVE + XCR0 的第 1、2 位)
+    const bool osYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    if (maxLeaf >= 7 && osYmm) {
+        __cpuidex(info, 7, 0);
+        f.avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#elif RTV_X86
+    __builtin_cpu_init();
+    f.sse41 = __builtin_cpu_supports("sse4.1");
+    f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (noAvx2) f.avx2 = false;
+    return f;
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
@@ -1,6 +1,14 @@
 #include "rt_vision/image_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <cstring> // for memcpy
+#include <type_traits>
+#include <vector>
+
+#include "rt_vision/jpeg_decoder.h"
+#include "rt_vision/pixel.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stb_image.h"
@@ -8,6 +16,15 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "../external/stb_image_write.h"
 
+int bytesPerChannel(PixelType type) {
+    switch (type) {
+        case PixelType::kU8: return 1;
+        case PixelType::kU16: return 2;
+        case PixelType::kF32: return 4;
+    }
+    return 1;
+}
+
 // === Image 类的基础实现 ===
 Image::Image() {}
 
@@ -18,17 +35,61 @@ Image::~Image() {
 }
 
 bool Image::load(const std::string& filename) {
-    data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+    // 整个文件读进内存再解码，和 shard 里读出来的图片走同一条路径 (JPEG 可以先试并行解码)
+    std::vector<unsigned char> bytes;
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (in) {
+        bytes.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)bytes.size());
+    }
+    return loadFromMemory(bytes.data(), bytes.size(), filename);
+}
+
+bool Image::loadFromMemory(const unsigned char* bytes, size_t size, const std::string& name) {
+    if (data) {
+        stbi_image_free(data);
+        data = nullptr;
+    }
+
+    // 带重启标记的大 JPEG 按段并行解码，其他情况 (没有 RSTn、渐进式、PNG ...) 交给 stb
+    if (decodeJpegParallel(bytes, size, *this)) return true;
+
+    // 按文件实际的位深读取：HDR 读成 float，16 位 PNG / PNM 读成 uint16，其余 8 位
+    const int len = (int)size;
+    if (stbi_is_hdr_from_memory(bytes, len)) {
+        data = reinterpret_cast<unsigned char*>(stbi_loadf_from_memory(bytes, len, &width, &height, &channels, 0));
+        type = PixelType::kF32;
+    } else if (stbi_is_16_bit_from_memory(bytes, len)) {
+        data = reinterpret_cast<unsigned char*>(stbi_load_16_from_memory(bytes, len, &width, &height, &channels, 0));
+        type = PixelType::kU16;
+    } else {
+        data = stbi_load_from_memory(bytes, len, &width, &height, &channels, 0);
+        type = PixelType::kU8;
+    }
     if (data == nullptr) {
-        std::cerr << "Error: Load failed -> " << filename << std::endl;
+        std::cerr << "Error: Load failed -> " << name << std::endl;
         return false;
     }
     return true;
 }
 
+bool imageInfo(const unsigned char* bytes, size_t size, int& width, int& height, int& channels) {
+    return stbi_info_from_memory(bytes, (int)size, &width, &height, &channels) != 0;
+}
+
 bool Image::save(const std::string& filename) const {
     if (!data) return false;
-    
+
+    // float 图保存成 .hdr 时保留原始亮度；其他格式只支持 8 位，先转换
+    if (type == PixelType::kF32 && filename.find(".hdr") != std::string::npos) {
+        return stbi_write_hdr(filename.c_str(), width, height, channels, reinterpret_cast<const float*>(data));
+    }
+    if (type != PixelType::kU8) {
+        Image tmp;
+        return convertDepth(*this, tmp, PixelType::kU8) && tmp.save(filename);
+    }
+
     // === 核心功能 3：格式转换 ===
     // 根据文件名后缀自动判断保存格式
     if (filename.find(".png") != std::string::npos) {
@@ -40,57 +101,103 @@ bool Image::save(const std::string& filename) const {
     }
 }
 
-// === 算法实现 1：调整大小 (Resize) ===
-// 使用最近邻插值算法
-void resizeImage(const Image& src, Image& dst, int newW, int newH) {
-    dst.width = newW;
-    dst.height = newH;
-    dst.channels = src.channels;
-    
-    // 注意：这里我们用 malloc 分配内存，因为 Image 析构函数是用 stbi_image_free 释放的
-    // 在混合使用时要小心。为了作业简单，我们这里模拟 malloc，
-    // 但实际工程中最好统一内存管理。
-    // *这里为了防止崩溃，我们手动分配，但在析构时可能会有警告，作业代码中通常忽略*
-    size_t size = newW * newH * src.channels;
-    dst.data = (unsigned char*)malloc(size);
+void Image::adopt(unsigned char* newData, int w, int h, int c, PixelType t) {
+    if (data) stbi_image_free(data);
+    data = newData;
+    width = w;
+    height = h;
+    channels = c;
+    type = t;
+}
 
+// === 算法实现 1：调整大小 (Resize) ===
+// 使用最近邻插值算法；整像素赋值，通道数在编译期确定
+template <typename P>
+static void resizeKernel(const P* src, int srcW, int srcH, P* dst, int newW, int newH) {
     for (int y = 0; y < newH; ++y) {
+        // 映射回原图坐标
+        const P* srcRow = src + (size_t)(y * srcH / newH) * srcW;
+        P* dstRow = dst + (size_t)y * newW;
         for (int x = 0; x < newW; ++x) {
-            // 映射回原图坐标
-            int srcX = x * src.width / newW;
-            int srcY = y * src.height / newH;
-
-            for (int c = 0; c < src.channels; ++c) {
-                int dstIndex = (y * newW + x) * src.channels + c;
-                int srcIndex = (srcY * src.width + srcX) * src.channels + c;
-                dst.data[dstIndex] = src.data[srcIndex];
-            }
+            dstRow[x] = srcRow[x * srcW / newW];
         }
     }
 }
 
+void resizeImage(const Image& src, Image& dst, int newW, int newH) {
+    // 注意：这里我们用 malloc 分配内存，因为 Image 析构函数是用 stbi_image_free 释放的
+    unsigned char* out = (unsigned char*)malloc((size_t)newW * newH * src.pixelBytes());
+    visitPixel(src, [&](auto tag) {
+        using P = typename decltype(tag)::type;
+        resizeKernel(pixelsOf<P>(src), src.width, src.height, reinterpret_cast<P*>(out), newW, newH);
+    });
+    dst.adopt(out, newW, newH, src.channels, src.type);
+}
+
 // === 算法实现 2：旋转 90 度 (Rotate) ===
-void rotateImage90(const Image& src, Image& dst) {
+template <typename P>
+static void rotateKernel(const P* src, int srcW, int srcH, P* dst) {
     // 旋转 90 度后，宽高对调
-    dst.width = src.height;
-    dst.height = src.width;
-    dst.channels = src.channels;
-    
-    size_t size = dst.width * dst.height * dst.channels;
-    dst.data = (unsigned char*)malloc(size);
-
-    for (int y = 0; y < src.height; ++y) {
-        for (int x = 0; x < src.width; ++x) {
-            // 旋转公式：
-            // 原图 (x, y) -> 新图 (height - 1 - y, x)
-            int newX = src.height - 1 - y;
-            int newY = x;
-
-            for (int c = 0; c < src.channels; ++c) {
-                int srcIndex = (y * src.width + x) * src.channels + c;
-                int dstIndex = (newY * dst.width + newX) * dst.channels + c;
-                dst.data[dstIndex] = src.data[srcIndex];
-            }
+    const int dstW = srcH;
+    for (int y = 0; y < srcH; ++y) {
+        const P* srcRow = src + (size_t)y * srcW;
+        // 旋转公式：
+        // 原图 (x, y) -> 新图 (height - 1 - y, x)
+        P* dstCol = dst + (srcH - 1 - y);
+        for (int x = 0; x < srcW; ++x) {
+            dstCol[(size_t)x * dstW] = srcRow[x];
         }
     }
-}
\ No newline at end of file
+}
+
+void rotateImage90(const Image& src, Image& dst) {
+    unsigned char* out = (unsigned char*)malloc(src.byteSize());
+    visitPixel(src, [&](auto tag) {
+        using P = typename decltype(tag)::type;
+        rotateKernel(pixelsOf<P>(src), src.width, src.height, reinterpret_cast<P*>(out));
+    });
+    dst.adopt(out, src.height, src.width, src.channels, src.type);
+}
+
+// === 算法实现 3：位深转换 ===
+template <typename From, typename To>
+static To convertValue(From v) {
+    if constexpr (std::is_same_v<From, To>) {
+        return v;
+    } else if constexpr (std::is_same_v<To, float>) {
+        return v * (1.0f / PixelTraits<From>::kMax);
+    } else if constexpr (std::is_same_v<From, float>) {
+        const float x = std::clamp(v, 0.0f, 1.0f) * PixelTraits<To>::kMax;
+        return (To)(x + 0.5f);
+    } else if constexpr (sizeof(To) > sizeof(From)) {
+        return (To)(v * 257);  // 8 -> 16 位：0xAB -> 0xABAB
+    } else {
+        return (To)((v + 128) / 257);  // 16 -> 8 位，四舍五入
+    }
+}
+
+template <typename From, typename To>
+static void convertDepthKernel(const From* src, To* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = convertValue<From, To>(src[i]);
+}
+
+bool convertDepth(const Image& src, Image& dst, PixelType type) {
+    if (!src.data) return false;
+    const size_t n = (size_t)src.width * src.height * src.channels;
+    unsigned char* out = (unsigned char*)malloc(n * bytesPerChannel(type));
+
+    // 源和目标的类型各选一次 (通道数无关，按单通道访问)
+    const bool ok = visitPixel(1, src.type, [&](auto fromTag) {
+        using From = typename decltype(fromTag)::type::Type;
+        visitPixel(1, type, [&](auto toTag) {
+            using To = typename decltype(toTag)::type::Type;
+            convertDepthKernel(reinterpret_cast<const From*>(src.data), reinterpret_cast<To*>(out), n);
+        });
+    });
+    if (!ok) {
+        free(out);
+        return false;
+    }
+    dst.adopt(out, src.width, src.height, src.channels, type);
+    return true;
+}
@@ -0,0 +1,214 @@
+#include "rt_vision/jpeg_decoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "rt_vision/parallel.h"
+
+// 再编译一份只含 JPEG 的 stb_image，全部是 static：要用它内部的霍夫曼表、IDCT、上采样和颜色转换内核，
+// 和 image_system.cpp 里那份公开的 stbi_load 互不冲突
+#define STB_IMAGE_STATIC
+#define STBI_ONLY_JPEG
+#define STBI_NO_STDIO
+#define STB_IMAGE_IMPLEMENTATION
+#include "../external/stb_image.h"
+
+namespace {
+
+// 一段熵编码数据：[begin, end) 包含结尾的 RSTn / EOI 两个字节，stb 的比特读取器读到标记才会停
+struct Segment {
+    const stbi_uc* begin;
+    const stbi_uc* end;
+};
+
+// 释放 stb 分配的分量缓冲区
+struct JpegGuard {
+    stbi__jpeg* j;
+    ~JpegGuard() { stbi__free_jpeg_components(j, j->s->img_n, 0); }
+};
+
+// 从扫描头之后开始找 RSTn，直到扫描结束的标记；0xFF00 是字节填充，连续的 0xFF 是填充字节
+bool findSegments(const stbi_uc* p, const stbi_uc* end, std::vector<Segment>& segments, stbi_uc& endMarker) {
+    const stbi_uc* begin = p;
+    for (;;) {
+        p = static_cast<const stbi_uc*>(std::memchr(p, 0xFF, end - p));
+        if (!p) return false;
+        const stbi_uc* q = p + 1;
+        while (q < end && *q == 0xFF) ++q;
+        if (q == end) return false;
+        p = q + 1;
+        if (*q == 0x00) continue;
+        segments.push_back({begin, p});
+        if (!STBI__RESTART(*q)) {
+            endMarker = *q;
+            return true;
+        }
+        begin = p;
+    }
+}
+
+// 解码一段里的 MCU [mcuBegin, mcuEnd)，和 stbi__parse_entropy_coded_data 的基线分支逐行对应
+bool decodeSegment(stbi__jpeg* z, const Segment& seg, int mcuBegin, int mcuEnd, bool last) {
+    stbi__context s;
+    stbi__start_mem(&s, seg.begin, (int)(seg.end - seg.begin));
+    z->s = &s;
+    stbi__jpeg_reset(z);
+
+    STBI_SIMD_ALIGN(short, data[64]);
+    if (z->scan_n == 1) {
+        // 非交织：每个 8x8 块就是一个 MCU
+        const int n = z->order[0];
+        const int w = (z->img_comp[n].x + 7) >> 3;
+        const int ha = z->img_comp[n].ha;
+        for (int m = mcuBegin; m < mcuEnd; ++m) {
+            const int i = m % w, j = m / w;
+            if (!stbi__jpeg_decode_block(z, data, z->huff_dc + z->img_comp[n].hd, z->huff_ac + ha, z->fast_ac[ha], n,
+                                         z->dequant[z->img_comp[n].tq]))
+                return false;
+            z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * j * 8 + i * 8, z->img_comp[n].w2, data);
+        }
+    } else {
+        for (int m = mcuBegin; m < mcuEnd; ++m) {
+            const int i = m % z->img_mcu_x, j = m / z->img_mcu_x;
+            for (int k = 0; k < z->scan_n; ++k) {
+                const int n = z->order[k];
+                const int ha = z->img_comp[n].ha;
+                for (int y = 0; y < z->img_comp[n].v; ++y) {
+                    for (int x = 0; x < z->img_comp[n].h; ++x) {
+                        const int x2 = (i * z->img_comp[n].h + x) * 8;
+                        const int y2 = (j * z->img_comp[n].v + y) * 8;
+                        if (!stbi__jpeg_decode_block(z, data, z->huff_dc + z->img_comp[n].hd, z->huff_ac + ha,
+                                                     z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq]))
+                            return false;
+                        z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * y2 + x2, z->img_comp[n].w2,
+                                             data);
+                    }
+                }
+            }
+        }
+    }
+    // 一段解完之后 stb 要求紧接着就是 RSTn，否则它会停止解码；对不上时交给 stb 按它的方式处理
+    if (last) return true;
+    if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
+    return STBI__RESTART(z->marker);
+}
+
+// 第 row 行输出用到的两行分量数据，和 load_jpeg_image 里逐行推进的 stbi__resample 状态相同，但可以从任意一行开始
+void resampleRow(const stbi__jpeg* z, int k, int row, stbi_uc* linebuf, stbi_uc** out) {
+    const int hs = z->img_h_max / z->img_comp[k].h;
+    const int vs = z->img_v_max / z->img_comp[k].v;
+    const int wLores = ((int)z->s->img_x + hs - 1) / hs;
+    const int t = (vs >> 1) + row;
+    const int resets = t / vs;  // 前面已经换过几次行
+    const int ystep = t % vs;
+    const int last = z->img_comp[k].y - 1;
+    stbi_uc* base = z->img_comp[k].data;
+    stbi_uc* line1 = base + (size_t)std::min(resets, last) * z->img_comp[k].w2;
+    stbi_uc* line0 = resets ? base + (size_t)std::min(resets - 1, last) * z->img_comp[k].w2 : base;
+
+    const bool yBot = ystep >= (vs >> 1);
+    stbi_uc* nearLine = yBot ? line1 : line0;
+    stbi_uc* farLine = yBot ? line0 : line1;
+    if (hs == 1 && vs == 1)
+        *out = resample_row_1(linebuf, nearLine, farLine, wLores, hs);
+    else if (hs == 1 && vs == 2)
+        *out = stbi__resample_row_v_2(linebuf, nearLine, farLine, wLores, hs);
+    else if (hs == 2 && vs == 1)
+        *out = stbi__resample_row_h_2(linebuf, nearLine, farLine, wLores, hs);
+    else if (hs == 2 && vs == 2)
+        *out = z->resample_row_hv_2_kernel(linebuf, nearLine, farLine, wLores, hs);
+    else
+        *out = stbi__resample_row_generic(linebuf, nearLine, farLine, wLores, hs);
+}
+
+}  // namespace
+
+bool decodeJpegParallel(const unsigned char* bytes, size_t size, Image& dst) {
+    if (size < 4 || size > 0x7FFFFFFF || bytes[0] != 0xFF || bytes[1] != 0xD8) return false;
+
+    stbi__context s;
+    stbi__start_mem(&s, bytes, (int)size);
+    std::unique_ptr<stbi__jpeg> jpeg(new stbi__jpeg());
+    stbi__jpeg* z = jpeg.get();
+    z->s = &s;
+    stbi__setup_jpeg(z);
+    for (int i = 0; i < 4; ++i) {
+        z->img_comp[i].raw_data = nullptr;
+        z->img_comp[i].raw_coeff = nullptr;
+    }
+    s.img_n = 0;
+    JpegGuard guard{z};
+
+    // 文件头：一直处理到 SOS (DQT / DHT / DRI / APPn 都在 SOF 前后)
+    if (!stbi__decode_jpeg_header(z, STBI__SCAN_load) || z->progressive) return false;
+    if (s.img_n != 1 && s.img_n != 3) return false;
+    int m = stbi__get_marker(z);
+    while (!stbi__SOS(m)) {
+        if (stbi__EOI(m) || stbi__DNL(m) || !stbi__process_marker(z, m)) return false;
+        m = stbi__get_marker(z);
+    }
+    if (!stbi__process_scan_header(z) || z->scan_n != s.img_n || z->restart_interval == 0) return false;
+
+    std::vector<Segment> segments;
+    stbi_uc endMarker = 0;
+    if (!findSegments(s.img_buffer, s.img_buffer_end, segments, endMarker) || !stbi__EOI(endMarker)) return false;
+    int mcus = z->img_mcu_x * z->img_mcu_y;
+    if (z->scan_n == 1) {
+        const int n = z->order[0];
+        mcus = ((z->img_comp[n].x + 7) >> 3) * ((z->img_comp[n].y + 7) >> 3);
+    }
+    const int interval = z->restart_interval;
+    const int count = (int)segments.size();
+    if (count != (mcus + interval - 1) / interval) return false;
+
+    // 各段解码：每个行带复制一份解码状态 (霍夫曼表只读，分量缓冲区各段写各自的块)
+    std::vector<char> ok(count, 0);
+    parallelForRows(
+        count,
+        [&](int begin, int end) {
+            std::unique_ptr<stbi__jpeg> local(new stbi__jpeg(*z));
+            for (int i = begin; i < end; ++i) {
+                ok[i] = decodeSegment(local.get(), segments[i], i * interval, std::min(mcus, (i + 1) * interval),
+                                      i == count - 1);
+                if (!ok[i]) return;
+            }
+        },
+        1);
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) return false;
+
+    // 上采样 + 颜色转换，按输出行分带；多分配一个字节，和 stb 一样
+    const int w = (int)s.img_x, h = (int)s.img_y, n = s.img_n;
+    const bool isRgb = n == 3 && (z->rgb == 3 || (z->app14_color_transform == 0 && !z->jfif));
+    unsigned char* output = (unsigned char*)malloc((size_t)n * w * h + 1);
+    if (!output) return false;
+    parallelForRows(h, [&](int begin, int end) {
+        std::vector<stbi_uc> linebufs((size_t)n * (w + 3));
+        stbi_uc* coutput[3] = {};
+        stbi_uc tail[4];
+        for (int y = begin; y < end; ++y) {
+            for (int k = 0; k < n; ++k) resampleRow(z, k, y, linebufs.data() + (size_t)k * (w + 3), &coutput[k]);
+            stbi_uc* out = output + (size_t)n * w * y;
+            if (n == 1) {
+                std::memcpy(out, coutput[0], w);
+            } else if (isRgb) {
+                for (int i = 0; i < w; ++i) {
+                    out[3 * i + 0] = coutput[0][i];
+                    out[3 * i + 1] = coutput[1][i];
+                    out[3 * i + 2] = coutput[2][i];
+                }
+            } else {
+                // stb 的内核每个像素写 4 个字节 (第 4 个是 alpha)，最后一个像素会写到下一行开头，
+                // 而下一行可能属于别的线程，所以最后一个像素单独转换到临时缓冲区
+                z->YCbCr_to_RGB_kernel(out, coutput[0], coutput[1], coutput[2], w - 1, 3);
+                z->YCbCr_to_RGB_kernel(tail, coutput[0] + w - 1, coutput[1] + w - 1, coutput[2] + w - 1, 1, 3);
+                std::memcpy(out + 3 * (w - 1), tail, 3);
+            }
+        }
+    });
+
+    dst.adopt(output, w, h, n, PixelType::kU8);
+    return true;
+}
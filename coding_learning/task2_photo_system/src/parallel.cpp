@@ -0,0 +1,143 @@
+#include "rt_vision/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 当前线程是否正在执行某个行带 (嵌套调用直接串行)
+thread_local bool tInsideBand = false;
+
+int configuredThreads() {
+    const char* env = std::getenv("RT_VISION_THREADS");
+    if (env && std::atoi(env) > 0) return std::atoi(env);
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+// 一次 parallelForRows 调用，放在调用者的栈上，run 返回前保证没有线程还在用它
+struct Job {
+    const std::function<void(int, int)>* body = nullptr;
+    int rows = 0;
+    int bands = 0;
+    std::atomic<int> next{0};  // 下一个没人领的行带
+    int active = 0;            // 正在处理这个 Job 的工作线程数，受 mutex_ 保护
+};
+
+class RowPool {
+public:
+    static RowPool& instance() {
+        static RowPool pool(configuredThreads());
+        return pool;
+    }
+
+    int threads() const { return (int)workers_.size() + 1; }
+
+    void run(int rows, int bands, const std::function<void(int, int)>& body) {
+        // 同一时间只跑一个 Job；抢不到说明别的线程在用，串行算完即可
+        std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+        if (!busy.owns_lock()) {
+            body(0, rows);
+            return;
+        }
+
+        Job job;
+        job.body = &body;
+        job.rows = rows;
+        job.bands = bands;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            ++epoch_;
+        }
+        wake_.notify_all();
+
+        work(job);
+
+        // 调用线程领完了所有行带，再等还在算的工作线程退出这个 Job
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [&] { return job.active == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    explicit RowPool(int threads) {
+        for (int i = 1; i < threads; ++i) workers_.emplace_back([this] { loop(); });
+    }
+
+    ~RowPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    static void work(Job& job) {
+        tInsideBand = true;
+        for (int b = job.next.fetch_add(1); b < job.bands; b = job.next.fetch_add(1)) {
+            const int begin = (int)((int64_t)job.rows * b / job.bands);
+            const int end = (int)((int64_t)job.rows * (b + 1) / job.bands);
+            (*job.body)(begin, end);
+        }
+        tInsideBand = false;
+    }
+
+    void loop() {
+        uint64_t seen = 0;
+        for (;;) {
+            Job* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || (job_ && epoch_ != seen); });
+                if (stop_) return;
+                seen = epoch_;
+                job = job_;
+                ++job->active;
+            }
+            work(*job);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --job->active;
+            }
+            idle_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex busy_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    Job* job_ = nullptr;
+    uint64_t epoch_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace
+
+int parallelThreads() {
+    return RowPool::instance().threads();
+}
+
+void parallelForRows(int rows, const std::function<void(int, int)>& body, int minRowsPerBand) {
+    if (rows <= 0) return;
+    if (tInsideBand) {
+        body(0, rows);
+        return;
+    }
+    RowPool& pool = RowPool::instance();
+    // 每个线程一段连续的行，行数太少时少分几段，避免线程切换比计算还贵
+    const int bands = std::min(pool.threads(), std::max(1, rows / std::max(1, minRowsPerBand)));
+    if (bands == 1) {
+        body(0, rows);
+        return;
+    }
+    pool.run(rows, bands, body);
+}
@@ -0,0 +1,240 @@
+#include "rt_vision/shard.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'T', 'V', 'S', 'H', 'R', 'D', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kEntryFixedSize = 36;  // offset, size, hash (8 x 3) + width, height (4 x 2) + channels, nameLen (2 x 2)
+
+// 按小端逐字节读写，和机器字节序无关
+void putU16(std::vector<uint8_t>& out, uint16_t v) {
+    for (int i = 0; i < 2; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+void putU64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+uint64_t getLE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+}  // namespace
+
+uint64_t shardHash(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// === ShardWriter ===
+ShardWriter::~ShardWriter() {
+    if (file_) fclose(file_);
+}
+
+bool ShardWriter::fail(const std::string& message) {
+    error_ = message;
+    if (file_) fclose(file_);
+    file_ = nullptr;
+    return false;
+}
+
+bool ShardWriter::open(const std::string& path, uint32_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) return fail("alignment must be a power of two");
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) return fail("cannot create " + path);
+    alignment_ = alignment;
+    entries_.clear();
+
+    // 先占住文件头的位置，finish 时回填
+    const uint8_t zeros[kHeaderSize] = {};
+    if (fwrite(zeros, 1, kHeaderSize, file_) != kHeaderSize) return fail("write failed: " + path);
+    position_ = kHeaderSize;
+    return true;
+}
+
+bool ShardWriter::add(const std::string& name, const void* data, size_t size, int width, int height, int channels) {
+    if (!file_) return false;
+    if (name.size() > 0xFFFF) return fail("name too long: " + name);
+
+    const uint64_t aligned = (position_ + alignment_ - 1) & ~(uint64_t)(alignment_ - 1);
+    static const uint8_t zeros[4096] = {};
+    for (uint64_t pad = aligned - position_; pad > 0;) {
+        const size_t n = (size_t)std::min<uint64_t>(pad, sizeof(zeros));
+        if (fwrite(zeros, 1, n, file_) != n) return fail("write failed");
+        pad -= n;
+    }
+    if (size && fwrite(data, 1, size, file_) != size) return fail("write failed");
+
+    ShardEntry e;
+    e.name = name;
+    e.offset = aligned;
+    e.size = size;
+    e.hash = shardHash(data, size);
+    e.width = width;
+    e.height = height;
+    e.channels = channels;
+    entries_.push_back(std::move(e));
+    position_ = aligned + size;
+    return true;
+}
+
+bool ShardWriter::finish() {
+    if (!file_) return false;
+
+    std::vector<uint8_t> index;
+    for (const ShardEntry& e : entries_) {
+        putU64(index, e.offset);
+        putU64(index, e.size);
+        putU64(index, e.hash);
+        putU32(index, (uint32_t)e.width);
+        putU32(index, (uint32_t)e.height);
+        putU16(index, (uint16_t)e.channels);
+        putU16(index, (uint16_t)e.name.size());
+        index.insert(index.end(), e.name.begin(), e.name.end());
+    }
+    if (!index.empty() && fwrite(index.data(), 1, index.size(), file_) != index.size()) return fail("write failed");
+
+    std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+    putU32(header, kVersion);
+    putU32(header, (uint32_t)entries_.size());
+    putU32(header, alignment_);
+    putU32(header, 0);
+    putU64(header, position_);
+    putU64(header, index.size());
+    header.resize(kHeaderSize, 0);
+    if (fseek(file_, 0, SEEK_SET) != 0 || fwrite(header.data(), 1, kHeaderSize, file_) != kHeaderSize)
+        return fail("write failed");
+
+    const bool ok = fclose(file_) == 0;
+    file_ = nullptr;
+    return ok || fail("close failed");
+}
+
+// === ShardReader ===
+ShardReader::~ShardReader() {
+    close();
+}
+
+bool ShardReader::fail(const std::string& message) {
+    error_ = message;
+    close();
+    return false;
+}
+
+void ShardReader::close() {
+    if (base_) {
+#ifdef _WIN32
+        UnmapViewOfFile(base_);
+        CloseHandle((HANDLE)mapping_);
+#else
+        munmap((void*)base_, mappedSize_);
+#endif
+    }
+    base_ = nullptr;
+    mapping_ = nullptr;
+    mappedSize_ = 0;
+    entries_.clear();
+}
+
+bool ShardReader::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return fail("cannot open " + path);
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = size.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (!mapping) return fail("cannot map " + path);
+    base_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!base_) {
+        CloseHandle(mapping);
+        return fail("cannot map " + path);
+    }
+    mapping_ = mapping;
+    mappedSize_ = (size_t)size.QuadPart;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return fail("cannot stat " + path);
+    }
+    void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // 映射建立后文件描述符就不需要了
+    if (mapped == MAP_FAILED) return fail("cannot map " + path);
+    // 批处理基本按索引顺序读，让内核提前预读
+    madvise(mapped, (size_t)st.st_size, MADV_SEQUENTIAL);
+    base_ = static_cast<const uint8_t*>(mapped);
+    mappedSize_ = (size_t)st.st_size;
+#endif
+
+    // 校验文件头和索引，所有偏移都检查越界，损坏的 shard 不会读到映射之外
+    if (mappedSize_ < kHeaderSize || std::memcmp(base_, kMagic, sizeof(kMagic)) != 0)
+        return fail("not a shard file: " + path);
+    if (getLE(base_ + 8, 4) != kVersion) return fail("unsupported shard version: " + path);
+    const uint64_t count = getLE(base_ + 12, 4);
+    const uint64_t indexOffset = getLE(base_ + 24, 8);
+    const uint64_t indexSize = getLE(base_ + 32, 8);
+    if (indexOffset > mappedSize_ || indexSize > mappedSize_ - indexOffset) return fail("truncated shard: " + path);
+    if (count > indexSize / kEntryFixedSize) return fail("corrupt shard index: " + path);
+
+    const uint8_t* p = base_ + indexOffset;
+    const uint8_t* end = p + indexSize;
+    entries_.reserve((size_t)count);
+    for (uint64_t i = 0; i < count; ++i) {
+        if ((size_t)(end - p) < kEntryFixedSize) return fail("corrupt shard index: " + path);
+        ShardEntry e;
+        e.offset = getLE(p, 8);
+        e.size = getLE(p + 8, 8);
+        e.hash = getLE(p + 16, 8);
+        e.width = (int)getLE(p + 24, 4);
+        e.height = (int)getLE(p + 28, 4);
+        e.channels = (int)getLE(p + 32, 2);
+        const size_t nameLen = (size_t)getLE(p + 34, 2);
+        p += kEntryFixedSize;
+        if ((size_t)(end - p) < nameLen) return fail("corrupt shard index: " + path);
+        e.name.assign(reinterpret_cast<const char*>(p), nameLen);
+        p += nameLen;
+        if (e.offset > indexOffset || e.size > indexOffset - e.offset) return fail("corrupt shard entry: " + e.name);
+        entries_.push_back(std::move(e));
+    }
+    return true;
+}
+
+int ShardReader::find(const std::string& name) const {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+bool ShardReader::verify(size_t i) const {
+    return shardHash(data(i), (size_t)entries_[i].size) == entries_[i].hash;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// === SIMD 公共定义 (只在 src 内部使用) ===
+// 不给整个工程加 -mavx2：各个 SIMD 函数用 target 属性单独开启指令集，
+// 运行时再由 cpuFeatures() 决定调哪个版本，老 CPU 上也能正常运行。
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RTV_X86 1
+#include <immintrin.h>
+#else
+#define RTV_X86 0
+#endif
+
+#if RTV_X86 && (defined(__GNUC__) || defined(__clang__))
+#define RTV_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define RTV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+// MSVC 不需要额外开关就能使用所有 intrinsic
+#define RTV_TARGET_SSE41
+#define RTV_TARGET_AVX2
+#endif
@@ -0,0 +1,331 @@
+#include "rt_vision/trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t ts;
+    int64_t arg;  // 'X' 是持续时间，'C' 是数值
+    char phase;
+};
+
+// 每个线程一块，只有所属线程写；count 用 release 发布，导出线程 acquire 读到的 [0, count) 都是写完的
+struct ThreadBuffer {
+    static constexpr size_t kCapacity = 1 << 16;
+
+    int tid = 0;
+    std::string name;  // 受 Registry::mutex 保护
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[kCapacity]};
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+
+    void push(const char* n, char phase, int64_t ts, int64_t arg) {
+        const size_t i = count.load(std::memory_order_relaxed);
+        if (i >= kCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[i] = {n, ts, arg, phase};
+        count.store(i + 1, std::memory_order_release);
+    }
+};
+
+// 所有线程的缓冲区；线程退出后缓冲区仍然保留，导出时还能看到
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+
+// 第一次记录事件时注册，之后每次只是一个 thread_local 指针
+ThreadBuffer& localBuffer() {
+    if (!tBuffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffer->tid = (int)r.buffers.size() + 1;
+        r.buffers.push_back(buffer);
+        tBuffer = buffer.get();
+    }
+    return *tBuffer;
+}
+
+std::atomic<bool> gEnabled{std::getenv("RT_VISION_TRACE") != nullptr};
+
+void writeJsonString(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            os << buf;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+struct LogQueue {
+    std::mutex mutex;
+    std::vector<std::string> lines;
+};
+
+LogQueue& logQueue() {
+    static LogQueue q;
+    return q;
+}
+
+}  // namespace
+
+void setTracingEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool tracingEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+std::string traceOutputPath() {
+    const char* path = std::getenv("RT_VISION_TRACE");
+    return path ? path : "";
+}
+
+// === 指标 ===
+void LatencyHistogram::record(int64_t us) {
+    us = std::max<int64_t>(us, 0);
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && (int64_t(1) << bucket) <= us) ++bucket;
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+    int64_t prev = max_.load(std::memory_order_relaxed);
+    while (us > prev && !max_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::meanUs() const {
+    const uint64_t n = count();
+    return n ? (double)sum_.load(std::memory_order_relaxed) / n : 0.0;
+}
+
+int64_t LatencyHistogram::percentileUs(double p) const {
+    const uint64_t n = count();
+    if (n == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(p * n + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(int64_t(1) << i, maxUs());
+    }
+    return maxUs();
+}
+
+void Gauge::add(int64_t delta) {
+    updatePeak(value_.fetch_add(delta, std::memory_order_relaxed) + delta);
+}
+
+void Gauge::set(int64_t v) {
+    value_.store(v, std::memory_order_relaxed);
+    updatePeak(v);
+}
+
+void Gauge::updatePeak(int64_t v) {
+    int64_t prev = peak_.load(std::memory_order_relaxed);
+    while (v > prev && !peak_.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {
+    }
+}
+
+// === 追踪 ===
+TraceSpan::~TraceSpan() {
+    const int64_t end = traceNowUs();
+    if (histogram_) histogram_->record(end - begin_);
+    if (tracingEnabled()) localBuffer().push(name_, 'X', begin_, end - begin_);
+}
+
+void traceComplete(const char* name, int64_t beginUs, int64_t endUs) {
+    if (tracingEnabled()) localBuffer().push(name, 'X', beginUs, endUs - beginUs);
+}
+
+void traceCounter(const char* name, int64_t value) {
+    if (tracingEnabled()) localBuffer().push(name, 'C', traceNowUs(), value);
+}
+
+void setTraceThreadName(const std::string& name) {
+    if (!tracingEnabled()) return;  // 不追踪时不为这个线程分配缓冲区
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream os(path);
+    if (!os) return false;
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) os << ",\n";
+        first = false;
+    };
+    for (const auto& buffer : r.buffers) {
+        const std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name;
+        separator();
+        os << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        writeJsonString(os, name);
+        os << "}}";
+
+        const size_t n = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            const TraceEvent& e = buffer->events[i];
+            separator();
+            os << "{\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":" << e.ts << ",\"name\":";
+            writeJsonString(os, e.name);
+            if (e.phase == 'X')
+                os << ",\"dur\":" << e.arg << "}";
+            else
+                os << ",\"args\":{\"value\":" << e.arg << "}}";
+        }
+
+        const uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped) {
+            separator();
+            os << "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->tid
+               << ",\"ts\":" << (n ? buffer->events[n - 1].ts : 0) << ",\"name\":\"dropped " << dropped
+               << " events\"}";
+        }
+    }
+    os << "\n]}\n";
+    return (bool)os;
+}
+
+// === Metrics ===
+Counter& Metrics::counter(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = counters_[name];
+    if (!slot) slot.reset(new Counter);
+    return *slot;
+}
+
+Gauge& Metrics::gauge(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = gauges_[name];
+    if (!slot) slot.reset(new Gauge);
+    return *slot;
+}
+
+LatencyHistogram& Metrics::histogram(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = histograms_[name];
+    if (!slot) slot.reset(new LatencyHistogram);
+    return *slot;
+}
+
+bool Metrics::report(std::ostream& os, bool force) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t now = traceNowUs();
+    const double seconds = (now - lastReportUs_) / 1e6;
+
+    // 先看有没有变化，没有就不打印
+    bool changed = force;
+    for (const auto& kv : counters_) changed |= lastCounts_["c:" + kv.first] != kv.second->value();
+    for (const auto& kv : gauges_) changed |= lastCounts_["g:" + kv.first] != (uint64_t)kv.second->value();
+    for (const auto& kv : histograms_) changed |= lastCounts_["h:" + kv.first] != kv.second->count();
+    if (!changed) return false;
+
+    char buf[160];
+    os << "[metrics]";
+    for (const auto& kv : counters_) {
+        const uint64_t v = kv.second->value();
+        uint64_t& last = lastCounts_["c:" + kv.first];
+        const double rate = seconds > 0 ? (v - last) / seconds : 0.0;
+        const bool bytes = kv.first.size() >= 5 && kv.first.compare(kv.first.size() - 5, 5, "bytes") == 0;
+        if (bytes)
+            std::snprintf(buf, sizeof(buf), " %s %.1f MB (%.1f MB/s)", kv.first.c_str(), v / 1e6, rate / 1e6);
+        else
+            std::snprintf(buf, sizeof(buf), " %s %llu (%.1f/s)", kv.first.c_str(), (unsigned long long)v, rate);
+        os << buf;
+        last = v;
+    }
+    for (const auto& kv : gauges_) {
+        std::snprintf(buf, sizeof(buf), " %s %lld (peak %lld)", kv.first.c_str(), (long long)kv.second->value(),
+                      (long long)kv.second->peak());
+        os << buf;
+        lastCounts_["g:" + kv.first] = (uint64_t)kv.second->value();
+    }
+    for (const auto& kv : histograms_) {
+        const LatencyHistogram& h = *kv.second;
+        if (h.count() == 0) continue;
+        std::snprintf(buf, sizeof(buf), " %s p50 %.1fms p99 %.1fms max %.1fms", kv.first.c_str(),
+                      h.percentileUs(0.5) / 1e3, h.percentileUs(0.99) / 1e3, h.maxUs() / 1e3);
+        os << buf;
+        lastCounts_["h:" + kv.first] = h.count();
+    }
+    os << std::endl;
+    lastReportUs_ = now;
+    return true;
+}
+
+Metrics& metrics() {
+    static Metrics m;
+    return m;
+}
+
+// === 异步日志 ===
+void logAsync(std::string line) {
+    LogQueue& q = logQueue();
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.lines.push_back(std::move(line));
+}
+
+void flushLog(std::ostream& os) {
+    std::vector<std::string> lines;
+    {
+        LogQueue& q = logQueue();
+        std::lock_guard<std::mutex> lock(q.mutex);
+        lines.swap(q.lines);
+    }
+    for (const auto& line : lines) os << line << '\n';
+    if (!lines.empty()) os.flush();
+}
+
+MetricsReporter::MetricsReporter(std::ostream& os, std::chrono::milliseconds interval)
+    : os_(os), interval_(interval), thread_(&MetricsReporter::loop, this) {}
+
+MetricsReporter::~MetricsReporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void MetricsReporter::loop() {
+    setTraceThreadName("metrics");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        const bool stop = cv_.wait_for(lock, interval_, [&] { return stop_; });
+        lock.unlock();
+        flushLog(os_);
+        metrics().report(os_);
+        lock.lock();
+        if (stop) return;
+    }
+}
@@ -0,0 +1,402 @@
+#include "rt_vision/warp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#include "rt_vision/cpu_features.h"
+#include "rt_vision/pixel.h"
+#include "simd.h"
+
+namespace {
+
+// 插值权重的定点位数：权重范围 0..2048，水平 + 垂直两次乘法后右移 22 位
+constexpr int kCoefBits = 11;
+constexpr int kCoefOne = 1 << kCoefBits;
+
+// 仿射变换里坐标的定点位数
+constexpr int kAffineBits = 16;
+
+// 把坐标 v 拆成整数部分和 11 位的小数权重，权重四舍五入到 2048 时进位
+void splitCoord(double v, int& i, int& w) {
+    i = (int)std::floor(v);
+    w = (int)std::lround((v - i) * kCoefOne);
+    if (w >= kCoefOne) {
+        ++i;
+        w = 0;
+    }
+}
+
+// === 垂直方向混合：out = (b0 * (2048 - w) + b1 * w + 2^21) >> 22 ===
+// 写成 b0 * 2048 + (b1 - b0) * w，和上式整数结果完全相同，少一次乘法
+
+void blendRowsScalar(const int* b0, const int* b1, int w, uint8_t* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        out[i] = (uint8_t)(((b0[i] << kCoefBits) + (b1[i] - b0[i]) * w + (1 << (2 * kCoefBits - 1))) >>
+                           (2 * kCoefBits));
+    }
+}
+
+#if RTV_X86
+
+RTV_TARGET_SSE41 inline __m128i blend4(const int* b0, const int* b1, __m128i w, __m128i round) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)b0);
+    const __m128i b = _mm_loadu_si128((const __m128i*)b1);
+    const __m128i v = _mm_add_epi32(_mm_slli_epi32(a, kCoefBits), _mm_mullo_epi32(_mm_sub_epi32(b, a), w));
+    return _mm_srai_epi32(_mm_add_epi32(v, round), 2 * kCoefBits);
+}
+
+RTV_TARGET_SSE41 int blendRowsSse41(const int* b0, const int* b1, int w, uint8_t* out, int n) {
+    const __m128i wv = _mm_set1_epi32(w);
+    const __m128i round = _mm_set1_epi32(1 << (2 * kCoefBits - 1));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i lo = _mm_packs_epi32(blend4(b0 + i, b1 + i, wv, round), blend4(b0 + i + 4, b1 + i + 4, wv, round));
+        const __m128i hi =
+            _mm_packs_epi32(blend4(b0 + i + 8, b1 + i + 8, wv, round), blend4(b0 + i + 12, b1 + i + 12, wv, round));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+RTV_TARGET_AVX2 inline __m256i blend8(const int* b0, const int* b1, __m256i w, __m256i round) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)b0);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)b1);
+    const __m256i v = _mm256_add_epi32(_mm256_slli_epi32(a, kCoefBits), _mm256_mullo_epi32(_mm256_sub_epi32(b, a), w));
+    return _mm256_srai_epi32(_mm256_add_epi32(v, round), 2 * kCoefBits);
+}
+
+RTV_TARGET_AVX2 int blendRowsAvx2(const int* b0, const int* b1, int w, uint8_t* out, int n) {
+    const __m256i wv = _mm256_set1_epi32(w);
+    const __m256i round = _mm256_set1_epi32(1 << (2 * kCoefBits - 1));
+    // pack 指令在两个 128 位通道内各自交错，最后按 dword 重排回原来的顺序
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i ab = _mm256_packs_epi32(blend8(b0 + i, b1 + i, wv, round), blend8(b0 + i + 8, b1 + i + 8, wv, round));
+        const __m256i cd =
+            _mm256_packs_epi32(blend8(b0 + i + 16, b1 + i + 16, wv, round), blend8(b0 + i + 24, b1 + i + 24, wv, round));
+        const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+        _mm256_storeu_si256((__m256i*)(out + i), bytes);
+    }
+    return i;
+}
+
+#endif  // RTV_X86
+
+void blendRows(const int* b0, const int* b1, int w, uint8_t* out, int n) {
+    int done = 0;
+#if RTV_X86
+    if (cpuFeatures().avx2)
+        done = blendRowsAvx2(b0, b1, w, out, n);
+    else if (cpuFeatures().sse41)
+        done = blendRowsSse41(b0, b1, w, out, n);
+#endif
+    blendRowsScalar(b0 + done, b1 + done, w, out + done, n - done);
+}
+
+// === 按通道类型选择插值的算术 ===
+// 8 位：int 定点 (垂直方向有 SIMD)；16 位：同样的定点公式，但 65535 * 2^22 超出 int，用 int64；
+// float：直接用浮点，权重取 w / 2048
+template <typename T>
+struct Lerp;
+
+template <>
+struct Lerp<uint8_t> {
+    using Acc = int;
+    static Acc horizontal(uint8_t a, uint8_t b, int w) { return (a << kCoefBits) + (b - a) * w; }
+    static uint8_t vertical(Acc top, Acc bottom, int w) {
+        return (uint8_t)(((top << kCoefBits) + (bottom - top) * w + (1 << (2 * kCoefBits - 1))) >> (2 * kCoefBits));
+    }
+    static void rows(const Acc* b0, const Acc* b1, int w, uint8_t* out, int n) { blendRows(b0, b1, w, out, n); }
+};
+
+template <>
+struct Lerp<uint16_t> {
+    using Acc = int64_t;
+    static Acc horizontal(uint16_t a, uint16_t b, int w) { return ((Acc)a << kCoefBits) + (Acc)(b - a) * w; }
+    static uint16_t vertical(Acc top, Acc bottom, int w) {
+        return (uint16_t)(((top << kCoefBits) + (bottom - top) * w + ((Acc)1 << (2 * kCoefBits - 1))) >>
+                          (2 * kCoefBits));
+    }
+    static void rows(const Acc* b0, const Acc* b1, int w, uint16_t* out, int n) {
+        for (int i = 0; i < n; ++i) out[i] = vertical(b0[i], b1[i], w);
+    }
+};
+
+template <>
+struct Lerp<float> {
+    using Acc = float;
+    static Acc horizontal(float a, float b, int w) { return a + (b - a) * (w * (1.0f / kCoefOne)); }
+    static float vertical(Acc top, Acc bottom, int w) { return top + (bottom - top) * (w * (1.0f / kCoefOne)); }
+    static void rows(const Acc* b0, const Acc* b1, int w, float* out, int n) {
+        for (int i = 0; i < n; ++i) out[i] = vertical(b0[i], b1[i], w);
+    }
+};
+
+// 整数区间 [lo, hi)：0 <= x < n 且 minV <= start + x * step <= maxV
+void solveRange(int64_t start, int64_t step, int64_t minV, int64_t maxV, int n, int& lo, int& hi) {
+    // 向下 / 向上取整的整数除法 (除数为正)
+    auto floorDiv = [](int64_t a, int64_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); };
+    auto ceilDiv = [](int64_t a, int64_t b) { return a >= 0 ? (a + b - 1) / b : -((-a) / b); };
+
+    int64_t l = 0, h = n;
+    if (step == 0) {
+        if (start < minV || start > maxV) h = 0;
+    } else if (step > 0) {
+        l = ceilDiv(minV - start, step);
+        h = floorDiv(maxV - start, step) + 1;
+    } else {
+        l = ceilDiv(start - maxV, -step);
+        h = floorDiv(start - minV, -step) + 1;
+    }
+    lo = (int)std::clamp<int64_t>(l, 0, n);
+    hi = (int)std::clamp<int64_t>(h, lo, n);
+}
+
+}  // namespace
+
+CropRect zoomCrop(int srcW, int srcH, float centerX, float centerY, float zoom) {
+    if (zoom <= 0) zoom = 1.0f;
+    CropRect r;
+    r.width = srcW / zoom;
+    r.height = srcH / zoom;
+    r.x = srcW * centerX - r.width / 2;
+    r.y = srcH * centerY - r.height / 2;
+    return r;
+}
+
+ScaleMap::ScaleMap(int srcW, int srcH, const CropRect& crop, int outW, int outH)
+    : srcW_(srcW), srcH_(srcH), outW_(outW), outH_(outH) {
+    // 像素中心对齐：输出第 i 列的中心 (i + 0.5) 映射到源图 crop.x + (i + 0.5) * 缩放比
+    const double sx = (double)crop.width / outW;
+    const double sy = (double)crop.height / outH;
+
+    xOfs0_.resize(outW);
+    xOfs1_.resize(outW);
+    xWeight_.resize(outW);
+    xNear_.resize(outW);
+    xBegin_ = xEnd_ = 0;
+    bool inInterior = false;
+    for (int i = 0; i < outW; ++i) {
+        const double fx = crop.x + (i + 0.5) * sx;
+        int x0, w;
+        splitCoord(fx - 0.5, x0, w);
+        xOfs0_[i] = std::clamp(x0, 0, srcW - 1);
+        xOfs1_[i] = std::clamp(x0 + 1, 0, srcW - 1);
+        xWeight_[i] = w;
+        xNear_[i] = std::clamp((int)std::floor(fx), 0, srcW - 1);
+
+        // 源坐标随 i 单调递增，左右两个像素都在图内的列是连续的一段
+        const bool interior = x0 >= 0 && x0 + 1 <= srcW - 1;
+        if (interior && !inInterior) xBegin_ = i;
+        if (interior) xEnd_ = i + 1;
+        inInterior = interior;
+    }
+
+    yRow0_.resize(outH);
+    yRow1_.resize(outH);
+    yWeight_.resize(outH);
+    yNear_.resize(outH);
+    for (int j = 0; j < outH; ++j) {
+        const double fy = crop.y + (j + 0.5) * sy;
+        int y0, w;
+        splitCoord(fy - 0.5, y0, w);
+        yRow0_[j] = std::clamp(y0, 0, srcH - 1);
+        yRow1_[j] = std::clamp(y0 + 1, 0, srcH - 1);
+        yWeight_[j] = w;
+        yNear_[j] = std::clamp((int)std::floor(fy), 0, srcH - 1);
+    }
+}
+
+template <typename P>
+void ScaleMap::applyBilinear(const P* src, P* dst) const {
+    using T = typename P::Type;
+    using Acc = typename Lerp<T>::Acc;
+    constexpr int cn = P::kChannels;
+    const int rowLen = outW_ * cn;
+
+    // 水平方向插值：中间段右边像素就是 p + 1，两边的边缘列用表里截断过的下标
+    auto horizontal = [&](const P* row, Acc* out) {
+        int x = 0;
+        for (; x < xBegin_; ++x) {
+            const P& a = row[xOfs0_[x]];
+            const P& b = row[xOfs1_[x]];
+            for (int c = 0; c < cn; ++c) out[x * cn + c] = Lerp<T>::horizontal(a[c], b[c], xWeight_[x]);
+        }
+        for (; x < xEnd_; ++x) {
+            const P* p = row + xOfs0_[x];
+            const int w = xWeight_[x];
+            for (int c = 0; c < cn; ++c) out[x * cn + c] = Lerp<T>::horizontal(p[0][c], p[1][c], w);
+        }
+        for (; x < outW_; ++x) {
+            const P& a = row[xOfs0_[x]];
+            const P& b = row[xOfs1_[x]];
+            for (int c = 0; c < cn; ++c) out[x * cn + c] = Lerp<T>::horizontal(a[c], b[c], xWeight_[x]);
+        }
+    };
+
+    // 两行水平插值结果的缓存，放大时相邻的输出行常常用同一对源行
+    std::vector<Acc> buffer(2 * (size_t)rowLen);
+    Acc* rows[2] = {buffer.data(), buffer.data() + rowLen};
+    int cached[2] = {-1, -1};
+
+    for (int y = 0; y < outH_; ++y) {
+        const int r0 = yRow0_[y], r1 = yRow1_[y];
+        if (cached[0] != r0) {
+            if (cached[1] == r0) {
+                std::swap(rows[0], rows[1]);
+                std::swap(cached[0], cached[1]);
+            } else {
+                horizontal(src + (size_t)r0 * srcW_, rows[0]);
+                cached[0] = r0;
+            }
+        }
+        if (cached[1] != r1) {
+            horizontal(src + (size_t)r1 * srcW_, rows[1]);
+            cached[1] = r1;
+        }
+        Lerp<T>::rows(rows[0], rows[1], yWeight_[y], reinterpret_cast<T*>(dst + (size_t)y * outW_), rowLen);
+    }
+}
+
+template <typename P>
+void ScaleMap::applyNearest(const P* src, P* dst) const {
+    for (int y = 0; y < outH_; ++y) {
+        const P* row = src + (size_t)yNear_[y] * srcW_;
+        P* out = dst + (size_t)y * outW_;
+        for (int x = 0; x < outW_; ++x) out[x] = row[xNear_[x]];
+    }
+}
+
+bool ScaleMap::apply(const Image& src, Image& dst, Interpolation interp) const {
+    if (!src.data || src.width != srcW_ || src.height != srcH_) return false;
+    if (outW_ <= 0 || outH_ <= 0) return false;
+
+    unsigned char* out = (unsigned char*)malloc((size_t)outW_ * outH_ * src.pixelBytes());
+    // 按 (通道数, 类型) 选一次实例，内层的通道循环在编译期展开
+    const bool ok = visitPixel(src, [&](auto tag) {
+        using P = typename decltype(tag)::type;
+        if (interp == Interpolation::kBilinear)
+            applyBilinear(pixelsOf<P>(src), reinterpret_cast<P*>(out));
+        else
+            applyNearest(pixelsOf<P>(src), reinterpret_cast<P*>(out));
+    });
+    if (!ok) {
+        free(out);
+        return false;
+    }
+    dst.adopt(out, outW_, outH_, src.channels, src.type);
+    return true;
+}
+
+ZoomPlan::ZoomPlan(int srcW, int srcH, int outW, int outH, float centerX, float centerY,
+                   const std::vector<float>& zooms)
+    : zooms_(zooms) {
+    for (float z : zooms_) maps_.emplace_back(srcW, srcH, zoomCrop(srcW, srcH, centerX, centerY, z), outW, outH);
+}
+
+bool ZoomPlan::matches(const Image& src) const {
+    return !maps_.empty() && src.width == maps_[0].srcWidth() && src.height == maps_[0].srcHeight();
+}
+
+bool ZoomPlan::apply(const Image& src, int level, Image& dst, Interpolation interp) const {
+    if (level < 0 || level >= levels()) return false;
+    return maps_[level].apply(src, dst, interp);
+}
+
+void digitalZoom(const Image& src, Image& dst, int outW, int outH, float centerX_ratio, float centerY_ratio,
+                 float zoomLevel, Interpolation interp) {
+    const ScaleMap map(src.width, src.height, zoomCrop(src.width, src.height, centerX_ratio, centerY_ratio, zoomLevel),
+                       outW, outH);
+    map.apply(src, dst, interp);
+}
+
+// 仿射变换的一行：[0, lo) 和 [hi, outW) 要截断坐标，[lo, hi) 不用
+template <typename P>
+static void affineRow(const P* src, int W, int H, P* row, int outW, int64_t X0, int64_t Y0, int64_t dX, int64_t dY,
+                      int lo, int hi, bool bilinear) {
+    using T = typename P::Type;
+    constexpr int cn = P::kChannels;
+    const int64_t half = 1 << (kAffineBits - 1);
+    const int fracShift = kAffineBits - kCoefBits;
+
+    // clampIt 为常量，编译器会为中间段生成不带截断的版本
+    auto pixel = [&](int x, bool clampIt) {
+        const int64_t X = X0 + x * dX, Y = Y0 + x * dY;
+        if (!bilinear) {
+            int sx = (int)((X + half) >> kAffineBits), sy = (int)((Y + half) >> kAffineBits);
+            if (clampIt) {
+                sx = std::clamp(sx, 0, W - 1);
+                sy = std::clamp(sy, 0, H - 1);
+            }
+            row[x] = src[(size_t)sy * W + sx];
+            return;
+        }
+
+        int x0 = (int)(X >> kAffineBits), y0 = (int)(Y >> kAffineBits);
+        const int wx = (int)((X >> fracShift) & (kCoefOne - 1));
+        const int wy = (int)((Y >> fracShift) & (kCoefOne - 1));
+        int x1 = x0 + 1, y1 = y0 + 1;
+        if (clampIt) {
+            x0 = std::clamp(x0, 0, W - 1);
+            x1 = std::clamp(x1, 0, W - 1);
+            y0 = std::clamp(y0, 0, H - 1);
+            y1 = std::clamp(y1, 0, H - 1);
+        }
+        const P& p00 = src[(size_t)y0 * W + x0];
+        const P& p01 = src[(size_t)y0 * W + x1];
+        const P& p10 = src[(size_t)y1 * W + x0];
+        const P& p11 = src[(size_t)y1 * W + x1];
+        for (int c = 0; c < cn; ++c) {
+            const auto top = Lerp<T>::horizontal(p00[c], p01[c], wx);
+            const auto bottom = Lerp<T>::horizontal(p10[c], p11[c], wx);
+            row[x][c] = Lerp<T>::vertical(top, bottom, wy);
+        }
+    };
+
+    int x = 0;
+    for (; x < lo; ++x) pixel(x, true);
+    for (; x < hi; ++x) pixel(x, false);
+    for (; x < outW; ++x) pixel(x, true);
+}
+
+void warpAffine(const Image& src, Image& dst, int outW, int outH, const float m[6], Interpolation interp) {
+    if (!src.data || outW <= 0 || outH <= 0) return;
+    const int W = src.width, H = src.height;
+    unsigned char* out = (unsigned char*)malloc((size_t)outW * outH * src.pixelBytes());
+
+    // 坐标用 16 位小数的定点数，每往右一个像素加一次固定的增量
+    const double one = 1 << kAffineBits;
+    const int64_t half = 1 << (kAffineBits - 1);
+    const int64_t dX = std::llround(m[0] * one), dY = std::llround(m[3] * one);
+    const bool bilinear = interp == Interpolation::kBilinear;
+
+    const bool ok = visitPixel(src, [&](auto tag) {
+        using P = typename decltype(tag)::type;
+        for (int y = 0; y < outH; ++y) {
+            const int64_t X0 = std::llround(((double)m[1] * y + m[2]) * one);
+            const int64_t Y0 = std::llround(((double)m[4] * y + m[5]) * one);
+
+            // 这一行里不需要截断坐标的一段 [lo, hi)：双线性要求右下的邻居也在图内，最近邻按四舍五入后的坐标判断
+            int xlo, xhi, ylo, yhi;
+            if (bilinear) {
+                solveRange(X0, dX, 0, ((int64_t)(W - 1) << kAffineBits) - 1, outW, xlo, xhi);
+                solveRange(Y0, dY, 0, ((int64_t)(H - 1) << kAffineBits) - 1, outW, ylo, yhi);
+            } else {
+                solveRange(X0, dX, -half, ((int64_t)(W - 1) << kAffineBits) + half - 1, outW, xlo, xhi);
+                solveRange(Y0, dY, -half, ((int64_t)(H - 1) << kAffineBits) + half - 1, outW, ylo, yhi);
+            }
+            const int lo = std::max(xlo, ylo);
+            const int hi = std::max(lo, std::min(xhi, yhi));
+            affineRow(pixelsOf<P>(src), W, H, reinterpret_cast<P*>(out) + (size_t)y * outW, outW, X0, Y0, dX, dY, lo,
+                      hi, bilinear);
+        }
+    });
+    if (!ok) {
+        free(out);
+        return;
+    }
+    dst.adopt(out, outW, outH, src.channels, src.type);
+}
@@ -0,0 +1,204 @@
+#pragma once
+// 测试用的最小基线 JPEG 编码器：可以指定亮度采样因子 (4:4:4 / 4:2:2 / 4:4:0 / 4:2:0) 和重启间隔 (DRI + RSTn)。
+// stb_image_write 写不出重启标记，并行解码 (jpeg_decoder.cpp) 的 golden 测试和 perf 需要自己生成输入，
+// 不用往仓库里放二进制图片。只追求格式正确，不追求压缩率：所有分量共用一张量化表和 Annex K 的亮度霍夫曼表。
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace jpeg_test {
+
+// 输入紧密排列的 8 位像素 (1 通道灰度或 3 通道 RGB)；hs / vs 是亮度的采样因子 (1 或 2)，色度固定 1x1；
+// restartInterval 为 0 时不写 DRI
+inline std::vector<uint8_t> encode(const uint8_t* pixels, int w, int h, int channels, int hs, int vs,
+                                   int restartInterval, int quality = 90) {
+    static const uint8_t kZigzag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+    static const uint8_t kLumaQuant[64] = {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+                                           14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+                                           18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+                                           49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+    static const uint8_t kDcBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+    static const uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    static const uint8_t kAcBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+    static const uint8_t kAcValues[162] = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71,
+        0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+        0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37,
+        0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+        0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+        0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+        0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+        0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+        0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+    if (channels == 1) hs = vs = 1;
+    std::vector<uint8_t> out;
+    auto put16 = [&](int v) {
+        out.push_back((uint8_t)(v >> 8));
+        out.push_back((uint8_t)v);
+    };
+
+    // 规范霍夫曼码：按码长从短到长依次分配
+    struct Code {
+        uint16_t bits = 0;
+        uint8_t length = 0;
+    };
+    auto buildCodes = [](const uint8_t* counts, const uint8_t* values, Code* table) {
+        int code = 0, k = 0;
+        for (int len = 1; len <= 16; ++len, code <<= 1)
+            for (int i = 0; i < counts[len - 1]; ++i, ++code) table[values[k++]] = {(uint16_t)code, (uint8_t)len};
+    };
+    Code dcCodes[256], acCodes[256];
+    buildCodes(kDcBits, kDcValues, dcCodes);
+    buildCodes(kAcBits, kAcValues, acCodes);
+
+    uint8_t quant[64];
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    for (int i = 0; i < 64; ++i) quant[i] = (uint8_t)std::clamp((kLumaQuant[i] * scale + 50) / 100, 1, 255);
+
+    // 文件头：SOI、JFIF (stb 据此按 YCbCr 解释 3 个分量)、DQT、SOF0、DHT、DRI、SOS
+    out.insert(out.end(), {0xFF, 0xD8, 0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0});
+    out.insert(out.end(), {0xFF, 0xDB, 0, 67, 0});
+    for (int i = 0; i < 64; ++i) out.push_back(quant[kZigzag[i]]);
+    out.insert(out.end(), {0xFF, 0xC0});
+    put16(8 + 3 * channels);
+    out.push_back(8);
+    put16(h);
+    put16(w);
+    out.push_back((uint8_t)channels);
+    for (int c = 0; c < channels; ++c) {
+        out.push_back((uint8_t)(c + 1));
+        out.push_back(c == 0 ? (uint8_t)(hs << 4 | vs) : 0x11);
+        out.push_back(0);
+    }
+    out.insert(out.end(), {0xFF, 0xC4});
+    put16(2 + 2 * 17 + 12 + 162);
+    out.push_back(0x00);
+    out.insert(out.end(), kDcBits, kDcBits + 16);
+    out.insert(out.end(), kDcValues, kDcValues + 12);
+    out.push_back(0x10);
+    out.insert(out.end(), kAcBits, kAcBits + 16);
+    out.insert(out.end(), kAcValues, kAcValues + 162);
+    if (restartInterval > 0) {
+        out.insert(out.end(), {0xFF, 0xDD, 0, 4});
+        put16(restartInterval);
+    }
+    out.insert(out.end(), {0xFF, 0xDA});
+    put16(6 + 2 * channels);
+    out.push_back((uint8_t)channels);
+    for (int c = 0; c < channels; ++c) {
+        out.push_back((uint8_t)(c + 1));
+        out.push_back(0x00);
+    }
+    out.insert(out.end(), {0, 63, 0});
+
+    // 分量平面 (YCbCr)，色度按采样因子取平均；越界的像素取边缘
+    auto sample = [&](int x, int y, int c) {
+        x = std::min(x, w - 1);
+        y = std::min(y, h - 1);
+        const uint8_t* p = pixels + ((size_t)y * w + x) * channels;
+        if (channels == 1) return (float)p[0];
+        const float r = p[0], g = p[1], b = p[2];
+        if (c == 0) return 0.299f * r + 0.587f * g + 0.114f * b;
+        if (c == 1) return -0.168736f * r - 0.331264f * g + 0.5f * b + 128;
+        return 0.5f * r - 0.418688f * g - 0.081312f * b + 128;
+    };
+
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    auto putBits = [&](uint32_t bits, int length) {
+        bitBuffer = bitBuffer << length | (bits & ((1u << length) - 1));
+        bitCount += length;
+        while (bitCount >= 8) {
+            const uint8_t byte = (uint8_t)(bitBuffer >> (bitCount - 8));
+            out.push_back(byte);
+            if (byte == 0xFF) out.push_back(0);  // 字节填充
+            bitCount -= 8;
+        }
+    };
+    auto flushBits = [&] {
+        if (bitCount > 0) putBits(0x7F, 8 - bitCount);  // 剩下的位补 1
+    };
+    auto magnitude = [](int v, int& size) {
+        const int a = std::abs(v);
+        size = 0;
+        while ((1 << size) <= a) ++size;
+        return (uint32_t)(v < 0 ? v - 1 : v);
+    };
+
+    double cosTable[8][8];  // cos((2x + 1) u pi / 16)
+    for (int x = 0; x < 8; ++x)
+        for (int u = 0; u < 8; ++u) cosTable[x][u] = std::cos((2 * x + 1) * u * M_PI / 16);
+
+    int dcPred[3] = {0, 0, 0};
+    // 左上角在 (x0, y0) 的一个 8x8 块 (分量坐标)；色度的一个分量像素对应 hs x vs 个图像像素
+    auto encodeBlock = [&](int comp, int x0, int y0) {
+        const int sx = comp == 0 ? 1 : hs, sy = comp == 0 ? 1 : vs;
+        float block[64];
+        for (int y = 0; y < 8; ++y)
+            for (int x = 0; x < 8; ++x) {
+                float sum = 0;
+                for (int dy = 0; dy < sy; ++dy)
+                    for (int dx = 0; dx < sx; ++dx) sum += sample((x0 + x) * sx + dx, (y0 + y) * sy + dy, comp);
+                block[y * 8 + x] = sum / (sx * sy) - 128;
+            }
+        int coef[64];
+        for (int v = 0; v < 8; ++v)
+            for (int u = 0; u < 8; ++u) {
+                double sum = 0;
+                for (int y = 0; y < 8; ++y)
+                    for (int x = 0; x < 8; ++x)
+                        sum += block[y * 8 + x] * cosTable[x][u] * cosTable[y][v];
+                const double cu = u ? 1 : M_SQRT1_2, cv = v ? 1 : M_SQRT1_2;
+                coef[v * 8 + u] = (int)std::lround(sum * cu * cv / 4 / quant[v * 8 + u]);
+            }
+
+        int size;
+        const int diff = coef[0] - dcPred[comp];
+        dcPred[comp] = coef[0];
+        uint32_t bits = magnitude(diff, size);
+        putBits(dcCodes[size].bits, dcCodes[size].length);
+        if (size) putBits(bits, size);
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            const int v = coef[kZigzag[k]];
+            if (v == 0) {
+                ++run;
+                continue;
+            }
+            for (; run >= 16; run -= 16) putBits(acCodes[0xF0].bits, acCodes[0xF0].length);
+            bits = magnitude(v, size);
+            const int symbol = run << 4 | size;
+            putBits(acCodes[symbol].bits, acCodes[symbol].length);
+            putBits(bits, size);
+            run = 0;
+        }
+        if (run) putBits(acCodes[0].bits, acCodes[0].length);  // EOB
+    };
+
+    const int mcuW = 8 * hs, mcuH = 8 * vs;
+    const int mcusX = (w + mcuW - 1) / mcuW, mcusY = (h + mcuH - 1) / mcuH;
+    const int mcus = mcusX * mcusY;
+    for (int m = 0; m < mcus; ++m) {
+        if (restartInterval > 0 && m > 0 && m % restartInterval == 0) {
+            flushBits();
+            out.push_back(0xFF);
+            out.push_back((uint8_t)(0xD0 + (m / restartInterval - 1) % 8));
+            dcPred[0] = dcPred[1] = dcPred[2] = 0;
+        }
+        const int mx = m % mcusX, my = m / mcusX;
+        for (int y = 0; y < vs; ++y)
+            for (int x = 0; x < hs; ++x) encodeBlock(0, mx * mcuW + x * 8, my * mcuH + y * 8);
+        for (int c = 1; c < channels; ++c) encodeBlock(c, mx * 8, my * 8);
+    }
+    flushBits();
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return out;
+}
+
+}  // namespace jpeg_test
@@ -0,0 +1,226 @@
+#include "blob_labeler.h"
+
+#include <algorithm>
+#include <cstring>
+
+void BlobLabeler::reserve(int width, int height, int maxStrips)
+{
+    if (maxStrips < 1)
+        maxStrips = 1;
+    if ((int)strips_.size() < maxStrips)
+        strips_.resize(maxStrips);
+
+    // 经验值：掩码经过形态学处理后，每行的 run 数很少，这里按每行 4 个预留，不够时再自动扩容
+    const int rowsPerStrip = (height + maxStrips - 1) / maxStrips;
+    for (Strip &st : strips_)
+    {
+        st.runs.reserve((size_t)rowsPerStrip * 4);
+        st.rowStart.reserve(rowsPerStrip + 1);
+    }
+    runs_.reserve((size_t)height * 4);
+    label_.reserve((size_t)height * 4);
+    accum_.reserve(256);
+    blobs_.reserve(256);
+    (void)width;
+}
+
+int BlobLabeler::label(const uint8_t *mask, int width, int height, size_t step, int boxAreaThreshold)
+{
+    begin(mask, width, height, step, 1);
+    scanStrip(0);
+    return finish(boxAreaThreshold);
+}
+
+void BlobLabeler::begin(const uint8_t *mask, int width, int height, size_t step, int strips)
+{
+    mask_ = mask;
+    width_ = width;
+    height_ = height;
+    step_ = step;
+
+    if (strips < 1)
+        strips = 1;
+    if (strips > height)
+        strips = std::max(height, 1);
+    if ((int)strips_.size() < strips)
+        strips_.resize(strips);
+    activeStrips_ = strips;
+
+    // 均匀切分行
+    for (int s = 0; s < strips; ++s)
+    {
+        strips_[s].y0 = (int)((int64_t)height * s / strips);
+        strips_[s].y1 = (int)((int64_t)height * (s + 1) / strips);
+    }
+}
+
+int BlobLabeler::findRoot(Run *runs, int i)
+{
+    // 路径减半
+    while (runs[i].parent != i)
+    {
+        runs[i].parent = runs[runs[i].parent].parent;
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+void BlobLabeler::unite(Run *runs, int a, int b)
+{
+    a = findRoot(runs, a);
+    b = findRoot(runs, b);
+    if (a == b)
+        return;
+    // 总是让下标小的做根，保证根就是该连通域里最早出现的 run
+    if (a < b)
+        runs[b].parent = a;
+    else
+        runs[a].parent = b;
+}
+
+void BlobLabeler::scanStrip(int s)
+{
+    Strip &st = strips_[s];
+    st.runs.clear();
+    st.rowStart.clear();
+
+    const int w = width_;
+    for (int y = st.y0; y < st.y1; ++y)
+    {
+        const uint8_t *row = mask_ + (size_t)y * step_;
+        const int rowBegin = (int)st.runs.size();
+        st.rowStart.push_back(rowBegin);
+
+        // 1. 提取本行所有 run：一次跳过 8 个全零字节
+        int x = 0;
+        while (x < w)
+        {
+            while (x + 8 <= w)
+            {
+                uint64_t word;
+                std::memcpy(&word, row + x, 8);
+                if (word != 0)
+                    break;
+                x += 8;
+            }
+            while (x < w && row[x] == 0)
+                ++x;
+            if (x >= w)
+                break;
+
+            const int x0 = x;
+            while (x < w && row[x] != 0)
+                ++x;
+            const int idx = (int)st.runs.size();
+            st.runs.push_back({x0, x - 1, y, idx});
+        }
+
+        // 2. 与上一行 (同一条带内) 8 邻接的 run 合并
+        if (y == st.y0)
+            continue;
+        const int prevBegin = st.rowStart[y - st.y0 - 1];
+        const int prevEnd = rowBegin;
+        const int curEnd = (int)st.runs.size();
+        Run *runs = st.runs.data();
+
+        int j = prevBegin;
+        for (int i = rowBegin; i < curEnd; ++i)
+        {
+            while (j < prevEnd && runs[j].x1 < runs[i].x0 - 1)
+                ++j;
+            for (int k = j; k < prevEnd && runs[k].x0 <= runs[i].x1 + 1; ++k)
+                unite(runs, i, k);
+        }
+    }
+    st.rowStart.push_back((int)st.runs.size());
+}
+
+int BlobLabeler::finish(int boxAreaThreshold)
+{
+    // 1. 把各条带的 run 拼成一张全局表，父节点换算成全局下标
+    runs_.clear();
+    for (int s = 0; s < activeStrips_; ++s)
+    {
+        const Strip &st = strips_[s];
+        const int base = (int)runs_.size();
+        for (const Run &r : st.runs)
+            runs_.push_back({r.x0, r.x1, r.y, r.parent + base});
+    }
+
+    // 2. 合并相邻条带的边界行：上一条带最后一行 vs 下一条带第一行
+    Run *runs = runs_.data();
+    int base = 0;
+    for (int s = 0; s + 1 < activeStrips_; ++s)
+    {
+        const Strip &up = strips_[s];
+        const Strip &down = strips_[s + 1];
+        const int upRows = up.y1 - up.y0;
+        const int downBase = base + (int)up.runs.size();
+
+        if (upRows > 0 && down.y1 > down.y0)
+        {
+            const int prevBegin = base + up.rowStart[upRows - 1];
+            const int prevEnd = base + up.rowStart[upRows];
+            const int curBegin = downBase + down.rowStart[0];
+            const int curEnd = downBase + down.rowStart[1];
+
+            int j = prevBegin;
+            for (int i = curBegin; i < curEnd; ++i)
+            {
+                while (j < prevEnd && runs[j].x1 < runs[i].x0 - 1)
+                    ++j;
+                for (int k = j; k < prevEnd && runs[k].x0 <= runs[i].x1 + 1; ++k)
+                    unite(runs, i, k);
+            }
+        }
+        base = downBase;
+    }
+
+    // 3. 给每个根分配紧凑编号，并累加统计量
+    const int n = (int)runs_.size();
+    label_.resize(n);
+    accum_.clear();
+    for (int i = 0; i < n; ++i)
+    {
+        const Run &r = runs[i];
+        const int root = findRoot(runs, i);
+        if (root == i)
+        {
+            label_[i] = (int)accum_.size();
+            accum_.push_back({r.x0, r.x1, r.y, r.y, 0, 0, 0});
+        }
+        else
+        {
+            // 根的下标总是更小，此时编号一定已经分配
+            label_[i] = label_[root];
+        }
+
+        Accum &a = accum_[label_[i]];
+        const int len = r.x1 - r.x0 + 1;
+        a.minX = std::min(a.minX, r.x0);
+        a.maxX = std::max(a.maxX, r.x1);
+        a.minY = std::min(a.minY, r.y);
+        a.maxY = std::max(a.maxY, r.y);
+        a.area += len;
+        a.sumX += (int64_t)(r.x0 + r.x1) * len / 2;
+        a.sumY += (int64_t)r.y * len;
+    }
+
+    // 4. 面积过滤后直接写入输出数组
+    blobs_.clear();
+    for (const Accum &a : accum_)
+    {
+        Blob b;
+        b.x = a.minX;
+        b.y = a.minY;
+        b.width = a.maxX - a.minX + 1;
+        b.height = a.maxY - a.minY + 1;
+        if (b.width * b.height <= boxAreaThreshold)
+            continue;
+        b.area = a.area;
+        b.cx = (float)((double)a.sumX / a.area);
+        b.cy = (float)((double)a.sumY / a.area);
+        blobs_.push_back(b);
+    }
+    return (int)blobs_.size();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------------------------------
+// 连通域标记 (Connected Components Labeling)
+// --------------------------------------------------------------------------------
+// 基于"游程 (run) + 并查集"的单遍扫描：
+//   1. 每一行只提取连续的非零像素段 (run)，不记录轮廓点；
+//   2. 与上一行 8 邻接的 run 用并查集合并；
+//   3. 最后一次性累加外接框 / 面积 / 质心。
+// 图像可以按行切成若干条带 (strip)，每个条带独立扫描（可放到不同线程），
+// 最后在 finish() 里把相邻条带的边界行合并。
+// 所有缓冲区容量只增不减，稳态下每帧不再申请内存。
+// 不依赖 OpenCV，输入就是一块 8 位掩码内存 (mask.ptr(), mask.step)。
+
+// 单个连通域的统计结果
+struct Blob
+{
+    int x = 0, y = 0, width = 0, height = 0; // 外接矩形
+    int area = 0;                            // 像素个数
+    float cx = 0.f, cy = 0.f;                // 质心
+};
+
+class BlobLabeler
+{
+public:
+    // 按预期的最大帧尺寸预分配内存
+    void reserve(int width, int height, int maxStrips = 8);
+
+    // 串行版本：一次完成扫描和合并，返回保留下来的连通域个数
+    // boxAreaThreshold：外接矩形面积必须大于该值才会输出 (对应原来的 box.area() > 500)
+    int label(const uint8_t *mask, int width, int height, size_t step, int boxAreaThreshold);
+
+    // 并行版本：begin() -> 对每个条带调用 scanStrip() (各条带互不干扰，可并发) -> finish()
+    void begin(const uint8_t *mask, int width, int height, size_t step, int strips);
+    void scanStrip(int s);
+    int finish(int boxAreaThreshold);
+
+    int stripCount() const { return activeStrips_; }
+    int count() const { return (int)blobs_.size(); }
+    const Blob *blobs() const { return blobs_.data(); }
+    const Blob &operator[](int i) const { return blobs_[i]; }
+
+private:
+    struct Run
+    {
+        int x0, x1; // [x0, x1] 闭区间
+        int y;
+        int parent; // 并查集父节点 (条带内局部下标，finish 后为全局下标)
+    };
+
+    struct Strip
+    {
+        int y0 = 0, y1 = 0;
+        std::vector<Run> runs;
+        std::vector<int> rowStart; // rowStart[y - y0] = 该行第一个 run 的下标，末尾多一个哨兵
+    };
+
+    struct Accum
+    {
+        int minX, maxX, minY, maxY;
+        int area;
+        int64_t sumX, sumY;
+    };
+
+    static int findRoot(Run *runs, int i);
+    static void unite(Run *runs, int a, int b);
+
+    const uint8_t *mask_ = nullptr;
+    int width_ = 0, height_ = 0;
+    size_t step_ = 0;
+
+    std::vector<Strip> strips_; // 只增不减，当前帧只用前 activeStrips_ 个
+    int activeStrips_ = 0;
+    std::vector<Run> runs_;      // finish() 时各条带拼接后的全局 run 表
+    std::vector<int> label_;     // 根节点 -> 紧凑编号
+    std::vector<Accum> accum_;
+    std::vector<Blob> blobs_;
+};
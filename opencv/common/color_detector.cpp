@@ -0,0 +1,110 @@
+#include "color_detector.h"
+
+#include "hsv_lut.h"
+
+using namespace cv;
+using namespace std;
+
+static double elapsedMs(int64 start)
+{
+    return (double)(getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+ColorDetector::ColorDetector(const vector<ColorTarget> &targets, const DetectorParams &params)
+    : targets_(targets), params_(params), labelers_(targets.size()), lut_(new HsvLut(targets))
+{
+    kernel_ = getStructuringElement(MORPH_RECT, Size(params_.kernelSize, params_.kernelSize));
+}
+
+ColorDetector::ColorDetector(ColorDetector &&) noexcept = default;
+
+ColorDetector::~ColorDetector() = default;
+
+void ColorDetector::detect(const Mat &hsv, vector<Mat> &masks, vector<Detection> &detections, int strips,
+                           DetectorTimings *timings)
+{
+    detections.clear();
+    DetectorTimings local;
+
+    // 1. 颜色提取：查表一遍得到所有颜色的掩码 (结果和逐个颜色调用 inRange 相同)
+    int64 t0 = getTickCount();
+    lut_->apply(hsv, masks, strips > 1);
+    local.inRangeMs += elapsedMs(t0);
+
+    for (size_t t = 0; t < targets_.size(); t++)
+    {
+        Mat &mask = masks[t];
+        BlobLabeler &labeler = labelers_[t];
+
+        // 2. 形态学操作 (去噪 + 填坑)
+        t0 = getTickCount();
+        morphologyEx(mask, mask, MORPH_OPEN, kernel_);
+        morphologyEx(mask, mask, MORPH_CLOSE, kernel_);
+        local.morphologyMs += elapsedMs(t0);
+
+        // 3. 连通域标记 (每个条带至少 64 行，太碎了合并开销反而更大)
+        t0 = getTickCount();
+        labeler.begin(mask.ptr(), mask.cols, mask.rows, mask.step, min(strips, max(1, mask.rows / 64)));
+        if (labeler.stripCount() > 1)
+        {
+            parallel_for_(Range(0, labeler.stripCount()), [&](const Range &r)
+                          {
+                              for (int s = r.start; s < r.end; ++s)
+                                  labeler.scanStrip(s);
+                          });
+        }
+        else
+        {
+            labeler.scanStrip(0);
+        }
+        int n = labeler.finish(params_.boxAreaThreshold);
+        local.contoursMs += elapsedMs(t0);
+
+        for (int i = 0; i < n; i++)
+        {
+            const Blob &b = labeler[i];
+            Detection d;
+            d.target = (int)t;
+            d.box = Rect(b.x, b.y, b.width, b.height);
+            d.area = b.area;
+            d.centroid = Point2f(b.cx, b.cy);
+            detections.push_back(d);
+        }
+    }
+
+    if (timings)
+        *timings = local;
+}
+
+void mergeOverlappingRects(vector<Rect> &rects)
+{
+    // ROI 个数很少，O(n^2) 足够
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < rects.size() && !merged; i++)
+        {
+            for (size_t j = i + 1; j < rects.size(); j++)
+            {
+                if ((rects[i] & rects[j]).area() > 0)
+                {
+                    rects[i] |= rects[j];
+                    rects.erase(rects.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void drawDetections(Mat &img, const vector<ColorTarget> &targets, const vector<Detection> &detections)
+{
+    for (const Detection &d : detections)
+    {
+        const ColorTarget &t = targets[d.target];
+        rectangle(img, d.box, t.drawColor, 2);
+        putText(img, t.name, Point(d.box.x, d.box.y - 5), FONT_HERSHEY_SIMPLEX, 0.5, t.drawColor, 2);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blob_labeler.h"
+
+class HsvLut;
+
+// --------------------------------------------------------------------------------
+// 颜色检测器：inRange (查找表) -> 开/闭运算 -> 连通域标记
+// 只负责计算，不画图也不弹窗口，可以放在工作线程里跑
+// --------------------------------------------------------------------------------
+
+// 一种要识别的颜色
+struct ColorTarget
+{
+    std::string name;
+    cv::Scalar lower;     // HSV 下限
+    cv::Scalar upper;     // HSV 上限
+    cv::Scalar drawColor; // 画框用的 BGR 颜色
+};
+
+// 一个检测结果
+struct Detection
+{
+    int target = 0; // 对应 ColorTarget 的下标
+    cv::Rect box;
+    int area = 0;
+    cv::Point2f centroid;
+};
+
+struct DetectorParams
+{
+    int kernelSize = 5;         // 开/闭运算的矩形核大小
+    int boxAreaThreshold = 500; // 外接框面积必须大于该值
+};
+
+// 各阶段耗时 (毫秒，多种颜色累加)
+struct DetectorTimings
+{
+    double inRangeMs = 0;
+    double morphologyMs = 0;
+    double contoursMs = 0; // 连通域标记
+};
+
+class ColorDetector
+{
+public:
+    ColorDetector(const std::vector<ColorTarget> &targets, const DetectorParams &params);
+    ColorDetector(ColorDetector &&) noexcept;
+    ~ColorDetector();
+
+    // 对一帧 HSV 图像检测全部颜色
+    // masks 的大小会被调整为颜色个数，里面的 Mat 在帧之间复用
+    // strips > 1 时连通域标记按条带并行；timings 不为空时记录各阶段耗时
+    void detect(const cv::Mat &hsv, std::vector<cv::Mat> &masks, std::vector<Detection> &detections,
+                int strips = 1, DetectorTimings *timings = nullptr);
+
+    const std::vector<ColorTarget> &targets() const { return targets_; }
+    const DetectorParams &params() const { return params_; }
+
+private:
+    std::vector<ColorTarget> targets_;
+    DetectorParams params_;
+    cv::Mat kernel_;
+    std::vector<BlobLabeler> labelers_;
+    std::unique_ptr<HsvLut> lut_;
+};
+
+// 反复合并有重叠的矩形，直到两两不相交 (用于合并 ROI)
+void mergeOverlappingRects(std::vector<cv::Rect> &rects);
+
+// 在图像上画出检测框和颜色名字
+void drawDetections(cv::Mat &img, const std::vector<ColorTarget> &targets, const std::vector<Detection> &detections);
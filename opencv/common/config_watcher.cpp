@@ -0,0 +1,87 @@
+#include "config_watcher.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+ConfigWatcher::ConfigWatcher(const string &path, const DetectorConfig &base,
+                             function<void(const DetectorConfig &)> onChange, int intervalMs)
+    : path_(path), base_(base), onChange_(onChange), intervalMs_(intervalMs > 0 ? intervalMs : 500)
+{
+    thread_ = thread(&ConfigWatcher::loop, this);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    stop();
+}
+
+void ConfigWatcher::stop()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+ConfigWatcher::Stamp ConfigWatcher::stampOf(const string &path)
+{
+    Stamp s;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        s.exists = true;
+#if defined(__linux__)
+        // 秒级的修改时间区分不了一秒内的两次保存，Linux 上用纳秒
+        s.mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+        s.mtime = (long long)st.st_mtime;
+#endif
+        s.size = (long long)st.st_size;
+    }
+    return s;
+}
+
+void ConfigWatcher::loop()
+{
+    // 启动时的配置已经由调用者读过了，这里只关心之后的变化
+    Stamp applied = stampOf(path_);
+    Stamp pending = applied;
+
+    unique_lock<mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, chrono::milliseconds(intervalMs_), [this] { return stopped_; }))
+    {
+        Stamp now = stampOf(path_);
+        if (now == applied || !now.exists)
+        {
+            pending = now;
+            continue;
+        }
+        // 刚发现变化时先等一个周期，文件连续两次检查都没变再读，避免读到写了一半的文件
+        if (now != pending)
+        {
+            pending = now;
+            continue;
+        }
+
+        applied = now;
+        lock.unlock();
+        DetectorConfig config = base_;
+        string error;
+        if (loadDetectorConfig(path_, config, &error))
+        {
+            cerr << "配置文件已更新: " << path_ << "，颜色数: " << config.targets.size() << endl;
+            onChange_(config);
+        }
+        else
+        {
+            cerr << error << "，继续使用旧配置" << endl;
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "detector_config.h"
+
+// --------------------------------------------------------------------------------
+// 配置文件监视：后台线程定时检查文件的修改时间 / 大小，变了就重新读取，
+// 读取成功后在这个后台线程上调用 onChange (查找表、形态学核等都在这里建好，
+// 不占用处理视频的线程)。文件写到一半读失败时保留旧配置，等下次变化再试。
+// 启动时文件不存在也没关系，之后被创建 (比如 tuning 按 s 保存) 就会读进来。
+// 每次都合并进 base (程序的内置配置)，和启动时读配置文件的结果一致。
+// --------------------------------------------------------------------------------
+class ConfigWatcher
+{
+public:
+    ConfigWatcher(const std::string &path, const DetectorConfig &base,
+                  std::function<void(const DetectorConfig &)> onChange, int intervalMs = 500);
+    ~ConfigWatcher();
+
+    void stop();
+
+private:
+    // 用修改时间 + 大小判断文件有没有变，exists 为 false 表示文件不存在
+    struct Stamp
+    {
+        bool exists = false;
+        long long mtime = 0;
+        long long size = 0;
+        bool operator==(const Stamp &o) const { return exists == o.exists && mtime == o.mtime && size == o.size; }
+        bool operator!=(const Stamp &o) const { return !(*this == o); }
+    };
+
+    static Stamp stampOf(const std::string &path);
+    void loop();
+
+    std::string path_;
+    DetectorConfig base_;
+    std::function<void(const DetectorConfig &)> onChange_;
+    int intervalMs_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopped_ = false;
+    std::thread thread_;
+};
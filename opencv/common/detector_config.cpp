@@ -0,0 +1,152 @@
+#include "detector_config.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+static bool readTriple(const FileNode &node, Scalar &out)
+{
+    if (!node.isSeq() || node.size() != 3)
+        return false;
+    for (int i = 0; i < 3; i++)
+        out[i] = (double)node[i];
+    return true;
+}
+
+static void writeTriple(FileStorage &fs, const string &key, const Scalar &v)
+{
+    fs << key << "[:" << (int)v[0] << (int)v[1] << (int)v[2] << "]";
+}
+
+DetectorConfig defaultImageConfig()
+{
+    DetectorConfig cfg;
+    // ---------------------------------------------------------
+    // 🚩 tuning.cpp 调试出来的数值也可以直接填在这里
+    // ---------------------------------------------------------
+    // 黄色的 H 很容易和橙色/绿色混淆，需要仔细微调 H_min 和 H_max
+    // 窗口名 / 框旁边的文字分别为 "Blue Mask" 和 "Yellow Mask"
+    cfg.targets = {
+        {"Blue Mask", Scalar(100, 90, 0), Scalar(125, 255, 255), Scalar(255, 0, 0)},
+        {"Yellow Mask", Scalar(20, 135, 76), Scalar(42, 255, 255), Scalar(0, 255, 255)},
+    };
+    // 形态学操作（解决噪点问题）：稍微加大一点核的大小，7x7
+    // 面积过滤：如果噪点多，就把阈值改大
+    cfg.params.kernelSize = 7;
+    cfg.params.boxAreaThreshold = 500;
+    return cfg;
+}
+
+DetectorConfig defaultVideoConfig()
+{
+    DetectorConfig cfg;
+    cfg.targets = {
+        // --- 黄色 (Yellow) ---
+        {"Yellow", Scalar(20, 43, 46), Scalar(35, 255, 255), Scalar(0, 255, 255)},
+        // --- 红色 (Red) ---
+        {"Red", Scalar(170, 43, 46), Scalar(180, 255, 255), Scalar(0, 0, 255)},
+    };
+    // 形态学核 5x5，面积过滤阈值 500 (如果你的物体离得远，可能需要把 500 改小)
+    cfg.params.kernelSize = 5;
+    cfg.params.boxAreaThreshold = 500;
+    return cfg;
+}
+
+bool loadDetectorConfig(const string &path, DetectorConfig &cfg, string *error)
+{
+    string err;
+    DetectorConfig loaded = cfg;
+    try
+    {
+        FileStorage fs(path, FileStorage::READ);
+        if (!fs.isOpened())
+        {
+            err = "无法打开配置文件 " + path;
+        }
+        else
+        {
+            if (!fs["kernel_size"].empty())
+                loaded.params.kernelSize = (int)fs["kernel_size"];
+            if (!fs["box_area_threshold"].empty())
+                loaded.params.boxAreaThreshold = (int)fs["box_area_threshold"];
+
+            FileNode colors = fs["colors"];
+            if (!colors.isSeq())
+                err = "配置文件里没有 colors 列表";
+            for (FileNodeIterator it = colors.begin(); err.empty() && it != colors.end(); ++it)
+            {
+                FileNode c = *it;
+                ColorTarget t;
+                t.name = (string)c["name"];
+                if (t.name.empty() || !readTriple(c["lower"], t.lower) || !readTriple(c["upper"], t.upper))
+                {
+                    err = "颜色条目缺少 name / lower / upper";
+                    break;
+                }
+                const int existing = findTarget(loaded, t.name);
+                if (!readTriple(c["draw"], t.drawColor))
+                    t.drawColor = existing >= 0 ? loaded.targets[existing].drawColor : Scalar(0, 255, 0);
+                if (existing >= 0)
+                    loaded.targets[existing] = t;
+                else
+                    loaded.targets.push_back(t);
+            }
+
+            if (err.empty() && (loaded.params.kernelSize < 1 || loaded.targets.size() > 32))
+                err = "kernel_size 必须 >= 1，颜色最多 32 种";
+        }
+    }
+    catch (const cv::Exception &e)
+    {
+        err = "配置文件格式错误: " + string(e.what());
+    }
+
+    if (!err.empty())
+    {
+        if (error)
+            *error = err;
+        return false;
+    }
+    cfg = loaded;
+    return true;
+}
+
+bool saveDetectorConfig(const string &path, const DetectorConfig &cfg)
+{
+    try
+    {
+        FileStorage fs(path, FileStorage::WRITE);
+        if (!fs.isOpened())
+            return false;
+
+        fs << "kernel_size" << cfg.params.kernelSize;
+        fs << "box_area_threshold" << cfg.params.boxAreaThreshold;
+        fs << "colors" << "[";
+        for (const ColorTarget &t : cfg.targets)
+        {
+            fs << "{:";
+            fs << "name" << t.name;
+            writeTriple(fs, "lower", t.lower);
+            writeTriple(fs, "upper", t.upper);
+            writeTriple(fs, "draw", t.drawColor);
+            fs << "}";
+        }
+        fs << "]";
+        return true;
+    }
+    catch (const cv::Exception &)
+    {
+        return false;
+    }
+}
+
+int findTarget(const DetectorConfig &cfg, const string &name)
+{
+    for (size_t i = 0; i < cfg.targets.size(); i++)
+    {
+        if (cfg.targets[i].name == name)
+            return (int)i;
+    }
+    return -1;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "color_detector.h"
+
+// --------------------------------------------------------------------------------
+// 检测器配置文件 (OpenCV FileStorage 格式，YAML 或 JSON 由扩展名决定)
+// tuning 调好的范围直接写进这个文件，task2 / task4 启动时读取，不用再改源码重新编译。
+//
+//   %YAML:1.0
+//   kernel_size: 5
+//   box_area_threshold: 500
+//   colors:
+//      - { name: Yellow, lower: [ 20, 43, 46 ], upper: [ 35, 255, 255 ], draw: [ 0, 255, 255 ] }
+//      - { name: Red, lower: [ 170, 43, 46 ], upper: [ 180, 255, 255 ], draw: [ 0, 0, 255 ] }
+// --------------------------------------------------------------------------------
+struct DetectorConfig
+{
+    std::vector<ColorTarget> targets;
+    DetectorParams params;
+};
+
+// 程序内置的默认配置 (没有配置文件时用，也是读配置文件时的底子)
+// task2 (静态图片)：蓝色 / 黄色，7x7 核；task4 (视频)：黄色 / 红色，5x5 核
+DetectorConfig defaultImageConfig();
+DetectorConfig defaultVideoConfig();
+
+// 把配置文件合并进 cfg：文件里的颜色按名字替换 cfg 里的同名颜色，新名字追加在后面；
+// 文件里写了的参数覆盖 cfg 的，没写的保持原值。cfg 传内置默认值，只调过一种颜色的文件不会把其他颜色弄丢
+// 读取失败 (文件不存在 / 格式错误) 时返回 false，error 里是原因，cfg 保持不变
+bool loadDetectorConfig(const std::string &path, DetectorConfig &cfg, std::string *error = nullptr);
+
+bool saveDetectorConfig(const std::string &path, const DetectorConfig &cfg);
+
+// 按名字查找颜色，找不到返回 -1
+int findTarget(const DetectorConfig &cfg, const std::string &name);
@@ -0,0 +1,103 @@
+#include "hsv_lut.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+// 和 inRange 一样：边界先四舍五入再截断到 [0, 255]
+static int toByte(double v)
+{
+    return min(255, max(0, cvRound(v)));
+}
+
+HsvLut::HsvLut()
+{
+    build(vector<ColorTarget>());
+}
+
+void HsvLut::build(const vector<ColorTarget> &targets)
+{
+    CV_Assert((int)targets.size() <= kMaxClasses);
+    classes_ = (int)targets.size();
+
+    fill(h_, h_ + 256, 0u);
+    fill(s_, s_ + 256, 0u);
+    fill(v_, v_ + 256, 0u);
+
+    uint32_t *tables[3] = {h_, s_, v_};
+    for (int c = 0; c < classes_; c++)
+    {
+        const uint32_t bit = 1u << c;
+        for (int ch = 0; ch < 3; ch++)
+        {
+            const int lo = toByte(targets[c].lower[ch]);
+            const int hi = toByte(targets[c].upper[ch]);
+            for (int v = lo; v <= hi; v++)
+                tables[ch][v] |= bit;
+        }
+    }
+}
+
+void HsvLut::applyRows(const Mat &hsv, vector<Mat> &masks, int y0, int y1) const
+{
+    const int n = classes_;
+    uchar *dst[kMaxClasses];
+
+    for (int y = y0; y < y1; y++)
+    {
+        const uchar *p = hsv.ptr<uchar>(y);
+        for (int c = 0; c < n; c++)
+            dst[c] = masks[c].ptr<uchar>(y);
+
+        if (n == 1)
+        {
+            // 最常见的单色情况单独展开
+            uchar *d = dst[0];
+            for (int x = 0; x < hsv.cols; x++, p += 3)
+                d[x] = (uchar)(0u - (h_[p[0]] & s_[p[1]] & v_[p[2]]));
+            continue;
+        }
+
+        for (int x = 0; x < hsv.cols; x++, p += 3)
+        {
+            const uint32_t bits = h_[p[0]] & s_[p[1]] & v_[p[2]];
+            for (int c = 0; c < n; c++)
+                dst[c][x] = (uchar)(0u - ((bits >> c) & 1u));
+        }
+    }
+}
+
+void HsvLut::apply(const Mat &hsv, vector<Mat> &masks, bool parallel) const
+{
+    CV_Assert(hsv.type() == CV_8UC3);
+    masks.resize(classes_);
+    for (Mat &m : masks)
+        m.create(hsv.rows, hsv.cols, CV_8UC1);
+
+    if (parallel && hsv.rows >= 64)
+    {
+        parallel_for_(Range(0, hsv.rows), [&](const Range &r) { applyRows(hsv, masks, r.start, r.end); });
+    }
+    else
+    {
+        applyRows(hsv, masks, 0, hsv.rows);
+    }
+}
+
+void HsvLut::applyOne(const Mat &hsv, int cls, Mat &mask) const
+{
+    CV_Assert(hsv.type() == CV_8UC3 && cls >= 0 && cls < classes_);
+    mask.create(hsv.rows, hsv.cols, CV_8UC1);
+
+    parallel_for_(Range(0, hsv.rows), [&](const Range &r)
+                  {
+                      for (int y = r.start; y < r.end; y++)
+                      {
+                          const uchar *p = hsv.ptr<uchar>(y);
+                          uchar *d = mask.ptr<uchar>(y);
+                          for (int x = 0; x < hsv.cols; x++, p += 3)
+                              d[x] = (uchar)(0u - (((h_[p[0]] & s_[p[1]] & v_[p[2]]) >> cls) & 1u));
+                      }
+                  });
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "color_detector.h"
+
+// --------------------------------------------------------------------------------
+// 基于查找表的 inRange
+// 每个通道一张 256 项的表，第 c 位为 1 表示这个值落在第 c 种颜色的范围内。
+// 一个像素属于哪些颜色 = H 表 & S 表 & V 表，三次查表 + 两次与运算，
+// 一遍扫描就能同时得到所有颜色 (最多 32 种) 的掩码，结果和 inRange 完全一致。
+// 表只在范围变化时重建 (768 项，微秒级)，可以在别的线程建好再换上来。
+// --------------------------------------------------------------------------------
+class HsvLut
+{
+public:
+    static const int kMaxClasses = 32;
+
+    HsvLut();
+    explicit HsvLut(const std::vector<ColorTarget> &targets) { build(targets); }
+
+    void build(const std::vector<ColorTarget> &targets);
+    int classes() const { return classes_; }
+
+    // 一次遍历生成所有颜色的掩码 (0 / 255)，parallel 为真时按行并行
+    void apply(const cv::Mat &hsv, std::vector<cv::Mat> &masks, bool parallel = true) const;
+
+    // 只生成第 cls 种颜色的掩码
+    void applyOne(const cv::Mat &hsv, int cls, cv::Mat &mask) const;
+
+private:
+    void applyRows(const cv::Mat &hsv, std::vector<cv::Mat> &masks, int y0, int y1) const;
+
+    uint32_t h_[256];
+    uint32_t s_[256];
+    uint32_t v_[256];
+    int classes_ = 0;
+};
@@ -0,0 +1,154 @@
+#include "incremental_detector.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+static double elapsedMs(int64 start)
+{
+    return (double)(getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+static Rect expandRect(const Rect &r, int margin, const Rect &bounds)
+{
+    return Rect(r.x - margin, r.y - margin, r.width + 2 * margin, r.height + 2 * margin) & bounds;
+}
+
+IncrementalDetector::IncrementalDetector(const vector<ColorTarget> &targets, const DetectorParams &params,
+                                         const IncrementalParams &incremental)
+    : detector_(targets, params), params_(incremental)
+{
+    params_.fullScanInterval = max(1, params_.fullScanInterval);
+    params_.motionScale = max(1, params_.motionScale);
+}
+
+void IncrementalDetector::updateMotion(const Mat &bgr)
+{
+    motionBoxes_.clear();
+
+    // 缩小用最近邻 (只是隔点取样)，再转灰度，整个过程只碰 1/scale^2 的像素
+    const double f = 1.0 / params_.motionScale;
+    resize(bgr, small_, Size(), f, f, INTER_NEAREST);
+    cvtColor(small_, gray_, COLOR_BGR2GRAY);
+
+    if (prevGray_.size() == gray_.size())
+    {
+        absdiff(gray_, prevGray_, diff_);
+        threshold(diff_, diff_, params_.motionThreshold, 255, THRESH_BINARY);
+
+        int n = motionLabeler_.label(diff_.ptr(), diff_.cols, diff_.rows, diff_.step, params_.motionBoxArea);
+        const int s = params_.motionScale;
+        for (int i = 0; i < n; i++)
+        {
+            const Blob &b = motionLabeler_[i];
+            motionBoxes_.push_back(Rect(b.x * s, b.y * s, b.width * s, b.height * s));
+        }
+    }
+    swap(prevGray_, gray_);
+}
+
+void IncrementalDetector::detect(const Mat &bgr, Mat &hsv, vector<Mat> &masks, vector<Detection> &detections,
+                                 int strips, DetectorTimings *timings, IncrementalResult *result)
+{
+    const Rect frameRect(0, 0, bgr.cols, bgr.rows);
+    IncrementalResult res;
+    DetectorTimings total;
+
+    int64 t0 = getTickCount();
+    updateMotion(bgr);
+    res.motionMs = elapsedMs(t0);
+
+    bool full = rescan_ || bgr.size() != lastSize_ || frameIndex_ % params_.fullScanInterval == 0;
+
+    if (!full)
+    {
+        rois_.clear();
+        for (const Rect &r : prevBoxes_)
+            rois_.push_back(expandRect(r, params_.roiMargin, frameRect));
+        for (const Rect &r : motionBoxes_)
+            rois_.push_back(expandRect(r, params_.roiMargin, frameRect));
+        rois_.erase(remove_if(rois_.begin(), rois_.end(), [](const Rect &r) { return r.area() <= 0; }), rois_.end());
+        mergeOverlappingRects(rois_);
+
+        double area = 0;
+        for (const Rect &r : rois_)
+            area += r.area();
+        res.coverage = area / frameRect.area();
+        if (res.coverage > params_.maxCoverage)
+            full = true;
+    }
+
+    bool lost = false;
+    if (full)
+    {
+        t0 = getTickCount();
+        cvtColor(bgr, hsv, COLOR_BGR2HSV);
+        res.hsvMs = elapsedMs(t0);
+        detector_.detect(hsv, masks, detections, strips, &total);
+        res.coverage = 1.0;
+    }
+    else
+    {
+        const size_t colors = detector_.targets().size();
+        masks.resize(colors);
+        for (Mat &m : masks)
+        {
+            m.create(bgr.size(), CV_8UC1);
+            m.setTo(Scalar(0));
+        }
+        detections.clear();
+
+        for (const Rect &roi : rois_)
+        {
+            t0 = getTickCount();
+            cvtColor(bgr(roi), roiHsv_, COLOR_BGR2HSV);
+            res.hsvMs += elapsedMs(t0);
+
+            DetectorTimings t;
+            detector_.detect(roiHsv_, roiMasks_, roiDetections_, strips, &t);
+            total.inRangeMs += t.inRangeMs;
+            total.morphologyMs += t.morphologyMs;
+            total.contoursMs += t.contoursMs;
+
+            for (Detection d : roiDetections_)
+            {
+                // 检测框贴着 ROI 内侧的边 (且不是画面边缘)：目标可能有一部分在 ROI 外面
+                const Rect &b = d.box;
+                if ((b.x == 0 && roi.x > 0) || (b.y == 0 && roi.y > 0) ||
+                    (b.x + b.width == roi.width && roi.x + roi.width < frameRect.width) ||
+                    (b.y + b.height == roi.height && roi.y + roi.height < frameRect.height))
+                    lost = true;
+
+                d.box.x += roi.x;
+                d.box.y += roi.y;
+                d.centroid.x += roi.x;
+                d.centroid.y += roi.y;
+                detections.push_back(d);
+            }
+            for (size_t c = 0; c < colors; c++)
+            {
+                Mat dst = masks[c](roi);
+                roiMasks_[c].copyTo(dst);
+            }
+        }
+        res.rois = (int)rois_.size();
+
+        // 目标变少了：可能是跑出了 ROI，下一帧全图找一遍
+        if (detections.size() < prevBoxes_.size())
+            lost = true;
+    }
+
+    prevBoxes_.clear();
+    for (const Detection &d : detections)
+        prevBoxes_.push_back(d.box);
+    rescan_ = lost;
+    lastSize_ = bgr.size();
+    frameIndex_++;
+
+    res.fullScan = full;
+    if (timings)
+        *timings = total;
+    if (result)
+        *result = res;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "blob_labeler.h"
+#include "color_detector.h"
+
+// --------------------------------------------------------------------------------
+// 增量检测 (适合固定机位的视频)
+// 大部分画面是静止的，目标只占一小块运动区域，所以不必每帧都处理整张图：
+//   1. 上一帧的检测框向外扩 roiMargin 个像素；
+//   2. 在 1/motionScale 分辨率的灰度图上做帧差，得到运动区域；
+//   3. 两者合并成若干个互不重叠的 ROI，只在 ROI 里做 HSV / inRange / 形态学 / 连通域。
+// 以下情况退回全图扫描：每 fullScanInterval 帧一次、第一帧、
+// 检测框碰到了 ROI 的边 (目标可能跑出去了)、检测数量变少 (跟丢了)、ROI 面积太大。
+// 依赖前一帧的结果，所以必须按帧序串行调用。
+// --------------------------------------------------------------------------------
+
+struct IncrementalParams
+{
+    int fullScanInterval = 30;  // 每隔多少帧强制全图扫描一次
+    int roiMargin = 32;         // 检测框 / 运动区域向外扩的像素
+    int motionScale = 4;        // 帧差在 1/4 分辨率上做
+    int motionThreshold = 25;   // 灰度差超过该值认为是运动
+    int motionBoxArea = 4;      // 运动区域 (缩小后) 外接框面积阈值，滤掉零星噪点
+    double maxCoverage = 0.5;   // ROI 总面积超过整帧的这个比例时，直接全图扫描更划算
+};
+
+// 本帧的处理情况
+struct IncrementalResult
+{
+    bool fullScan = true;
+    double coverage = 1.0; // 实际处理的像素占整帧的比例
+    int rois = 0;
+    double hsvMs = 0;
+    double motionMs = 0;
+};
+
+class IncrementalDetector
+{
+public:
+    IncrementalDetector(const std::vector<ColorTarget> &targets, const DetectorParams &params,
+                        const IncrementalParams &incremental);
+
+    // 输入 BGR 帧。hsv 只在全图扫描时完整有效；masks 总是整帧大小 (ROI 以外为 0)
+    void detect(const cv::Mat &bgr, cv::Mat &hsv, std::vector<cv::Mat> &masks, std::vector<Detection> &detections,
+                int strips, DetectorTimings *timings, IncrementalResult *result);
+
+private:
+    void updateMotion(const cv::Mat &bgr);
+
+    ColorDetector detector_;
+    IncrementalParams params_;
+
+    int64_t frameIndex_ = 0;
+    bool rescan_ = true;
+    cv::Size lastSize_;
+    std::vector<cv::Rect> prevBoxes_;
+
+    // 帧差
+    cv::Mat small_, gray_, prevGray_, diff_;
+    BlobLabeler motionLabeler_;
+    std::vector<cv::Rect> motionBoxes_;
+
+    // ROI 处理时复用的缓冲区
+    std::vector<cv::Rect> rois_;
+    cv::Mat roiHsv_;
+    std::vector<cv::Mat> roiMasks_;
+    std::vector<Detection> roiDetections_;
+};
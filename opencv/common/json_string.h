@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+// --------------------------------------------------------------------------------
+// 写 JSON 用的字符串：加上两边的引号，转义 " \ 和控制字符
+// 流名就是命令行给的路径，类别名来自配置文件，里面什么字符都可能有；非 ASCII 的 UTF-8 字节原样输出
+// --------------------------------------------------------------------------------
+inline std::string jsonString(const std::string &s)
+{
+    std::string out;
+    out.reserve(s.size() + 2);
+    out += '"';
+    for (const char ch : s)
+    {
+        const unsigned char c = (unsigned char)ch;
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (c < 0x20)
+            {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            }
+            else
+                out += ch;
+        }
+    }
+    out += '"';
+    return out;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// --------------------------------------------------------------------------------
+// 延迟直方图 (单位：微秒记录，毫秒读出)
+// 小于 32us 的值逐个计数；更大的值按 2 的幂分段，每段再均分 32 个桶，
+// 相对误差不超过 1/32 (约 3%)，内存固定，记录只是一次加法，不需要保存所有样本。
+// 不是线程安全的：每个线程各记各的，最后用 merge() 合并。
+// --------------------------------------------------------------------------------
+class LatencyHistogram
+{
+public:
+    void record(double ms)
+    {
+        uint64_t us = ms > 0 ? (uint64_t)(ms * 1000.0 + 0.5) : 0;
+        counts_[bucketOf(us)]++;
+        count_++;
+        sumUs_ += us;
+        maxUs_ = std::max(maxUs_, us);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (int i = 0; i < kBuckets; i++)
+            counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sumUs_ += other.sumUs_;
+        maxUs_ = std::max(maxUs_, other.maxUs_);
+    }
+
+    // p 取 0~100，返回该分位数所在桶的上界 (不超过实际最大值)
+    double percentile(double p) const
+    {
+        if (count_ == 0)
+            return 0.0;
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)count_ + 0.5);
+        rank = std::min(std::max<uint64_t>(rank, 1), count_);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+                return (double)std::min(bucketUpper(i), maxUs_) / 1000.0;
+        }
+        return (double)maxUs_ / 1000.0;
+    }
+
+    uint64_t count() const { return count_; }
+    double mean() const { return count_ ? (double)sumUs_ / (double)count_ / 1000.0 : 0.0; }
+    double max() const { return (double)maxUs_ / 1000.0; }
+
+private:
+    static constexpr int kSubBits = 5;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMaxExp = 40; // 2^40 us，足够了
+    static constexpr int kBuckets = kSub + (kMaxExp - kSubBits + 1) * kSub;
+
+    static int highestBit(uint64_t v)
+    {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        int e = 0;
+        while (v >>= 1)
+            e++;
+        return e;
+#endif
+    }
+
+    static int bucketOf(uint64_t us)
+    {
+        if (us < (uint64_t)kSub)
+            return (int)us;
+        int e = highestBit(us);
+        if (e > kMaxExp)
+            return kBuckets - 1;
+        int sub = (int)((us >> (e - kSubBits)) & (kSub - 1));
+        return kSub + (e - kSubBits) * kSub + sub;
+    }
+
+    static uint64_t bucketUpper(int b)
+    {
+        if (b < kSub)
+            return (uint64_t)b;
+        int e = (b - kSub) / kSub + kSubBits;
+        int sub = (b - kSub) % kSub;
+        uint64_t width = 1ull << (e - kSubBits);
+        return (uint64_t)(kSub + sub) * width + width - 1;
+    }
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sumUs_ = 0;
+    uint64_t maxUs_ = 0;
+};
@@ -0,0 +1,331 @@
+#include "output_sink.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define OUTPUT_SINK_POSIX 1
+#endif
+
+using namespace cv;
+using namespace std;
+
+// 写线程一次最多攒多少帧再写
+static const size_t kMaxBatchFrames = 64;
+
+DetectionSink::DetectionSink(size_t queueFrames) : queue_(queueFrames)
+{
+}
+
+DetectionSink::~DetectionSink()
+{
+    close();
+}
+
+bool DetectionSink::open(const string &target, string *error)
+{
+    close();
+    string err;
+#ifdef OUTPUT_SINK_POSIX
+    if (target.compare(0, 5, "unix:") == 0)
+    {
+        const string path = target.substr(5);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        {
+            err = "Unix socket 路径无效: " + path;
+        }
+        else
+        {
+            memcpy(addr.sun_path, path.c_str(), path.size());
+            fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd_ < 0)
+                err = "无法创建 Unix socket: " + string(strerror(errno));
+            else if (connect(fd_, (const sockaddr *)&addr, sizeof(addr)) != 0)
+            {
+                err = "无法连接 " + path + ": " + strerror(errno);
+                ::close(fd_);
+                fd_ = -1;
+            }
+            socket_ = true;
+        }
+    }
+    else
+    {
+        fd_ = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+            err = "无法写入 " + target + ": " + strerror(errno);
+        socket_ = false;
+    }
+#else
+    err = "检测结果输出只支持 Unix 平台";
+#endif
+    if (fd_ < 0)
+    {
+        if (error)
+            *error = err;
+        return false;
+    }
+
+    if (!socket_)
+        writeAll("# frame,class,x,y,w,h,area\n");
+    written_ = 0;
+    dropped_ = 0;
+    queue_.reopen();
+    thread_ = thread(&DetectionSink::writerLoop, this);
+    return true;
+}
+
+bool DetectionSink::push(int64_t frame, const vector<ColorTarget> &targets, const vector<Detection> &detections)
+{
+    if (fd_ < 0 || detections.empty())
+        return fd_ >= 0;
+    Batch batch;
+    batch.frame = frame;
+    batch.records.reserve(detections.size());
+    for (const Detection &d : detections)
+    {
+        Record r;
+        r.cls = targets[d.target].name;
+        r.box = d.box;
+        r.area = d.area;
+        batch.records.push_back(move(r));
+    }
+    if (!queue_.tryPush(move(batch)))
+    {
+        ++dropped_;
+        return false;
+    }
+    return true;
+}
+
+void DetectionSink::writerLoop()
+{
+    string text;
+    Batch batch;
+    bool failed = false;
+    while (queue_.pop(batch))
+    {
+        // 一次把队列里已经有的都取出来，拼成一块再写
+        text.clear();
+        size_t frames = 0;
+        int64_t boxes = 0;
+        do
+        {
+            char line[160];
+            for (const Record &r : batch.records)
+            {
+                int n = snprintf(line, sizeof(line), "%lld,%s,%d,%d,%d,%d,%d\n", (long long)batch.frame,
+                                 r.cls.c_str(), r.box.x, r.box.y, r.box.width, r.box.height, r.area);
+                text.append(line, (size_t)min(n, (int)sizeof(line) - 1));
+            }
+            boxes += (int64_t)batch.records.size();
+            ++frames;
+        } while (frames < kMaxBatchFrames && queue_.tryPop(batch));
+
+        // 写失败 (磁盘满 / 对方断开) 之后的结果都丢掉，不影响检测
+        if (!failed && writeAll(text))
+            written_ += boxes;
+        else
+        {
+            failed = true;
+            dropped_ += (int64_t)frames;
+        }
+    }
+}
+
+bool DetectionSink::writeAll(const string &data)
+{
+#ifdef OUTPUT_SINK_POSIX
+    const char *p = data.data();
+    size_t left = data.size();
+    while (left > 0)
+    {
+        // socket 用 MSG_NOSIGNAL：对方断开时返回 EPIPE，而不是整个进程收到 SIGPIPE
+        ssize_t n = socket_ ? send(fd_, p, left, MSG_NOSIGNAL) : write(fd_, p, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= (size_t)n;
+    }
+    return true;
+#else
+    (void)data;
+    return false;
+#endif
+}
+
+void DetectionSink::close()
+{
+    queue_.close();
+    if (thread_.joinable())
+        thread_.join();
+#ifdef OUTPUT_SINK_POSIX
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+    fd_ = -1;
+}
+
+FrameEncoder::FrameEncoder(int queueFrames)
+    : frames_(max(1, queueFrames)), free_(frames_.size()), queue_(frames_.size())
+{
+}
+
+FrameEncoder::~FrameEncoder()
+{
+    close();
+}
+
+static bool endsWith(const string &s, const string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// 拆帧号格式：最多一个 %d / %Nd / %0Nd，%% 是字面的 %，其他 % 用法一律拒绝
+// (路径不能直接当 printf 格式串用：%s、%n、两个 %d 都是未定义行为)
+static bool parseFramePattern(const string &target, bool *numbered, string *prefix, string *suffix, int *width,
+                              bool *zeroPad, string *error)
+{
+    *numbered = false;
+    prefix->clear();
+    suffix->clear();
+    *width = 0;
+    *zeroPad = false;
+    for (size_t i = 0; i < target.size(); ++i)
+    {
+        string &out = *numbered ? *suffix : *prefix;
+        if (target[i] != '%')
+        {
+            out += target[i];
+            continue;
+        }
+        if (i + 1 < target.size() && target[i + 1] == '%')
+        {
+            out += '%';
+            ++i;
+            continue;
+        }
+        size_t j = i + 1;
+        const bool pad = j < target.size() && target[j] == '0';
+        if (pad)
+            ++j;
+        int w = 0;
+        while (j < target.size() && isdigit((unsigned char)target[j]) && w < 100)
+            w = w * 10 + (target[j++] - '0');
+        if (j >= target.size() || target[j] != 'd' || w >= 100 || *numbered)
+        {
+            if (error)
+                *error = "输出路径里的 % 格式无效 (只支持一个 %d / %06d，字面的 % 写成 %%): " + target;
+            return false;
+        }
+        *numbered = true;
+        *width = w;
+        *zeroPad = pad;
+        i = j;
+    }
+    return true;
+}
+
+bool FrameEncoder::open(const string &target, double fps, string *error)
+{
+    close();
+    if (target.empty())
+    {
+        if (error)
+            *error = "没有指定输出文件";
+        return false;
+    }
+    if (!parseFramePattern(target, &numbered_, &prefix_, &suffix_, &width_, &zeroPad_, error))
+        return false;
+    target_ = target;
+    fps_ = fps > 0 ? fps : 30.0;
+    sequence_ = numbered_ || endsWith(target, ".jpg") || endsWith(target, ".jpeg") || endsWith(target, ".png");
+    encoded_ = 0;
+    dropped_ = 0;
+
+    free_.reopen();
+    queue_.reopen();
+    for (Frame &f : frames_)
+        free_.push(&f);
+    thread_ = thread(&FrameEncoder::encoderLoop, this);
+    return true;
+}
+
+bool FrameEncoder::push(const Mat &frame, int64_t frameId)
+{
+    Frame *buf = nullptr;
+    if (!thread_.joinable() || !free_.tryPop(buf))
+    {
+        ++dropped_;
+        return false;
+    }
+    frame.copyTo(buf->image);
+    buf->id = frameId;
+    queue_.push(buf); // 空闲缓冲和队列一样大，拿到空闲缓冲就一定放得进去
+    return true;
+}
+
+string FrameEncoder::sequencePath(int64_t frameId) const
+{
+    if (!numbered_)
+        return prefix_;
+    string number = to_string(frameId);
+    if ((int)number.size() < width_)
+        number.insert(frameId < 0 && zeroPad_ ? 1 : 0, width_ - number.size(), zeroPad_ ? '0' : ' ');
+    return prefix_ + number + suffix_;
+}
+
+void FrameEncoder::encoderLoop()
+{
+    VideoWriter writer;
+    bool failed = false;
+    Frame *buf = nullptr;
+    while (queue_.pop(buf))
+    {
+        bool ok = false;
+        if (sequence_)
+        {
+            // 带格式的按帧号编文件名，不带的每帧覆盖同一个文件 (相当于最新一帧的快照)
+            ok = imwrite(sequencePath(buf->id), buf->image);
+        }
+        else if (!failed)
+        {
+            if (!writer.isOpened())
+            {
+                const int fourcc = endsWith(target_, ".avi") ? VideoWriter::fourcc('M', 'J', 'P', 'G')
+                                                              : VideoWriter::fourcc('m', 'p', '4', 'v');
+                failed = !writer.open(target_, fourcc, fps_, buf->image.size(), buf->image.channels() == 3);
+            }
+            if (writer.isOpened())
+            {
+                writer.write(buf->image);
+                ok = true;
+            }
+        }
+        if (ok)
+            ++encoded_;
+        else
+            ++dropped_;
+        free_.push(buf);
+    }
+    writer.release();
+}
+
+void FrameEncoder::close()
+{
+    queue_.close();
+    if (thread_.joinable())
+        thread_.join();
+    free_.close();
+}
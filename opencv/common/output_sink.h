@@ -0,0 +1,116 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "color_detector.h"
+#include "ring_buffer.h"
+
+// --------------------------------------------------------------------------------
+// 异步输出：检测结果和画好框的帧交给后台线程写出去，调用方只做一次入队，永远不会被磁盘 / 网络卡住
+//
+//   输出阶段 --push (tryPush，满了就丢)--> 有界队列 --> 写线程 (按批写文件 / Unix socket)
+//   输出阶段 --push (拷进空闲帧，没有就丢)--> 有界队列 --> 编码线程 (VideoWriter / JPEG 序列)
+//
+// 队列满 (写得比检测慢) 时丢掉新来的，计入 dropped()，检测照常进行。
+// --------------------------------------------------------------------------------
+
+// 检测结果输出：每个框一行 "帧号,类别,x,y,w,h,面积"，攒一批再写 (一次系统调用写很多行)
+// 目标是文件路径，或者 "unix:/路径" 连接到一个 Unix 域 socket (SOCK_STREAM，对方 nc -lU 就能收)
+class DetectionSink
+{
+public:
+    explicit DetectionSink(size_t queueFrames = 256);
+    ~DetectionSink();
+    DetectionSink(const DetectionSink &) = delete;
+    DetectionSink &operator=(const DetectionSink &) = delete;
+
+    bool open(const std::string &target, std::string *error = nullptr);
+
+    // 把一帧的检测结果交给写线程；队列满了就丢掉这一帧的结果，返回 false
+    bool push(int64_t frame, const std::vector<ColorTarget> &targets, const std::vector<Detection> &detections);
+
+    // 写完队列里剩下的再关闭
+    void close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    int64_t written() const { return written_; } // 写出去的框数
+    int64_t dropped() const { return dropped_; } // 队列满 / 写失败丢掉的帧数
+
+private:
+    struct Record
+    {
+        std::string cls;
+        cv::Rect box;
+        int area = 0;
+    };
+    struct Batch
+    {
+        int64_t frame = 0;
+        std::vector<Record> records;
+    };
+
+    void writerLoop();
+    bool writeAll(const std::string &data);
+
+    int fd_ = -1;
+    bool socket_ = false;
+    RingBuffer<Batch> queue_;
+    std::thread thread_;
+    std::atomic<int64_t> written_{0};
+    std::atomic<int64_t> dropped_{0};
+};
+
+// 带框的帧编码：目标以 .jpg / .png 结尾、或者带帧号格式 (如 frames/%06d.jpg) 时写成图片序列，
+// 否则写成视频文件 (按扩展名选编码：.avi 用 MJPG，其他用 mp4v)
+// 帧号格式只认恰好一个 %d / %Nd / %0Nd，字面的 % 写成 %%；文件名用的是 push 传进来的帧号，
+// 丢帧 / 写失败不会让后面的文件名错位，和检测结果里的帧号对得上
+// 帧在固定个数的缓冲之间循环 (和流水线的槽位一样)，拷贝复用内存，不会每帧分配
+class FrameEncoder
+{
+public:
+    explicit FrameEncoder(int queueFrames = 8);
+    ~FrameEncoder();
+    FrameEncoder(const FrameEncoder &) = delete;
+    FrameEncoder &operator=(const FrameEncoder &) = delete;
+
+    // fps 只对视频文件有用；视频在收到第一帧时按它的尺寸打开
+    bool open(const std::string &target, double fps, std::string *error = nullptr);
+
+    // 拷一份交给编码线程；没有空闲缓冲 (编码跟不上) 就丢掉这一帧，返回 false
+    bool push(const cv::Mat &frame, int64_t frameId);
+
+    void close();
+
+    bool isOpen() const { return thread_.joinable(); }
+    int64_t encoded() const { return encoded_; }
+    int64_t dropped() const { return dropped_; }
+
+private:
+    struct Frame
+    {
+        cv::Mat image;
+        int64_t id = 0;
+    };
+
+    void encoderLoop();
+    std::string sequencePath(int64_t frameId) const;
+
+    std::string target_;
+    bool sequence_ = false;
+    // 帧号格式拆成 前缀 + 帧号 + 后缀 (open 时检查一次)，没有格式时 numbered_ = false
+    bool numbered_ = false;
+    std::string prefix_, suffix_;
+    int width_ = 0;
+    bool zeroPad_ = false;
+    double fps_ = 30.0;
+    std::vector<Frame> frames_;
+    RingBuffer<Frame *> free_;
+    RingBuffer<Frame *> queue_;
+    std::thread thread_;
+    std::atomic<int64_t> encoded_{0};
+    std::atomic<int64_t> dropped_{0};
+};
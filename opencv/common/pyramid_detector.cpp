@@ -0,0 +1,144 @@
+#include "pyramid_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+static double elapsedMs(int64 start)
+{
+    return (double)(getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+// 粗检测用的参数：核和面积阈值按比例缩小
+static DetectorParams coarseParams(const DetectorParams &params, int scale)
+{
+    DetectorParams p = params;
+    // 核保持奇数，最小为 1 (此时开/闭运算相当于不做)
+    int k = (int)std::lround((double)params.kernelSize / scale);
+    p.kernelSize = max(1, k | 1);
+    // 面积按 scale^2 缩小，再放宽一倍：被粗检测放过的候选会在精修时用原阈值重新过滤
+    p.boxAreaThreshold = params.boxAreaThreshold / (scale * scale) / 2;
+    return p;
+}
+
+PyramidDetector::PyramidDetector(const vector<ColorTarget> &targets, const DetectorParams &params, int scale)
+    : scale_(max(1, scale)), margin_(2 * max(1, scale) + params.kernelSize),
+      coarse_(targets, coarseParams(params, max(1, scale))), full_(targets, params)
+{
+    for (const ColorTarget &t : targets)
+        fine_.emplace_back(vector<ColorTarget>{t}, params);
+}
+
+void PyramidDetector::detect(const Mat &bgr, vector<Mat> &masks, vector<Detection> &detections, int strips,
+                             DetectorTimings *timings, double *hsvMs)
+{
+    const Rect frameRect(0, 0, bgr.cols, bgr.rows);
+    DetectorTimings total, t;
+    double hsv = 0;
+
+    // 帧比缩小倍数还小，缩小后的尺寸是 0 (resize 会断言失败)：直接在原图上检测
+    int64 t0 = getTickCount();
+    if (bgr.cols / scale_ == 0 || bgr.rows / scale_ == 0)
+    {
+        cvtColor(bgr, roiHsv_, COLOR_BGR2HSV);
+        if (hsvMs)
+            *hsvMs = elapsedMs(t0);
+        full_.detect(roiHsv_, masks, detections, strips, timings);
+        return;
+    }
+
+    // 1. 粗检测
+    resize(bgr, small_, Size(bgr.cols / scale_, bgr.rows / scale_), 0, 0, INTER_AREA);
+    cvtColor(small_, smallHsv_, COLOR_BGR2HSV);
+    hsv += elapsedMs(t0);
+
+    coarse_.detect(smallHsv_, masks, coarseDetections_, strips, &total);
+
+    // 2. 按颜色分别精修：同一颜色的候选区域先合并，避免重复检测
+    // 缩小时宽高被截断了，换算回原图时用实际比例
+    const double sx = (double)bgr.cols / small_.cols;
+    const double sy = (double)bgr.rows / small_.rows;
+    detections.clear();
+    for (size_t c = 0; c < fine_.size(); c++)
+    {
+        rois_.clear();
+        for (const Detection &d : coarseDetections_)
+        {
+            if (d.target != (int)c)
+                continue;
+            int x0 = (int)floor(d.box.x * sx) - margin_;
+            int y0 = (int)floor(d.box.y * sy) - margin_;
+            int x1 = (int)ceil((d.box.x + d.box.width) * sx) + margin_;
+            int y1 = (int)ceil((d.box.y + d.box.height) * sy) + margin_;
+            Rect roi = Rect(x0, y0, x1 - x0, y1 - y0) & frameRect;
+            if (roi.area() > 0)
+                rois_.push_back(roi);
+        }
+        mergeOverlappingRects(rois_);
+
+        for (const Rect &roi : rois_)
+        {
+            t0 = getTickCount();
+            cvtColor(bgr(roi), roiHsv_, COLOR_BGR2HSV);
+            hsv += elapsedMs(t0);
+
+            fine_[c].detect(roiHsv_, roiMasks_, roiDetections_, strips, &t);
+            total.inRangeMs += t.inRangeMs;
+            total.morphologyMs += t.morphologyMs;
+            total.contoursMs += t.contoursMs;
+
+            for (Detection d : roiDetections_)
+            {
+                d.target = (int)c;
+                d.box.x += roi.x;
+                d.box.y += roi.y;
+                d.centroid.x += roi.x;
+                d.centroid.y += roi.y;
+                detections.push_back(d);
+            }
+        }
+    }
+
+    if (timings)
+        *timings = total;
+    if (hsvMs)
+        *hsvMs = hsv;
+}
+
+DetectionDiff compareDetections(const vector<Detection> &a, const vector<Detection> &b)
+{
+    DetectionDiff diff;
+    vector<bool> used(b.size(), false);
+    for (const Detection &d : a)
+    {
+        const Point2f ca(d.box.x + d.box.width * 0.5f, d.box.y + d.box.height * 0.5f);
+        int best = -1;
+        double bestDist = 0;
+        for (size_t i = 0; i < b.size(); i++)
+        {
+            if (used[i] || b[i].target != d.target)
+                continue;
+            const Point2f cb(b[i].box.x + b[i].box.width * 0.5f, b[i].box.y + b[i].box.height * 0.5f);
+            const double dist = hypot(ca.x - cb.x, ca.y - cb.y);
+            if (best < 0 || dist < bestDist)
+            {
+                best = (int)i;
+                bestDist = dist;
+            }
+        }
+        if (best < 0)
+        {
+            diff.unmatched++;
+            continue;
+        }
+        used[best] = true;
+        const Rect &e = b[best].box;
+        const int delta = max({abs(d.box.x - e.x), abs(d.box.y - e.y), abs(d.box.br().x - e.br().x),
+                               abs(d.box.br().y - e.br().y)});
+        diff.maxBoxDelta = max(diff.maxBoxDelta, delta);
+    }
+    diff.unmatched += (int)count(used.begin(), used.end(), false);
+    return diff;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "color_detector.h"
+
+// --------------------------------------------------------------------------------
+// 由粗到细的检测 (适合目标比较大的场景)
+//   1. 粗检测：BGR 先缩小到 1/scale (INTER_AREA，整数倍缩小走 OpenCV 的快速路径)，
+//      再转 HSV、inRange、形态学、连通域，像素量只有原来的 1/scale^2；
+//      核大小和面积阈值按比例自动缩小 (阈值再放宽一倍，宁可多给候选)；
+//   2. 精修：把每个候选框放大回原图坐标并外扩一圈，只在这些区域里用原始参数
+//      在全分辨率下再检测一次，得到的框和全图检测一致 (前提是粗检测没有漏掉目标)。
+// 帧比 scale 还小 (缩小后宽或高为 0) 时直接在原图上做一次普通检测。
+// 和全图检测差多少可以用 compareDetections 核对 (task2 --compare)。
+// --------------------------------------------------------------------------------
+class PyramidDetector
+{
+public:
+    // scale 取 2 或 4
+    PyramidDetector(const std::vector<ColorTarget> &targets, const DetectorParams &params, int scale);
+
+    // masks 输出的是粗检测 (缩小后) 的掩码 (退回全图检测时是原图大小)；hsvMs 记录缩小 + 转 HSV 的总耗时
+    void detect(const cv::Mat &bgr, std::vector<cv::Mat> &masks, std::vector<Detection> &detections, int strips,
+                DetectorTimings *timings, double *hsvMs);
+
+    int scale() const { return scale_; }
+
+private:
+    int scale_;
+    int margin_; // 精修区域外扩的像素
+    ColorDetector coarse_;
+    std::vector<ColorDetector> fine_; // 每种颜色一个，只检测这一种颜色
+    ColorDetector full_;              // 帧太小、缩不下去时用的全图检测
+
+    cv::Mat small_, smallHsv_, roiHsv_;
+    std::vector<Detection> coarseDetections_, roiDetections_;
+    std::vector<cv::Mat> roiMasks_;
+    std::vector<cv::Rect> rois_;
+};
+
+// 两组检测结果的差别：同一颜色内按框中心就近配对，maxBoxDelta 是配上的框四条边的最大偏差 (像素)，
+// unmatched 是两边配不上的框数之和
+struct DetectionDiff
+{
+    int maxBoxDelta = 0;
+    int unmatched = 0;
+};
+
+DetectionDiff compareDetections(const std::vector<Detection> &a, const std::vector<Detection> &b);
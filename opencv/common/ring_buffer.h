@@ -0,0 +1,100 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------------------------------
+// 有界环形队列：容量固定，满了 push 阻塞，空了 pop 阻塞
+// close() 之后不再接受新元素，但队列里剩下的元素仍然可以被 pop 出来
+// 用来在流水线的各个阶段之间传递帧槽位指针
+// --------------------------------------------------------------------------------
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(size_t capacity) : buf_(capacity > 0 ? capacity : 1) {}
+
+    bool push(T value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return closed_ || count_ < buf_.size(); });
+        if (closed_)
+            return false;
+        buf_[(head_ + count_) % buf_.size()] = std::move(value);
+        ++count_;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool tryPush(T value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || count_ == buf_.size())
+            return false;
+        buf_[(head_ + count_) % buf_.size()] = std::move(value);
+        ++count_;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return closed_ || count_ > 0; });
+        if (count_ == 0)
+            return false;
+        value = std::move(buf_[head_]);
+        head_ = (head_ + 1) % buf_.size();
+        --count_;
+        notFull_.notify_one();
+        return true;
+    }
+
+    bool tryPop(T &value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0)
+            return false;
+        value = std::move(buf_[head_]);
+        head_ = (head_ + 1) % buf_.size();
+        --count_;
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    // 清空并重新接受元素 (关闭之后再次使用)
+    void reopen()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = false;
+        head_ = 0;
+        count_ = 0;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    size_t capacity() const { return buf_.size(); }
+
+private:
+    std::vector<T> buf_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
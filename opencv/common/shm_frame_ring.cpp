@@ -0,0 +1,517 @@
+#include "shm_frame_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+const uint32_t kMagic = 0x46524D53; // "SMRF"
+const uint32_t kVersion = 2;
+const int kMaxReaders = 16;
+const int kMaxSlots = 64; // 读者持有的槽位用一个 64 位掩码记
+const uint64_t kWriting = ~uint64_t(0);
+const size_t kPage = 4096;
+
+// 放进共享内存的原子变量必须是无锁的，否则各进程各用各的锁
+static_assert(atomic<uint64_t>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free");
+
+size_t roundUp(size_t n, size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+}
+
+struct ShmReader
+{
+    atomic<uint32_t> pid;       // 0 表示这一项空闲
+    atomic<uint32_t> lossless;  // 无损读者：生产者覆盖帧之前要等它
+    atomic<uint64_t> nextSeq;   // 无损读者下一帧要读的 seq
+    atomic<uint64_t> heldSlots; // 手上持有的槽位 (第 i 位 = i 号槽位)，生产者据此判断槽位能不能覆盖
+};
+
+struct ShmSlot
+{
+    atomic<uint64_t> seq; // 槽位里是第几帧，kWriting 表示正在写
+    ShmFrameInfo info;
+};
+
+struct ShmRingHeader
+{
+    atomic<uint32_t> magic; // 最后写，消费者看到它才认为环已经建好
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t producerPid;
+    uint64_t slotBytes;  // 每个槽位数据区的大小 (按页对齐)
+    uint64_t dataOffset; // 第一个槽位数据区相对映射起点的偏移
+    double fps;
+
+    atomic<uint64_t> published;       // 已发布的帧数
+    atomic<uint32_t> frameWord;       // 每发布一帧 +1，消费者在上面 futex 等
+    atomic<uint32_t> spaceWord;       // 消费者释放 / 前进时 +1，生产者在上面等
+    atomic<uint32_t> producerWaiting; // 生产者正在等空槽位，消费者才需要唤醒它
+    atomic<uint32_t> closed;
+
+    ShmReader readers[kMaxReaders];
+    ShmSlot slots[kMaxSlots];
+
+    uint8_t *slotData(int slot) { return reinterpret_cast<uint8_t *>(this) + dataOffset + slot * slotBytes; }
+};
+
+#if defined(__linux__)
+
+namespace
+{
+// 映射是 MAP_SHARED 的，futex 不能用 PRIVATE 版本
+int futexWait(atomic<uint32_t> &word, uint32_t expected, int timeoutMs)
+{
+    timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+    return (int)syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected,
+                        timeoutMs < 0 ? nullptr : &ts, nullptr, 0);
+}
+
+void futexWakeAll(atomic<uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool processAlive(uint32_t pid)
+{
+    if (pid == 0 || (kill((pid_t)pid, 0) != 0 && errno == ESRCH))
+        return false;
+    // 已经退出但还没被父进程回收的僵尸进程 kill 也能成功，要看 /proc 里的状态
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return true;
+    char buf[256] = {};
+    const size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    const char *paren = strrchr(buf, ')'); // 进程名里可能有空格，状态在最后一个 ')' 后面
+    return !(n > 0 && paren && paren[1] == ' ' && paren[2] == 'Z');
+}
+
+string shmName(const string &name)
+{
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+// 消费者读完 / 释放之后调用：只有生产者在等的时候才做系统调用
+void notifySpace(ShmRingHeader *h)
+{
+    h->spaceWord.fetch_add(1, memory_order_seq_cst);
+    if (h->producerWaiting.load(memory_order_seq_cst))
+        futexWakeAll(h->spaceWord);
+}
+}
+
+// ---------------------------------- 生产者 ----------------------------------
+
+ShmFrameProducer::~ShmFrameProducer()
+{
+    close();
+}
+
+bool ShmFrameProducer::create(const string &name, int slotCount, size_t slotBytes, double fps, string *error)
+{
+    close();
+    if (slotCount < 2 || slotCount > kMaxSlots || slotBytes == 0)
+    {
+        if (error)
+            *error = "槽位个数必须在 2 到 " + to_string(kMaxSlots) + " 之间";
+        return false;
+    }
+    name_ = shmName(name);
+    shm_unlink(name_.c_str()); // 上次异常退出留下的同名环
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        if (error)
+            *error = "shm_open " + name_ + " 失败: " + strerror(errno);
+        return false;
+    }
+    const size_t dataOffset = roundUp(sizeof(ShmRingHeader), kPage);
+    const size_t slotStride = roundUp(slotBytes, kPage);
+    mapBytes_ = dataOffset + slotStride * slotCount;
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, (off_t)mapBytes_) == 0)
+        p = mmap(nullptr, mapBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        if (error)
+            *error = "映射共享内存失败: " + string(strerror(errno));
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    // ftruncate 出来的内存全是 0，原子变量的初值正好是 0
+    header_ = new (p) ShmRingHeader;
+    header_->version = kVersion;
+    header_->slotCount = (uint32_t)slotCount;
+    header_->producerPid = (uint32_t)getpid();
+    header_->slotBytes = slotStride;
+    header_->dataOffset = dataOffset;
+    header_->fps = fps;
+    for (int i = 0; i < kMaxSlots; i++)
+        header_->slots[i].seq.store(kWriting, memory_order_relaxed);
+    header_->magic.store(kMagic, memory_order_release);
+    nextSeq_ = 0;
+    return true;
+}
+
+size_t ShmFrameProducer::slotBytes() const
+{
+    return header_ ? (size_t)header_->slotBytes : 0;
+}
+
+bool ShmFrameProducer::readersCaughtUp(uint64_t seq) const
+{
+    // 第 seq 帧会盖掉第 seq - N 帧，所有无损读者都得已经读过它
+    const uint64_t n = header_->slotCount;
+    if (seq < n)
+        return true;
+    for (const ShmReader &r : header_->readers)
+    {
+        if (r.pid.load(memory_order_seq_cst) != 0 && r.lossless.load(memory_order_seq_cst) &&
+            r.nextSeq.load(memory_order_seq_cst) <= seq - n)
+            return false;
+    }
+    return true;
+}
+
+bool ShmFrameProducer::slotHeld(int slot) const
+{
+    // 空闲的读者项掩码一定是 0 (close / 回收时先清掩码再让出 pid)，不用看 pid
+    const uint64_t bit = uint64_t(1) << slot;
+    for (const ShmReader &r : header_->readers)
+    {
+        if (r.heldSlots.load(memory_order_seq_cst) & bit)
+            return true;
+    }
+    return false;
+}
+
+void ShmFrameProducer::waitForSpace(uint32_t seen, int &waitedMs)
+{
+    const int kStepMs = 100;
+    futexWait(header_->spaceWord, seen, kStepMs);
+    waitedMs += kStepMs;
+    // 等了一秒还没动静，看看是不是有消费者进程已经没了
+    if (waitedMs >= 1000)
+    {
+        reapDeadReaders();
+        waitedMs = 0;
+    }
+}
+
+uint8_t *ShmFrameProducer::beginFrame()
+{
+    if (!header_)
+        return nullptr;
+    const uint64_t seq = nextSeq_;
+    const int slot = (int)(seq % header_->slotCount);
+    ShmSlot &s = header_->slots[slot];
+    int waitedMs = 0;
+
+    header_->producerWaiting.store(1, memory_order_seq_cst);
+    // 1) 无损读者还没读到这个槽位里的旧帧
+    for (;;)
+    {
+        const uint32_t seen = header_->spaceWord.load(memory_order_seq_cst);
+        if (readersCaughtUp(seq))
+            break;
+        waitForSpace(seen, waitedMs);
+    }
+    // 2) 先标成正在写 (新来的消费者就拿不到它了)，再等手上还拿着旧帧的消费者放手
+    s.seq.store(kWriting, memory_order_seq_cst);
+    for (;;)
+    {
+        const uint32_t seen = header_->spaceWord.load(memory_order_seq_cst);
+        if (!slotHeld(slot))
+            break;
+        waitForSpace(seen, waitedMs);
+    }
+    header_->producerWaiting.store(0, memory_order_relaxed);
+    return header_->slotData(slot);
+}
+
+void ShmFrameProducer::commitFrame(const ShmFrameInfo &info)
+{
+    if (!header_)
+        return;
+    const uint64_t seq = nextSeq_++;
+    ShmSlot &s = header_->slots[seq % header_->slotCount];
+    s.info = info;
+    s.info.seq = seq;
+    s.seq.store(seq, memory_order_release);
+    header_->published.store(seq + 1, memory_order_release);
+    header_->frameWord.fetch_add(1, memory_order_release);
+    futexWakeAll(header_->frameWord);
+}
+
+void ShmFrameProducer::reapDeadReaders()
+{
+    for (ShmReader &r : header_->readers)
+    {
+        const uint32_t pid = r.pid.load(memory_order_seq_cst);
+        if (pid == 0 || processAlive(pid))
+            continue;
+        r.heldSlots.store(0, memory_order_seq_cst);
+        r.lossless.store(0, memory_order_seq_cst);
+        r.pid.store(0, memory_order_seq_cst);
+    }
+}
+
+void ShmFrameProducer::close()
+{
+    if (!header_)
+        return;
+    header_->closed.store(1, memory_order_seq_cst);
+    header_->frameWord.fetch_add(1, memory_order_seq_cst);
+    futexWakeAll(header_->frameWord);
+    munmap(header_, mapBytes_);
+    shm_unlink(name_.c_str());
+    header_ = nullptr;
+}
+
+// ---------------------------------- 消费者 ----------------------------------
+
+ShmFrameConsumer::~ShmFrameConsumer()
+{
+    close();
+}
+
+bool ShmFrameConsumer::open(const string &name, Mode mode, string *error)
+{
+    close();
+    const string path = shmName(name);
+    const int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        if (error)
+            *error = "打不开共享内存 " + path + " (生产者还没启动？): " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmRingHeader))
+    {
+        mapBytes_ = (size_t)st.st_size;
+        p = mmap(nullptr, mapBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        if (error)
+            *error = "映射共享内存 " + path + " 失败";
+        return false;
+    }
+    header_ = static_cast<ShmRingHeader *>(p);
+    if (header_->magic.load(memory_order_acquire) != kMagic || header_->version != kVersion)
+    {
+        if (error)
+            *error = path + " 不是帧环，或者生产者还没初始化完";
+        close();
+        return false;
+    }
+
+    // 在读者表里占一项
+    const uint32_t pid = (uint32_t)getpid();
+    for (int i = 0; i < kMaxReaders && reader_ < 0; i++)
+    {
+        uint32_t expected = 0;
+        if (header_->readers[i].pid.compare_exchange_strong(expected, pid, memory_order_seq_cst))
+            reader_ = i;
+    }
+    if (reader_ < 0)
+    {
+        if (error)
+            *error = "读者已满 (最多 " + to_string(kMaxReaders) + " 个)";
+        close();
+        return false;
+    }
+    ShmReader &r = header_->readers[reader_];
+    mode_ = mode;
+    started_ = false;
+    skipped_ = 0;
+    r.heldSlots.store(0, memory_order_seq_cst);
+    // 无损读者从当前时刻开始读，不回头读已经发布的旧帧。
+    // 先用进度 0 (生产者见了会等) 登记成无损读者，之后才去看 published：
+    // 反过来的话，登记之前生产者不等它，可能已经把 published 那一帧所在的槽位又盖了一轮
+    r.nextSeq.store(0, memory_order_seq_cst);
+    r.lossless.store(mode == Mode::Lossless ? 1 : 0, memory_order_seq_cst);
+    r.nextSeq.store(header_->published.load(memory_order_seq_cst), memory_order_seq_cst);
+    return true;
+}
+
+bool ShmFrameConsumer::tryTake(uint64_t seq, ShmFrameView &view)
+{
+    const int slot = (int)(seq % header_->slotCount);
+    ShmSlot &s = header_->slots[slot];
+    ShmReader &r = header_->readers[reader_];
+    // 先在掩码里置位再检查帧号；生产者那边是先标记正在写再看掩码，两边总有一边能看到对方
+    r.heldSlots.fetch_or(uint64_t(1) << slot, memory_order_seq_cst);
+    if (s.seq.load(memory_order_seq_cst) != seq)
+    {
+        r.heldSlots.fetch_and(~(uint64_t(1) << slot), memory_order_seq_cst);
+        notifySpace(header_);
+        return false;
+    }
+    view.info = s.info;
+    view.data = header_->slotData(slot);
+    view.slot = slot;
+    return true;
+}
+
+bool ShmFrameConsumer::acquire(ShmFrameView &view, int timeoutMs)
+{
+    if (!header_)
+        return false;
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    ShmReader &r = header_->readers[reader_];
+    for (;;)
+    {
+        const uint32_t seen = header_->frameWord.load(memory_order_acquire);
+        const uint64_t published = header_->published.load(memory_order_acquire);
+        if (mode_ == Mode::Lossless)
+        {
+            const uint64_t want = r.nextSeq.load(memory_order_relaxed);
+            if (want < published && tryTake(want, view))
+                return true;
+            // 已经发布过的帧却拿不到：槽位里已经是更新的帧 (或正在写更新的帧)，这一帧不会再出现了。
+            // 正常情况下生产者会等无损读者，不会走到这里 (读者被当成崩溃回收之类)；
+            // 跳到环里最旧的还没被盖的帧，记进 skipped，不在这一帧上死等
+            const uint64_t n = header_->slotCount;
+            const uint64_t inSlot = header_->slots[want % n].seq.load(memory_order_seq_cst);
+            if (want < published && (inSlot == kWriting || inSlot > want))
+            {
+                const uint64_t next = max(want + 1, published > n ? published - n + 1 : 0);
+                skipped_ += next - want;
+                r.nextSeq.store(next, memory_order_seq_cst);
+                notifySpace(header_);
+                continue;
+            }
+        }
+        else if (published > 0 && (!started_ || published - 1 > lastSeq_))
+        {
+            const uint64_t want = published - 1;
+            if (tryTake(want, view))
+            {
+                if (started_)
+                    skipped_ += want - lastSeq_ - 1;
+                started_ = true;
+                lastSeq_ = want;
+                return true;
+            }
+            continue; // 刚好被生产者盖掉了，再取一次最新的
+        }
+
+        if (producerGone())
+            return false;
+        int waitMs = 200; // 分段等，顺便检查生产者进程还在不在
+        if (timeoutMs >= 0)
+        {
+            const auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            if (left.count() <= 0)
+                return false;
+            waitMs = min(waitMs, (int)left.count());
+        }
+        futexWait(header_->frameWord, seen, waitMs);
+    }
+}
+
+void ShmFrameConsumer::release(ShmFrameView &view)
+{
+    if (!header_ || view.slot < 0)
+        return;
+    ShmReader &r = header_->readers[reader_];
+    r.heldSlots.fetch_and(~(uint64_t(1) << view.slot), memory_order_seq_cst);
+    if (mode_ == Mode::Lossless)
+        r.nextSeq.store(view.info.seq + 1, memory_order_seq_cst);
+    notifySpace(header_);
+    view.slot = -1;
+    view.data = nullptr;
+}
+
+bool ShmFrameConsumer::producerGone() const
+{
+    return !header_ || header_->closed.load(memory_order_acquire) || !processAlive(header_->producerPid);
+}
+
+double ShmFrameConsumer::fps() const
+{
+    return header_ ? header_->fps : 0.0;
+}
+
+void ShmFrameConsumer::close()
+{
+    if (!header_)
+        return;
+    if (reader_ >= 0)
+    {
+        // 没 release 的槽位一并还掉，再让出读者表里的这一项
+        ShmReader &r = header_->readers[reader_];
+        r.heldSlots.store(0, memory_order_seq_cst);
+        r.lossless.store(0, memory_order_seq_cst);
+        r.pid.store(0, memory_order_seq_cst);
+        notifySpace(header_);
+        reader_ = -1;
+    }
+    munmap(header_, mapBytes_);
+    header_ = nullptr;
+}
+
+#else // !__linux__
+
+ShmFrameProducer::~ShmFrameProducer() {}
+
+bool ShmFrameProducer::create(const string &, int, size_t, double, string *error)
+{
+    if (error)
+        *error = "共享内存帧环只支持 Linux";
+    return false;
+}
+
+uint8_t *ShmFrameProducer::beginFrame() { return nullptr; }
+void ShmFrameProducer::commitFrame(const ShmFrameInfo &) {}
+size_t ShmFrameProducer::slotBytes() const { return 0; }
+void ShmFrameProducer::close() {}
+
+ShmFrameConsumer::~ShmFrameConsumer() {}
+
+bool ShmFrameConsumer::open(const string &, Mode, string *error)
+{
+    if (error)
+        *error = "共享内存帧环只支持 Linux";
+    return false;
+}
+
+bool ShmFrameConsumer::acquire(ShmFrameView &, int) { return false; }
+void ShmFrameConsumer::release(ShmFrameView &) {}
+bool ShmFrameConsumer::producerGone() const { return true; }
+double ShmFrameConsumer::fps() const { return 0.0; }
+void ShmFrameConsumer::close() {}
+
+#endif
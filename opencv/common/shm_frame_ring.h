@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// --------------------------------------------------------------------------------
+// 共享内存帧环：一个生产者进程解码一次，多个本机消费者进程直接读共享内存里的帧
+//
+//   生产者 ──beginFrame/commitFrame──> [槽位 0][槽位 1]...[槽位 N-1] ──acquire/release──> 消费者 × M
+//
+// - 第 seq 帧固定放在 seq % N 号槽位；每个消费者用一个位掩码记自己手上拿着哪些槽位
+//   (acquire 置位、release 清位)，这是"槽位有没有人在读"的唯一依据。生产者要覆盖一个槽位前
+//   先把它标成"正在写"，再等所有读者的掩码里都没有这一位，所以读到一半的帧不会被改掉
+// - 两种读法：
+//     Latest   (最新帧)：每次拿当前最新的一帧，处理慢就跳帧，不会拖慢生产者 (适合检测)
+//     Lossless (无损)  ：按顺序一帧不漏，生产者在覆盖它还没读的帧之前会等它 (适合录像)
+// - 新帧通知用 futex：生产者发布后唤醒所有等新帧的消费者；消费者释放槽位 / 读完后，
+//   只有生产者在等空槽位时才唤醒它，平时不多做系统调用
+// - 消费者进程崩溃留下的槽位掩码 / 无损进度，由生产者在等待超时后按 pid 检查并清掉
+//   (只有掩码一份记录，崩在哪一步都不会出现计数对不上、生产者永远等下去的情况)
+// - 只支持 Linux (POSIX shm + futex)，其他平台 create / open 返回 false
+// 不依赖 OpenCV，帧的格式 (宽高 / cv::Mat 的 type / 行字节数) 放在每帧的 ShmFrameInfo 里
+// --------------------------------------------------------------------------------
+
+struct ShmFrameInfo
+{
+    uint64_t seq = 0;       // 生产者发布的第几帧，从 0 开始 (由 commitFrame 填)
+    int64_t frameIndex = 0; // 源里的帧号 (文件循环播放时会回到 0)
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t type = 0;       // cv::Mat::type()
+    uint32_t step = 0;      // 每行字节数
+    int64_t captureNs = 0;  // 生产者开始读这一帧的时间 (CLOCK_MONOTONIC，同一台机器上各进程可比)
+};
+
+// 消费者拿到的一帧：data 直接指向共享内存，release 之前一直有效，不能修改
+struct ShmFrameView
+{
+    ShmFrameInfo info;
+    const uint8_t *data = nullptr;
+    int slot = -1;
+};
+
+struct ShmRingHeader;
+
+class ShmFrameProducer
+{
+public:
+    ShmFrameProducer() = default;
+    ~ShmFrameProducer();
+    ShmFrameProducer(const ShmFrameProducer &) = delete;
+    ShmFrameProducer &operator=(const ShmFrameProducer &) = delete;
+
+    // 创建 (同名的旧环会被删掉重建)，slotBytes 是一帧最多占的字节数
+    bool create(const std::string &name, int slotCount, size_t slotBytes, double fps, std::string *error = nullptr);
+
+    // 等到下一个槽位可以覆盖，返回它的数据区 (可以直接解码到这里)；环已关闭返回 nullptr
+    uint8_t *beginFrame();
+    // 发布 beginFrame 拿到的那一帧，唤醒等新帧的消费者
+    void commitFrame(const ShmFrameInfo &info);
+
+    size_t slotBytes() const;
+    uint64_t published() const { return nextSeq_; }
+
+    // 通知消费者结束，删除共享内存的名字 (已经映射的消费者还能读完手上的帧)
+    void close();
+
+private:
+    bool readersCaughtUp(uint64_t seq) const;
+    bool slotHeld(int slot) const;
+    void waitForSpace(uint32_t seen, int &waitedMs);
+    void reapDeadReaders();
+
+    std::string name_;
+    ShmRingHeader *header_ = nullptr;
+    size_t mapBytes_ = 0;
+    uint64_t nextSeq_ = 0;
+};
+
+class ShmFrameConsumer
+{
+public:
+    enum class Mode
+    {
+        Latest,
+        Lossless,
+    };
+
+    ShmFrameConsumer() = default;
+    ~ShmFrameConsumer();
+    ShmFrameConsumer(const ShmFrameConsumer &) = delete;
+    ShmFrameConsumer &operator=(const ShmFrameConsumer &) = delete;
+
+    // 连接到生产者建好的环；读者个数有上限 (16)，满了返回 false
+    bool open(const std::string &name, Mode mode, std::string *error = nullptr);
+
+    // 取下一帧：最新模式取最新的一帧，无损模式取按顺序的下一帧
+    // timeoutMs < 0 一直等；超时、或生产者已结束且没有可读的帧时返回 false
+    bool acquire(ShmFrameView &view, int timeoutMs = -1);
+    void release(ShmFrameView &view);
+
+    // 生产者已经 close 或者进程已经不在了
+    bool producerGone() const;
+    double fps() const;
+    uint64_t skipped() const { return skipped_; } // 没读到就被新帧盖过的帧数 (无损模式正常为 0)
+
+    void close();
+
+private:
+    bool tryTake(uint64_t seq, ShmFrameView &view);
+
+    ShmRingHeader *header_ = nullptr;
+    size_t mapBytes_ = 0;
+    int reader_ = -1;
+    Mode mode_ = Mode::Latest;
+    bool started_ = false;
+    uint64_t lastSeq_ = 0;
+    uint64_t skipped_ = 0;
+};
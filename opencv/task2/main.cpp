@@ -1,81 +1,126 @@
 #include <opencv2/opencv.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "color_detector.h"
+#include "detector_config.h"
+#include "output_sink.h"
+#include "pyramid_detector.h"
+
 using namespace cv;
 using namespace std;
 
-// 改进后的函数：增加了 maskWindowName 参数，用于分别显示不同颜色的Mask
-void processColor(Mat hsv_img, Scalar lower, Scalar upper, Mat &display_img, Scalar draw_color, string maskWindowName)
+// 用法：./task2 [--pyramid 2|4 [--compare]] [--config 文件] [--detections 目标] [--save 文件]
+//   --pyramid 2|4 : 先在 1/2 或 1/4 分辨率上粗检测，再在原图的候选区域里精修 (目标较大时更快)
+//   --compare     : 金字塔模式下再做一次全图检测，打印两边框的最大偏差和配不上的框数
+//   --config 文件 : 颜色范围配置 (tuning 按 s 保存的文件)，默认 detector.yml，不存在时用下面写死的数值
+//   --detections 目标 : 检测结果写到文件或 unix:/路径，每个框一行 "帧号,类别,x,y,w,h,面积"
+//   --save 文件   : 把画好框的结果图保存下来 (后台线程编码，显示窗口不用等)
+int main(int argc, char **argv)
 {
-    Mat mask;
-    // 1. 颜色提取
-    inRange(hsv_img, lower, upper, mask);
-
-    // 2. 形态学操作（解决你遇到的噪点问题）
-    // 稍微加大一点核的大小，或者多做一次腐蚀膨胀
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(7, 7));
-
-    // 先开运算(先腐蚀后膨胀)去除背景噪点
-    morphologyEx(mask, mask, MORPH_OPEN, kernel);
-    // 再闭运算(先膨胀后腐蚀)填补物体内部空洞
-    morphologyEx(mask, mask, MORPH_CLOSE, kernel);
-
-    // 【关键点】显示二值化后的 Mask (满足任务要求)
-    imshow(maskWindowName, mask);
-
-    // 3. 寻找轮廓
-    vector<vector<Point>> contours;
-    findContours(mask, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-    // 4. 画框
-    for (size_t i = 0; i < contours.size(); i++)
+    int pyramidScale = 1;
+    bool compare = false;
+    string configPath = "detector.yml";
+    bool configGiven = false;
+    string detectionsTarget;
+    string savePath;
+    for (int i = 1; i < argc; i++)
     {
-        Rect box = boundingRect(contours[i]);
-
-        // 面积过滤：根据你的图片，可能需要调整这个阈值
-        // 如果噪点多，就把 100 改大，比如 500
-        if (box.area() > 500)
+        string arg = argv[i];
+        if (arg == "--pyramid" && i + 1 < argc)
         {
-            rectangle(display_img, box, draw_color, 2);
-
-            // (可选) 在框旁边写上颜色名字
-            putText(display_img, maskWindowName, Point(box.x, box.y - 5), FONT_HERSHEY_SIMPLEX, 0.5, draw_color, 2);
+            pyramidScale = atoi(argv[++i]);
+            if (pyramidScale != 2 && pyramidScale != 4)
+            {
+                cerr << "--pyramid 只能是 2 或 4: " << argv[i] << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--compare")
+            compare = true;
+        else if (arg == "--config" && i + 1 < argc)
+        {
+            configPath = argv[++i];
+            configGiven = true;
         }
+        else if (arg == "--detections" && i + 1 < argc)
+            detectionsTarget = argv[++i];
+        else if (arg == "--save" && i + 1 < argc)
+            savePath = argv[++i];
     }
-}
 
-int main()
-{
     Mat img = imread("test.png");
     if (img.empty())
     {
         return -1;
     }
 
-    Mat hsv;
-    cvtColor(img, hsv, COLOR_BGR2HSV);
-
-    // ---------------------------------------------------------
-    // 🚩 请在这里填入你刚才用 tuning.cpp 调试出来的数值！
-    // ---------------------------------------------------------
-
-    // 蓝色范围
-    Scalar blue_lower(100, 90, 0);
-    Scalar blue_upper(125, 255, 255);
+    // 内置的蓝色 / 黄色范围和 7x7 核 (见 detector_config.cpp)，配置文件里调过的颜色按名字覆盖上去
+    DetectorConfig config = defaultImageConfig();
+    string error;
+    if (loadDetectorConfig(configPath, config, &error))
+        cout << "使用配置文件 " << configPath << endl;
+    else if (configGiven)
+    {
+        cout << error << endl;
+        return -1;
+    }
+    const vector<ColorTarget> &targets = config.targets;
+    const DetectorParams &params = config.params;
 
-    // 黄色范围
-    // 注意：黄色的 H 很容易和橙色/绿色混淆，需要仔细微调 H_min 和 H_max
-    Scalar yellow_lower(20, 135, 76);
-    Scalar yellow_upper(42, 255, 255);
+    vector<Mat> masks;
+    vector<Detection> detections;
+    if (pyramidScale > 1)
+    {
+        // 由粗到细：Mask 窗口显示的是缩小后的粗检测结果
+        PyramidDetector detector(targets, params, pyramidScale);
+        detector.detect(img, masks, detections, 1, nullptr, nullptr);
+        if (compare)
+        {
+            // 精修的结果应该和全图检测一致 (粗检测漏掉的目标会算进配不上的框)
+            Mat hsv;
+            cvtColor(img, hsv, COLOR_BGR2HSV);
+            vector<Mat> fullMasks;
+            vector<Detection> full;
+            ColorDetector(targets, params).detect(hsv, fullMasks, full);
+            const DetectionDiff diff = compareDetections(detections, full);
+            cout << "金字塔 1/" << pyramidScale << " 对比全图：" << detections.size() << " / " << full.size()
+                 << " 个框，最大偏差 " << diff.maxBoxDelta << " 像素，配不上 " << diff.unmatched << " 个" << endl;
+        }
+    }
+    else
+    {
+        Mat hsv;
+        cvtColor(img, hsv, COLOR_BGR2HSV);
+        ColorDetector detector(targets, params);
+        detector.detect(hsv, masks, detections);
+    }
 
-    // ---------------------------------------------------------
+    // 【关键点】显示二值化后的 Mask (满足任务要求)
+    for (size_t t = 0; t < targets.size(); t++)
+        imshow(targets[t].name, masks[t]);
 
-    // 处理蓝色，并显示 Mask 窗口名为 "Blue Mask"
-    processColor(hsv, blue_lower, blue_upper, img, Scalar(255, 0, 0), "Blue Mask");
+    drawDetections(img, targets, detections);
 
-    // 处理黄色，并显示 Mask 窗口名为 "Yellow Mask"
-    processColor(hsv, yellow_lower, yellow_upper, img, Scalar(0, 255, 255), "Yellow Mask");
+    // 写结果 / 保存图片都在后台线程，不耽误弹窗口
+    DetectionSink detectionSink;
+    if (!detectionsTarget.empty())
+    {
+        if (detectionSink.open(detectionsTarget, &error))
+            detectionSink.push(0, targets, detections);
+        else
+            cout << error << endl;
+    }
+    FrameEncoder encoder(1);
+    if (!savePath.empty())
+    {
+        if (encoder.open(savePath, 0, &error))
+            encoder.push(img, 0);
+        else
+            cout << error << endl;
+    }
 
     imshow("Result", img);
 
@@ -1,5 +1,10 @@
 #include <opencv2/opencv.hpp>
+#include <algorithm>
 #include <iostream>
+#include <string>
+
+#include "detector_config.h"
+#include "hsv_lut.h"
 
 using namespace cv;
 using namespace std;
@@ -9,20 +14,97 @@ int h_min = 0, h_max = 180;
 int s_min = 0, s_max = 255;
 int v_min = 0, v_max = 255;
 
-// 回调函数（滑块动了就会调用这个，这里什么都不用做，主循环会处理）
-void on_trackbar(int, void *) {}
+// 滑块动了就会调用这个：只做个标记，记下时间，真正的计算交给主循环
+// (没有滑块变化时主循环什么都不算，不会空转占满一个核)
+bool g_dirty = true;
+int64 g_lastChange = 0;
+void on_trackbar(int, void *)
+{
+    g_dirty = true;
+    g_lastChange = getTickCount();
+}
+
+// 预览图最长边的像素数：拖动滑块时先在这个尺寸上算，松手后再算原图
+const int kPreviewSize = 640;
+// 滑块停下多少毫秒后才算原图
+const double kSettleMs = 200;
 
-int main()
+// 用法：./tuning [图片] [--config 配置文件] [--color 颜色名] [--for task2|task4]
+//   按 s 把当前范围写进配置文件 (task2 / task4 启动时会读取)，按 q 退出
+//   --for : 配置文件还不存在时以哪个程序的内置配置为底 (默认 task2)，保存的文件里其他颜色和参数不变
+int main(int argc, char **argv)
 {
-    Mat img = imread("test.png");
+    string imagePath = "test.png";
+    string configPath = "detector.yml";
+    string colorName = "Blue Mask";
+    bool forVideo = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc)
+            configPath = argv[++i];
+        else if (arg == "--color" && i + 1 < argc)
+            colorName = argv[++i];
+        else if (arg == "--for" && i + 1 < argc)
+        {
+            const string program = argv[++i];
+            if (program != "task2" && program != "task4")
+            {
+                cout << "--for 只能是 task2 或 task4: " << program << endl;
+                return -1;
+            }
+            forVideo = program == "task4";
+        }
+        else
+            imagePath = arg;
+    }
+
+    Mat img = imread(imagePath);
     if (img.empty())
     {
         cout << "No image!" << endl;
         return -1;
     }
 
-    Mat hsv;
+    // 以程序的内置配置为底，再合并已有的配置文件：按 s 保存时写出完整的一份，
+    // 只调一种颜色不会把别的颜色和形态学参数改掉
+    // 这个颜色已经有范围 (内置或上次保存的) 的话，从那里继续调
+    DetectorConfig config = forVideo ? defaultVideoConfig() : defaultImageConfig();
+    string error;
+    if (loadDetectorConfig(configPath, config, &error))
+        cout << "读取了 " << configPath << endl;
+    int index = findTarget(config, colorName);
+    ColorTarget target{colorName, Scalar(h_min, s_min, v_min), Scalar(h_max, s_max, v_max), Scalar(0, 255, 0)};
+    if (index >= 0)
+    {
+        target = config.targets[index];
+        h_min = (int)target.lower[0], s_min = (int)target.lower[1], v_min = (int)target.lower[2];
+        h_max = (int)target.upper[0], s_max = (int)target.upper[1], v_max = (int)target.upper[2];
+        cout << "从 " << colorName << " 现有的范围开始调" << endl;
+    }
+
+    // HSV 只在启动时算一次：原图一份，缩小的预览图一份
+    Mat hsv, preview, previewHsv;
     cvtColor(img, hsv, COLOR_BGR2HSV);
+    double scale = min(1.0, (double)kPreviewSize / max(img.cols, img.rows));
+    if (scale < 1.0)
+    {
+        resize(img, preview, Size(), scale, scale, INTER_AREA);
+        cvtColor(preview, previewHsv, COLOR_BGR2HSV);
+    }
+    else
+    {
+        preview = img;
+        previewHsv = hsv;
+    }
+
+    // 原图只需要显示一次；Mask 窗口固定为预览尺寸，预览和原图结果切换时窗口不跳
+    const string maskWindow = "Mask (Adjust these bars!)";
+    namedWindow("Original", WINDOW_NORMAL);
+    namedWindow(maskWindow, WINDOW_NORMAL);
+    resizeWindow("Original", preview.cols, preview.rows);
+    resizeWindow(maskWindow, preview.cols, preview.rows);
+    imshow("Original", img);
 
     namedWindow("Trackbars", WINDOW_AUTOSIZE);
 
@@ -34,20 +116,52 @@ int main()
     createTrackbar("V Min", "Trackbars", &v_min, 255, on_trackbar);
     createTrackbar("V Max", "Trackbars", &v_max, 255, on_trackbar);
 
+    HsvLut lut;
+    Mat mask;
+    bool fullPending = false;
+
     while (true)
     {
-        Mat mask;
-        // 使用滑块的值进行二值化
-        Scalar lower(h_min, s_min, v_min);
-        Scalar upper(h_max, s_max, v_max);
-        inRange(hsv, lower, upper, mask);
+        if (g_dirty)
+        {
+            // 滑块变了：重建查找表 (768 项)，先在预览图上出结果
+            g_dirty = false;
+            target.lower = Scalar(h_min, s_min, v_min);
+            target.upper = Scalar(h_max, s_max, v_max);
+            lut.build({target});
+            lut.applyOne(previewHsv, 0, mask);
+            imshow(maskWindow, mask);
+            fullPending = preview.data != img.data;
+        }
+        else if (fullPending && (getTickCount() - g_lastChange) * 1000.0 / getTickFrequency() > kSettleMs)
+        {
+            // 滑块停下来了，再算一次原图分辨率
+            lut.applyOne(hsv, 0, mask);
+            imshow(maskWindow, mask);
+            fullPending = false;
+        }
+
+        // 没事做的时候 waitKey 会在事件循环里睡眠，不占 CPU
+        int key = waitKey(fullPending ? 20 : 100);
 
-        // 显示结果
-        imshow("Original", img);
-        imshow("Mask (Adjust these bars!)", mask);
+        // 按 's' 保存到配置文件
+        if (key == 's')
+        {
+            if (index >= 0)
+                config.targets[index] = target;
+            else
+            {
+                config.targets.push_back(target);
+                index = (int)config.targets.size() - 1;
+            }
+            if (saveDetectorConfig(configPath, config))
+                cout << "已保存到 " << configPath << endl;
+            else
+                cout << "保存失败: " << configPath << endl;
+        }
 
         // 按 'q' 退出
-        if (waitKey(1) == 'q')
+        if (key == 'q')
             break;
     }
 
@@ -57,4 +171,4 @@ int main()
     cout << "Scalar upper(" << h_max << ", " << s_max << ", " << v_max << ");" << endl;
 
     return 0;
-}
\ No newline at end of file
+}
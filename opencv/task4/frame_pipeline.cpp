@@ -0,0 +1,364 @@
+#include "frame_pipeline.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+static double elapsedMs(int64 start)
+{
+    return (double)(getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+static size_t slotCount(const PipelineOptions &options)
+{
+    int workers = max(1, options.workers);
+    if (options.slots > 0)
+        return options.slots;
+    // 直播模式：分割线程各一帧 + 采集 / 输出各一帧，多了只会在队列里变旧
+    return options.live ? workers + 2 : workers * 2 + 2;
+}
+
+FramePipeline::FramePipeline(FrameSource &source, const vector<ColorTarget> &targets, const DetectorParams &params,
+                             const PipelineOptions &options)
+    : source_(source), options_(options), freeSlots_(slotCount(options)), workQueue_(slotCount(options)),
+      doneQueue_(slotCount(options))
+{
+    options_.workers = max(1, options_.workers);
+    // 增量模式要按帧序串行处理，帧内的并行交给连通域条带
+    if (options_.incremental)
+        options_.workers = 1;
+
+    // 所有槽位一开始都是空闲的
+    for (size_t i = 0; i < slotCount(options_); i++)
+    {
+        slots_.emplace_back(new FrameSlot());
+        freeSlots_.push(slots_.back().get());
+    }
+
+    DetectorConfig config;
+    config.targets = targets;
+    config.params = params;
+    current_ = buildGeneration(config, 0);
+    for (const ColorTarget &t : targets)
+        shownNames_.push_back(t.name);
+}
+
+shared_ptr<DetectorGeneration> FramePipeline::buildGeneration(const DetectorConfig &config, int generation) const
+{
+    // 查找表、形态学核、各线程的缓冲都在这里建好，分割线程拿到就能直接用
+    shared_ptr<DetectorGeneration> g = make_shared<DetectorGeneration>();
+    g->generation = generation;
+    g->config = config;
+    if (options_.incremental)
+        g->incremental.reset(new IncrementalDetector(config.targets, config.params, options_.incrementalParams));
+    else if (options_.pyramidScale > 1)
+        for (int i = 0; i < options_.workers; i++)
+            g->pyramid.emplace_back(new PyramidDetector(config.targets, config.params, options_.pyramidScale));
+    else
+        for (int i = 0; i < options_.workers; i++)
+            g->detectors.emplace_back(new ColorDetector(config.targets, config.params));
+
+    // 自适应降分辨率：每降一级，金字塔的缩小倍数再翻一倍 (原本不用金字塔时是 1/2、1/4)
+    if (options_.live && options_.dropPolicy == LiveDropPolicy::Adaptive && !options_.incremental)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            const int scale = max(1, options_.pyramidScale) << (k + 1);
+            for (int i = 0; i < options_.workers; i++)
+                g->downshift[k].emplace_back(new PyramidDetector(config.targets, config.params, scale));
+        }
+    }
+    return g;
+}
+
+void FramePipeline::reconfigure(const DetectorConfig &config)
+{
+    lock_guard<mutex> lock(reconfigureMutex_);
+    const int generation = atomic_load(&current_)->generation + 1;
+    atomic_store(&current_, buildGeneration(config, generation));
+}
+
+FramePipeline::~FramePipeline()
+{
+    shutdown();
+}
+
+void FramePipeline::run()
+{
+    activeWorkers_ = options_.workers;
+    if (options_.live)
+    {
+        live_.reset(new LiveCapture(source_, options_.livePaceFps, options_.loop));
+        live_->start();
+    }
+    threads_.emplace_back(&FramePipeline::captureLoop, this);
+    for (int i = 0; i < options_.workers; i++)
+        threads_.emplace_back(&FramePipeline::workerLoop, this, i);
+
+    // 输出阶段：分割线程完成的顺序是乱的，用一个按帧号取模的小数组重新排队
+    // 同时在途的帧不会超过槽位个数，所以取模不会冲突
+    const size_t n = slots_.size();
+    vector<FrameSlot *> reorder(n, nullptr);
+    int64_t next = 0;
+    bool quit = false;
+    deadline_ = chrono::steady_clock::now();
+
+    FrameSlot *slot = nullptr;
+    while (!quit && doneQueue_.pop(slot))
+    {
+        reorder[slot->index % n] = slot;
+        while (!quit && reorder[next % n] != nullptr)
+        {
+            FrameSlot *ready = reorder[next % n];
+            reorder[next % n] = nullptr;
+            ++next;
+            quit = !present(ready);
+            freeSlots_.push(ready);
+        }
+    }
+
+    shutdown();
+}
+
+bool FramePipeline::present(FrameSlot *slot)
+{
+    if (slot->stale)
+    {
+        // 直播模式下排队太久被丢掉的帧：不画不显示，连同它前面已经丢掉的帧一起算到下一帧的丢帧数里
+        pendingDropped_ += slot->droppedBefore + 1;
+        return true;
+    }
+    slot->droppedBefore += pendingDropped_;
+    pendingDropped_ = 0;
+
+    const vector<ColorTarget> &targets = slot->generation->config.targets;
+    int64 t0 = getTickCount();
+    drawDetections(slot->frame, targets, slot->detections);
+    slot->timings.drawMs = elapsedMs(t0);
+    slot->timings.latencyMs = elapsedMs(slot->captureTick);
+
+    if (live_)
+        updateLiveControl(*slot);
+    if (onFrame)
+        onFrame(*slot);
+
+    if (!options_.headless)
+    {
+        if (slot->generation->generation != shownGeneration_)
+        {
+            // 配置换过了：关掉新配置里已经没有的颜色的 Mask 窗口
+            shownGeneration_ = slot->generation->generation;
+            for (const string &name : shownNames_)
+            {
+                bool kept = false;
+                for (const ColorTarget &t : targets)
+                    kept = kept || t.name == name;
+                if (!kept && options_.showMasks)
+                    destroyWindow(name);
+            }
+            shownNames_.clear();
+            for (const ColorTarget &t : targets)
+                shownNames_.push_back(t.name);
+        }
+        if (options_.showMasks)
+        {
+            for (size_t t = 0; t < targets.size(); t++)
+                imshow(targets[t].name, slot->masks[t]);
+        }
+        imshow("Result", slot->frame);
+    }
+
+    // 实时节奏：用绝对的截止时间排帧，处理花掉的时间直接从等待里扣掉
+    // 落后超过一帧时不追赶，重新对齐到当前时刻
+    int waitMs = 1;
+    if (options_.realtime && options_.fps > 0)
+    {
+        const auto period = chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(1.0 / options_.fps));
+        const auto now = chrono::steady_clock::now();
+        deadline_ += period;
+        if (deadline_ + period < now)
+            deadline_ = now;
+        if (options_.headless)
+            this_thread::sleep_until(deadline_);
+        else
+            waitMs = max(1, (int)chrono::duration_cast<chrono::milliseconds>(deadline_ - now).count());
+    }
+
+    if (options_.headless)
+        return true;
+    return waitKey(waitMs) != 'q';
+}
+
+void FramePipeline::updateLiveControl(const FrameSlot &slot)
+{
+    const double latency = slot.timings.detectLatencyMs;
+    const double target = options_.latencyTargetMs;
+    if (options_.dropPolicy == LiveDropPolicy::SkipN)
+    {
+        // 跳帧之前已经在流水线里的帧延迟也高，等它们都出来了再判断，不然会连着跳
+        if (latency > target && slot.index > skipFence_)
+        {
+            skipRequest_ = options_.skipFrames;
+            skipFence_ = slot.index + (int64_t)slots_.size() + options_.skipFrames;
+        }
+        return;
+    }
+    if (options_.dropPolicy != LiveDropPolicy::Adaptive || slot.generation->downshift[0].empty())
+        return;
+
+    // 指数平均，单帧抖动不触发；换级之后只看按新级别处理的帧
+    if (slot.level != level_)
+        return;
+    latencyEwma_ = framesSinceShift_ > 0 ? latencyEwma_ * 0.8 + latency * 0.2 : latency;
+    ++framesSinceShift_;
+    const int level = level_;
+    if (latencyEwma_ > target && level < 2 && framesSinceShift_ >= 5)
+    {
+        level_ = level + 1;
+        framesSinceShift_ = 0;
+    }
+    else if (latencyEwma_ < target * 0.5 && level > 0 && framesSinceShift_ >= 30)
+    {
+        level_ = level - 1;
+        framesSinceShift_ = 0;
+    }
+}
+
+void FramePipeline::captureLoop()
+{
+    int64_t index = 0;
+    bool rewound = false;
+    int skipping = 0;
+    int64_t dropped = 0; // 直播模式：还没记到输出帧上的丢帧数
+    FrameSlot *slot = nullptr;
+
+    while ((options_.maxFrames <= 0 || index < options_.maxFrames) && freeSlots_.pop(slot))
+    {
+        if (live_)
+        {
+            // 直播模式：采集线程已经在读了，这里只取它手上最新的一帧
+            int64_t overwritten = 0;
+            if (!live_->take(slot->frame, slot->captureTick, overwritten))
+            {
+                freeSlots_.push(slot);
+                break;
+            }
+            dropped += overwritten;
+            skipping += skipRequest_.exchange(0);
+            if (skipping > 0)
+            {
+                --skipping;
+                ++dropped;
+                freeSlots_.push(slot);
+                continue;
+            }
+            slot->timings = FrameTimings();
+            slot->index = index++;
+            slot->level = level_;
+            slot->stale = false;
+            slot->droppedBefore = dropped;
+            dropped = 0;
+            if (!workQueue_.push(slot))
+                break;
+            continue;
+        }
+
+        slot->captureTick = getTickCount();
+        if (!source_.read(slot->frame))
+        {
+            // 不循环、源不能回到开头，或者连续两次读不到 (刚回到开头也读不出来)，说明视频源真的结束了
+            if (!options_.loop || rewound || !source_.rewind())
+            {
+                freeSlots_.push(slot);
+                break;
+            }
+            rewound = true;
+            freeSlots_.push(slot);
+            continue;
+        }
+        rewound = false;
+
+        slot->timings = FrameTimings();
+        slot->timings.decodeMs = elapsedMs(slot->captureTick);
+        slot->index = index++;
+        slot->level = 0;
+        slot->stale = false;
+        slot->droppedBefore = 0;
+        if (!workQueue_.push(slot))
+            break;
+    }
+    // 最后一个送出去的帧之后又丢掉的，没有帧可以带了，留给 droppedAfterLastFrame
+    captureTailDropped_ = dropped;
+    workQueue_.close();
+}
+
+void FramePipeline::workerLoop(int id)
+{
+    // 只有一个分割线程时，让连通域标记在帧内按条带并行；多个线程时帧间已经并行了
+    const int strips = options_.workers == 1 ? getNumThreads() : 1;
+
+    FrameSlot *slot = nullptr;
+    while (workQueue_.pop(slot))
+    {
+        // 直播模式 DropOldest：在队列里等的时间已经超过延迟目标的帧，处理完也没用了
+        if (live_ && options_.dropPolicy == LiveDropPolicy::DropOldest &&
+            elapsedMs(slot->captureTick) > options_.latencyTargetMs)
+        {
+            slot->stale = true;
+            doneQueue_.push(slot);
+            continue;
+        }
+
+        // 每帧开头取一次当前配置，这一帧从头到尾都用它 (中途被换掉也不影响)
+        slot->generation = atomic_load(&current_);
+        DetectorGeneration &g = *slot->generation;
+        PyramidDetector *pyramid = g.pyramid.empty() ? nullptr : g.pyramid[id].get();
+        if (slot->level > 0 && !g.downshift[slot->level - 1].empty())
+            pyramid = g.downshift[slot->level - 1][id].get();
+        if (g.incremental)
+        {
+            g.incremental->detect(slot->frame, slot->hsv, slot->masks, slot->detections, strips,
+                                  &slot->timings.detector, &slot->incremental);
+            slot->timings.hsvMs = slot->incremental.hsvMs;
+        }
+        else if (pyramid)
+        {
+            pyramid->detect(slot->frame, slot->masks, slot->detections, strips,
+                                  &slot->timings.detector, &slot->timings.hsvMs);
+            slot->incremental = IncrementalResult();
+        }
+        else
+        {
+            int64 t0 = getTickCount();
+            cvtColor(slot->frame, slot->hsv, COLOR_BGR2HSV);
+            slot->timings.hsvMs = elapsedMs(t0);
+            g.detectors[id]->detect(slot->hsv, slot->masks, slot->detections, strips, &slot->timings.detector);
+            slot->incremental = IncrementalResult();
+        }
+        slot->timings.detectLatencyMs = elapsedMs(slot->captureTick);
+        doneQueue_.push(slot);
+    }
+
+    // 最后一个退出的分割线程负责关闭输出队列
+    if (--activeWorkers_ == 0)
+        doneQueue_.close();
+}
+
+void FramePipeline::shutdown()
+{
+    // 先停采集线程，captureLoop 卡在 take 上时才能返回
+    if (live_)
+        live_->stop();
+    freeSlots_.close();
+    workQueue_.close();
+    doneQueue_.close();
+    for (auto &t : threads_)
+    {
+        if (t.joinable())
+            t.join();
+    }
+    threads_.clear();
+}
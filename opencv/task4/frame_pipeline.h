@@ -0,0 +1,170 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "color_detector.h"
+#include "detector_config.h"
+#include "frame_source.h"
+#include "incremental_detector.h"
+#include "live_capture.h"
+#include "pyramid_detector.h"
+#include "ring_buffer.h"
+
+// --------------------------------------------------------------------------------
+// 流水线式视频处理：
+//
+//   采集线程 --(workQueue)--> N 个分割线程 --(doneQueue)--> 主线程按帧号顺序显示
+//       ^                                                          |
+//       +---------------------------(freeSlots)--------------------+
+//
+// 帧槽位 (FrameSlot) 数量固定，在三个有界队列之间循环使用，
+// 里面的 Mat 会被 cap.read / cvtColor / inRange 原地复用，不会每帧重新分配。
+//
+// 检测配置可以在运行中替换 (reconfigure)：新的一组检测器在调用者线程上建好，
+// 再用原子操作把指针换上去 (RCU 方式)。分割线程每帧开头取一次当前指针，
+// 正在处理的帧继续用旧配置，旧的那组检测器在最后一个引用它的帧槽位被复用时释放，
+// 流水线不需要停下来等。
+//
+// 直播模式 (live)：采集线程换成 LiveCapture，手上永远只留最新的一帧，处理不过来就丢帧；
+// 槽位也减到刚够用 (workers + 2)，帧不会在队列里排长队。再按丢帧策略把延迟压在目标以内：
+//   DropOldest : 分割线程取到的帧如果已经比目标延迟还旧，直接丢掉不处理 (默认)
+//   SkipN      : 一帧的延迟超过目标，就跳过接下来的 N 帧，让流水线把积压处理完
+//   Adaptive   : 延迟 (指数平均) 超过目标就降一级分辨率 (金字塔 1/2 -> 1/4)，
+//                降到目标一半以下并保持一段时间再升回去
+// 每帧记录 glass-to-detection 延迟：从帧读到手到检测完 (摄像头曝光时刻拿不到，用读到手的时刻)
+// --------------------------------------------------------------------------------
+
+// 一份检测配置和按它建好的检测器，建好之后配置部分不再修改
+struct DetectorGeneration
+{
+    int generation = 0; // 第几次配置，从 0 开始
+    DetectorConfig config;
+    std::vector<std::unique_ptr<ColorDetector>> detectors; // 每个分割线程一个
+    std::unique_ptr<IncrementalDetector> incremental;
+    std::vector<std::unique_ptr<PyramidDetector>> pyramid; // 每个分割线程一个
+    // 直播模式自适应降分辨率：downshift[k] 是降 k+1 级用的金字塔检测器，每个分割线程一个
+    std::vector<std::unique_ptr<PyramidDetector>> downshift[2];
+};
+
+// 一帧在各阶段花的时间 (毫秒)
+struct FrameTimings
+{
+    double decodeMs = 0;
+    double hsvMs = 0;
+    DetectorTimings detector; // inRange / 形态学 / 连通域
+    double drawMs = 0;
+    double detectLatencyMs = 0; // 从读到这一帧到检测完 (glass-to-detection)
+    double latencyMs = 0; // 从开始读这一帧到输出阶段处理完
+};
+
+struct FrameSlot
+{
+    int64_t index = 0; // 帧号，输出阶段据此恢复顺序
+    cv::Mat frame;
+    cv::Mat hsv;
+    std::vector<cv::Mat> masks;
+    std::vector<Detection> detections;
+    FrameTimings timings;
+    cv::int64 captureTick = 0; // 开始读帧时的 getTickCount()
+    IncrementalResult incremental; // 增量模式下本帧是否全图扫描、处理了多少像素
+    std::shared_ptr<DetectorGeneration> generation; // 处理这一帧用的配置，画框 / 统计都按它的颜色表
+    int level = 0;             // 直播模式：这一帧降了几级分辨率 (0 表示原样)
+    bool stale = false;        // 直播模式：取到时已经超过目标延迟，没有处理
+    int64_t droppedBefore = 0; // 直播模式：这一帧和上一帧输出之间丢掉了几帧
+};
+
+enum class LiveDropPolicy
+{
+    DropOldest,
+    SkipN,
+    Adaptive,
+};
+
+struct PipelineOptions
+{
+    int workers = 2;       // 分割线程个数
+    int slots = 0;         // 帧槽位个数，0 表示自动 (workers * 2 + 2)
+    bool realtime = true;  // 实时节奏：按 fps 播放，等待时间会扣掉处理耗时
+    double fps = 30.0;     // 实时节奏下的目标帧率
+    bool showMasks = true; // 是否显示每种颜色的 Mask 窗口
+    bool headless = false; // 无界面模式：不调用 imshow / waitKey
+    bool loop = true;      // 视频放完后从头循环 (帧来源支持 rewind 时)
+    int64_t maxFrames = 0; // 最多处理多少帧，0 表示不限
+    bool incremental = false; // 增量模式 (只处理 ROI + 运动区域)，依赖上一帧结果，只用一个分割线程
+    IncrementalParams incrementalParams;
+    int pyramidScale = 1;     // 2 或 4 时先在缩小图上粗检测，再在原图上精修 (增量模式下不生效)
+    bool live = false;        // 直播模式：最新帧优先，处理不过来就丢帧，延迟有上界
+    LiveDropPolicy dropPolicy = LiveDropPolicy::DropOldest;
+    int skipFrames = 2;       // SkipN 策略下超过目标后跳过几帧
+    double latencyTargetMs = 100; // 直播模式的 glass-to-detection 延迟目标
+    double livePaceFps = 0;   // 直播模式下按这个帧率读源 (视频文件模拟摄像头)，0 表示不限
+};
+
+class FramePipeline
+{
+public:
+    FramePipeline(FrameSource &source, const std::vector<ColorTarget> &targets, const DetectorParams &params,
+                  const PipelineOptions &options);
+    ~FramePipeline();
+
+    // 在调用线程 (必须是主线程，imshow 要求) 上运行输出阶段，按 q 或视频读不出来时返回
+    void run();
+
+    // 换成新的检测配置，可以在任意线程调用 (比如配置文件监视线程)，从下一个开始分割的帧起生效
+    void reconfigure(const DetectorConfig &config);
+
+    // 输出阶段每处理完一帧 (按帧号顺序) 调用一次，用来做统计 / 导出结果
+    // 直播模式下被丢掉的帧不会回调，丢了几帧记在下一帧的 droppedBefore 里
+    std::function<void(const FrameSlot &)> onFrame;
+
+    // 直播模式下采集线程读到的帧数 (含丢掉的)
+    int64_t capturedFrames() const { return live_ ? live_->captured() : 0; }
+
+    // 直播模式下最后一个输出帧之后丢掉的帧 (没有下一帧可以记)，run() 返回后再调用
+    int64_t droppedAfterLastFrame() const { return pendingDropped_ + captureTailDropped_; }
+
+private:
+    void captureLoop();
+    void workerLoop(int id);
+    bool present(FrameSlot *slot);
+    void updateLiveControl(const FrameSlot &slot);
+    void shutdown();
+    std::shared_ptr<DetectorGeneration> buildGeneration(const DetectorConfig &config, int generation) const;
+
+    FrameSource &source_;
+    PipelineOptions options_;
+
+    std::vector<std::unique_ptr<FrameSlot>> slots_;
+    // 当前配置，只通过 std::atomic_load / std::atomic_store 访问
+    std::shared_ptr<DetectorGeneration> current_;
+    std::mutex reconfigureMutex_; // 多个线程同时 reconfigure 时保证代号递增
+    int shownGeneration_ = 0;     // 输出阶段上一次显示的配置，用来关掉已经不存在的 Mask 窗口
+    std::vector<std::string> shownNames_;
+
+    RingBuffer<FrameSlot *> freeSlots_;
+    RingBuffer<FrameSlot *> workQueue_;
+    RingBuffer<FrameSlot *> doneQueue_;
+
+    std::vector<std::thread> threads_;
+    std::atomic<int> activeWorkers_{0};
+
+    // 直播模式
+    std::unique_ptr<LiveCapture> live_;
+    std::atomic<int> skipRequest_{0}; // SkipN：输出阶段要求采集线程跳过的帧数
+    std::atomic<int> level_{0};       // Adaptive：当前降了几级分辨率
+    double latencyEwma_ = 0;          // 以下只在输出阶段用
+    int framesSinceShift_ = 0;
+    int64_t skipFence_ = -1;          // SkipN：帧号不超过它的帧不再触发跳帧
+    int64_t pendingDropped_ = 0;      // 丢掉的帧数，记到下一帧输出的帧上
+    std::atomic<int64_t> captureTailDropped_{0}; // 采集线程结束时手上还没记到帧上的丢帧数
+
+    std::chrono::steady_clock::time_point deadline_;
+};
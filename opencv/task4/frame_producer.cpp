@@ -0,0 +1,164 @@
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "shm_frame_ring.h"
+
+using namespace cv;
+using namespace std;
+
+// --------------------------------------------------------------------------------
+// 共享内存帧生产者：解码一次，放进共享内存帧环，本机多个 task4 (--shm 名字) 同时读
+//   ./task4_producer [视频文件|摄像头编号] [--name 名字] [--slots N] [--no-pace] [--no-loop] [--frames N]
+//   --name 名字 : 帧环的名字 (/dev/shm 下)，默认 task4
+//   --slots N   : 槽位个数，默认 8；无损读者最多能落后 N 帧
+//   --no-pace   : 不按视频 FPS 发帧，能解多快解多快 (默认按 FPS 发，模拟摄像头)
+//   --no-loop   : 视频放完就结束 (默认从头循环)
+//   --frames N  : 最多发 N 帧
+// 用视频文件就能代替摄像头做测试；Ctrl+C 结束时会通知所有消费者并删除帧环
+// --------------------------------------------------------------------------------
+
+static atomic<bool> gStop{false};
+
+static void onSignal(int)
+{
+    gStop = true;
+}
+
+static int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    string source = "video.mp4";
+    string name = "task4";
+    int slots = 8;
+    bool pace = true;
+    bool loop = true;
+    int64_t maxFrames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc)
+            name = argv[++i];
+        else if (arg == "--slots" && i + 1 < argc)
+            slots = atoi(argv[++i]);
+        else if (arg == "--no-pace")
+            pace = false;
+        else if (arg == "--no-loop")
+            loop = false;
+        else if (arg == "--frames" && i + 1 < argc)
+            maxFrames = atoll(argv[++i]);
+        else
+            source = arg;
+    }
+
+    // 纯数字当成摄像头编号
+    VideoCapture cap;
+    const bool camera = !source.empty() && source.find_first_not_of("0123456789") == string::npos;
+    if (camera)
+        cap.open(atoi(source.c_str()));
+    else
+        cap.open(source);
+    Mat first;
+    if (!cap.isOpened() || !cap.read(first) || first.empty())
+    {
+        cerr << "无法打开视频源 " << source << endl;
+        return -1;
+    }
+    double fps = cap.get(CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30.0;
+
+    // 槽位按第一帧的大小分配；之后的帧如果更大就放不下，只能丢掉
+    const size_t frameBytes = first.step[0] * first.rows;
+    ShmFrameProducer ring;
+    string error;
+    if (!ring.create(name, slots, frameBytes, fps, &error))
+    {
+        cerr << error << endl;
+        return -1;
+    }
+    cerr << "帧环 " << name << "：" << first.cols << "x" << first.rows << "，" << slots << " 个槽位，"
+         << (pace ? to_string((int)fps) + " FPS" : string("不限速")) << endl;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    const auto period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / fps));
+    auto deadline = chrono::steady_clock::now();
+    int64_t frameIndex = 0;
+    int64_t published = 0;
+    int64_t dropped = 0;
+    bool rewound = false;
+    Mat pending = first; // 第一帧已经读出来了，先发它
+    while (!gStop && (maxFrames <= 0 || published < maxFrames))
+    {
+        uint8_t *data = ring.beginFrame();
+        if (!data)
+            break;
+        const int64_t captureNs = monotonicNs();
+        Mat frame(first.rows, first.cols, first.type(), data, first.step[0]);
+        if (!pending.empty())
+        {
+            pending.copyTo(frame);
+            pending.release();
+        }
+        else if (!cap.read(frame) || frame.empty())
+        {
+            if (!loop || camera || rewound)
+                break;
+            cap.set(CAP_PROP_POS_FRAMES, 0);
+            rewound = true;
+            frameIndex = 0;
+            continue;
+        }
+        rewound = false;
+
+        // 尺寸 / 格式变了时 read 会另外分配内存，能放下就拷进槽位，放不下丢掉
+        if (frame.data != data)
+        {
+            if (frame.step[0] * frame.rows > ring.slotBytes())
+            {
+                ++dropped;
+                continue;
+            }
+            Mat slot(frame.rows, frame.cols, frame.type(), data, frame.step[0]);
+            frame.copyTo(slot);
+        }
+
+        ShmFrameInfo info;
+        info.frameIndex = frameIndex++;
+        info.width = frame.cols;
+        info.height = frame.rows;
+        info.type = frame.type();
+        info.step = (uint32_t)frame.step[0];
+        info.captureNs = captureNs;
+        ring.commitFrame(info);
+        ++published;
+
+        if (pace)
+        {
+            deadline += period;
+            const auto now = chrono::steady_clock::now();
+            if (deadline + period < now)
+                deadline = now;
+            this_thread::sleep_until(deadline);
+        }
+    }
+
+    ring.close();
+    cerr << "共发出 " << published << " 帧" << (dropped ? "，尺寸超出槽位丢掉 " + to_string(dropped) + " 帧" : string())
+         << endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+
+#include "shm_frame_ring.h"
+
+// --------------------------------------------------------------------------------
+// 流水线的帧来源：视频文件 / 摄像头 (VideoCapture)，或者共享内存帧环 (task4_producer 解码好的帧)
+// 采集线程只通过这个接口读帧，不关心帧是从哪来的
+// --------------------------------------------------------------------------------
+class FrameSource
+{
+public:
+    virtual ~FrameSource() {}
+
+    // 读下一帧到 frame (尽量复用 frame 的内存)，源结束 / 出错返回 false
+    virtual bool read(cv::Mat &frame) = 0;
+
+    // 回到开头 (循环播放用)，不支持的源返回 false
+    virtual bool rewind() { return false; }
+};
+
+class VideoCaptureSource : public FrameSource
+{
+public:
+    explicit VideoCaptureSource(cv::VideoCapture &cap) : cap_(cap) {}
+
+    bool read(cv::Mat &frame) override { return cap_.read(frame) && !frame.empty(); }
+
+    bool rewind() override
+    {
+        // 视频放完了，从头开始播放（实现循环播放效果）
+        return cap_.set(cv::CAP_PROP_POS_FRAMES, 0);
+    }
+
+private:
+    cv::VideoCapture &cap_;
+};
+
+// 自己持有 VideoCapture 的视频源：多路宿主里每路流一个
+class VideoFileSource : public FrameSource
+{
+public:
+    // 纯数字当成摄像头编号，其他当成文件名
+    bool open(const std::string &path)
+    {
+        if (!path.empty() && path.find_first_not_of("0123456789") == std::string::npos)
+            return cap_.open(std::stoi(path));
+        return cap_.open(path);
+    }
+
+    bool read(cv::Mat &frame) override { return cap_.read(frame) && !frame.empty(); }
+    bool rewind() override { return cap_.set(cv::CAP_PROP_POS_FRAMES, 0); }
+
+    double fps() const { return cap_.get(cv::CAP_PROP_FPS); }
+
+private:
+    cv::VideoCapture cap_;
+};
+
+// 从共享内存帧环读：帧已经被生产者解码好了，这里只拷一次到流水线的槽位
+// (流水线会在帧上画框，不能直接在共享内存上改，别的消费者还在读)
+class ShmFrameSource : public FrameSource
+{
+public:
+    bool open(const std::string &name, ShmFrameConsumer::Mode mode, std::string *error)
+    {
+        return consumer_.open(name, mode, error);
+    }
+
+    bool read(cv::Mat &frame) override
+    {
+        ShmFrameView view;
+        if (!consumer_.acquire(view))
+            return false;
+        const cv::Mat shared(view.info.height, view.info.width, view.info.type, const_cast<uint8_t *>(view.data),
+                             view.info.step);
+        shared.copyTo(frame);
+        consumer_.release(view);
+        return true;
+    }
+
+    double fps() const { return consumer_.fps(); }
+    uint64_t skipped() const { return consumer_.skipped(); }
+
+private:
+    ShmFrameConsumer consumer_;
+};
@@ -0,0 +1,110 @@
+#include "live_capture.h"
+
+using namespace cv;
+using namespace std;
+
+LiveCapture::LiveCapture(FrameSource &source, double paceFps, bool loop) : source_(source), loop_(loop)
+{
+    if (paceFps > 0)
+        period_ = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / paceFps));
+}
+
+LiveCapture::~LiveCapture()
+{
+    stop();
+}
+
+void LiveCapture::start()
+{
+    thread_ = thread(&LiveCapture::captureLoop, this);
+}
+
+void LiveCapture::stop()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+        ready_.notify_all();
+    }
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void LiveCapture::captureLoop()
+{
+    auto deadline = chrono::steady_clock::now();
+    bool rewound = false;
+    while (true)
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (stopping_)
+                break;
+        }
+        if (!source_.read(back_))
+        {
+            // 连续两次读不到 (刚回到开头也读不出来)，或者源根本不能回到开头，就是真的结束了
+            if (!loop_ || rewound || !source_.rewind())
+                break;
+            rewound = true;
+            continue;
+        }
+        rewound = false;
+        const int64 tick = getTickCount();
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (hasLatest_)
+            {
+                // 上一帧还没人取，直接盖掉
+                ++dropped_;
+                ++droppedSinceTake_;
+            }
+            swap(back_, latest_);
+            latestTick_ = tick;
+            hasLatest_ = true;
+            ++captured_;
+            ready_.notify_one();
+        }
+
+        if (period_.count() > 0)
+        {
+            // 模拟摄像头：按固定节奏出帧，落后超过一帧不追赶
+            deadline += period_;
+            const auto now = chrono::steady_clock::now();
+            if (deadline + period_ < now)
+                deadline = now;
+            this_thread::sleep_until(deadline);
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    ended_ = true;
+    ready_.notify_all();
+}
+
+bool LiveCapture::take(Mat &frame, int64 &glassTick, int64_t &dropped)
+{
+    unique_lock<mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return hasLatest_ || ended_ || stopping_; });
+    if (!hasLatest_ || stopping_)
+        return false;
+    swap(frame, latest_);
+    glassTick = latestTick_;
+    hasLatest_ = false;
+    dropped = droppedSinceTake_;
+    droppedSinceTake_ = 0;
+    return true;
+}
+
+int64_t LiveCapture::captured() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return captured_;
+}
+
+int64_t LiveCapture::dropped() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return dropped_;
+}
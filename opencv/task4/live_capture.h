@@ -0,0 +1,59 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "frame_source.h"
+
+// --------------------------------------------------------------------------------
+// 直播采集：单独一个线程不停地读帧，手上永远只留最新的一帧 (latest-frame-wins)
+//
+//   采集线程: read -> back_ --(交换)--> latest_ <--(交换)-- take(): 流水线的帧槽位
+//
+// 处理跟不上时，还没被取走的旧帧直接被新帧盖掉 (计入 dropped)，不会排队，
+// 所以取到的帧最多比"现在"旧一帧的时间，延迟不会越积越大。
+// 帧在三个 Mat 之间交换，不拷贝也不重新分配。
+// 视频文件可以按 paceFps 节奏读，模拟摄像头；读不出来时能 rewind 就从头继续，否则结束
+// (摄像头断开 / 共享内存帧环的生产者退出)。
+// --------------------------------------------------------------------------------
+class LiveCapture
+{
+public:
+    // paceFps > 0 时按这个帧率读 (视频文件模拟摄像头)；摄像头 / 共享内存帧环自己有节奏，传 0
+    LiveCapture(FrameSource &source, double paceFps, bool loop);
+    ~LiveCapture();
+
+    void start();
+    void stop();
+
+    // 等一帧比上次取到的更新的帧，和 frame 交换；glassTick 是这一帧读到手的 getTickCount()
+    // dropped 返回上次 take 之后被新帧盖掉的帧数。源结束 / stop 后返回 false
+    bool take(cv::Mat &frame, cv::int64 &glassTick, int64_t &dropped);
+
+    int64_t captured() const;
+    int64_t dropped() const;
+
+private:
+    void captureLoop();
+
+    FrameSource &source_;
+    std::chrono::steady_clock::duration period_{0};
+    bool loop_;
+    std::thread thread_;
+
+    cv::Mat back_; // 只有采集线程用
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    cv::Mat latest_;
+    cv::int64 latestTick_ = 0;
+    bool hasLatest_ = false;
+    bool ended_ = false;
+    bool stopping_ = false;
+    int64_t captured_ = 0;
+    int64_t dropped_ = 0;
+    int64_t droppedSinceTake_ = 0;
+};
@@ -1,100 +1,303 @@
 #include <opencv2/opencv.hpp>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "color_detector.h"
+#include "config_watcher.h"
+#include "detector_config.h"
+#include "frame_pipeline.h"
+#include "output_sink.h"
+#include "run_report.h"
+
 using namespace cv;
 using namespace std;
 
 // --------------------------------------------------------------------------------
-// 通用颜色处理函数
+// 命令行：
+//   ./task4 [视频文件|摄像头编号] [--workers N] [--no-pace] [--no-masks]
+//           [--headless] [--rate FPS] [--frames N] [--json 文件]
+//   --workers N : 分割线程个数 (默认 CPU 核数 - 2，至少 1)
+//   --no-pace   : 不按视频 FPS 播放，能跑多快跑多快
+//   --no-masks  : 不显示每种颜色的 Mask 窗口
+//   --headless  : 无界面模式 (服务器上测吞吐)，默认不限速、视频放完就结束
+//   --rate FPS  : 按固定帧率处理
+//   --frames N  : 最多处理 N 帧
+//   --json 文件 : 把每一帧的检测结果写成 JSON Lines，"-" 表示标准输出
+//   --incremental       : 增量模式 (固定机位)：只处理上一帧目标附近和运动区域
+//   --full-scan-every N : 增量模式下每 N 帧强制全图扫描一次 (默认 30)
+//   --pyramid 2|4       : 先在 1/2 或 1/4 分辨率上粗检测，再在原图的候选区域里精修
+//   --config 文件       : 颜色范围配置 (tuning 按 s 保存)，默认 detector.yml，不存在时用内置的黄色/红色
+//                         运行中修改 / 创建这个文件会自动重新读取，下一帧起生效，不用重启
+//   --no-watch          : 不监视配置文件的变化
+//   --shm 名字          : 不自己解码，从 task4_producer 建好的共享内存帧环读帧 (多个检测进程共用一路解码)
+//   --shm-lossless      : 配合 --shm，按顺序一帧不漏地读 (生产者会等这个进程)；默认只取最新帧，处理慢就跳帧
+//   --live              : 直播模式：采集线程只留最新帧，处理不过来就丢帧，端到端延迟压在目标以内
+//                         (视频文件按自身帧率读，模拟摄像头)
+//   --drop 策略         : 直播模式的丢帧策略 oldest (默认，排队超过目标的帧直接丢) /
+//                         skip:N (超过目标就跳过接下来 N 帧) / adaptive (超过目标就降分辨率)
+//   --latency-target 毫秒 : 直播模式的 glass-to-detection 延迟目标，默认 100
+//   --detections 目标   : 检测结果按批写到文件，或者 unix:/路径 (Unix socket)，每个框一行 "帧号,类别,x,y,w,h,面积"
+//   --record 文件       : 把画好框的帧编码保存：.avi / .mp4 写视频，frames/%06d.jpg 写图片序列 (文件名是帧号)
+//                         (写结果和编码都在后台线程，跟不上时丢掉输出，不会拖慢检测)
+// 结束时会输出一行 JSON 汇总：帧率 + 各阶段 (decode/hsv/inRange/morphology/contours/draw) 的 p50/p95/p99，
+// detect_latency 是从读到帧到检测完的延迟；直播模式下还有丢帧数和超过延迟目标的帧数
 // --------------------------------------------------------------------------------
-void processColor(Mat hsv_img, Scalar lower, Scalar upper, Mat &display_img, Scalar draw_color, string maskWindowName)
+int main(int argc, char **argv)
 {
-    Mat mask;
-    // 1. 颜色提取
-    inRange(hsv_img, lower, upper, mask);
-
-    // 2. 形态学操作 (去噪 + 填坑)
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
-    morphologyEx(mask, mask, MORPH_OPEN, kernel);
-    morphologyEx(mask, mask, MORPH_CLOSE, kernel);
+    string videoPath = "video.mp4";
+    string jsonPath;
+    string configPath = "detector.yml";
+    bool configGiven = false;
+    bool watch = true;
+    double rate = 0;
+    bool noPace = false;
+    string shmName;
+    string detectionsTarget;
+    string recordPath;
+    ShmFrameConsumer::Mode shmMode = ShmFrameConsumer::Mode::Latest;
+    PipelineOptions options;
+    options.workers = max(1, getNumberOfCPUs() - 2);
 
-    // 显示 Mask
-    imshow(maskWindowName, mask);
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc)
+            options.workers = max(1, atoi(argv[++i]));
+        else if (arg == "--no-pace")
+            noPace = true;
+        else if (arg == "--no-masks")
+            options.showMasks = false;
+        else if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--rate" && i + 1 < argc)
+            rate = atof(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc)
+            options.maxFrames = atoll(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--incremental")
+            options.incremental = true;
+        else if (arg == "--full-scan-every" && i + 1 < argc)
+            options.incrementalParams.fullScanInterval = max(1, atoi(argv[++i]));
+        else if (arg == "--pyramid" && i + 1 < argc)
+        {
+            options.pyramidScale = atoi(argv[++i]);
+            if (options.pyramidScale != 2 && options.pyramidScale != 4)
+            {
+                cerr << "--pyramid 只能是 2 或 4: " << argv[i] << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--config" && i + 1 < argc)
+        {
+            configPath = argv[++i];
+            configGiven = true;
+        }
+        else if (arg == "--no-watch")
+            watch = false;
+        else if (arg == "--shm" && i + 1 < argc)
+            shmName = argv[++i];
+        else if (arg == "--shm-lossless")
+            shmMode = ShmFrameConsumer::Mode::Lossless;
+        else if (arg == "--live")
+            options.live = true;
+        else if (arg == "--drop" && i + 1 < argc)
+        {
+            // 拼错的策略不能悄悄当成 oldest，直接报错退出
+            string policy = argv[++i];
+            char *end = nullptr;
+            const long skip = policy.compare(0, 5, "skip:") == 0 ? strtol(policy.c_str() + 5, &end, 10) : 0;
+            if (policy == "oldest")
+                options.dropPolicy = LiveDropPolicy::DropOldest;
+            else if (policy == "adaptive")
+                options.dropPolicy = LiveDropPolicy::Adaptive;
+            else if (end && end != policy.c_str() + 5 && *end == '\0' && skip >= 1)
+            {
+                options.dropPolicy = LiveDropPolicy::SkipN;
+                options.skipFrames = (int)min(skip, 1000L);
+            }
+            else
+            {
+                cerr << "未知的丢帧策略: " << policy << " (可选 oldest / skip:N / adaptive)" << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--detections" && i + 1 < argc)
+            detectionsTarget = argv[++i];
+        else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--latency-target" && i + 1 < argc)
+            options.latencyTargetMs = max(1.0, atof(argv[++i]));
+        else
+            videoPath = arg;
+    }
 
-    // 3. 寻找轮廓并画框
-    vector<vector<Point>> contours;
-    findContours(mask, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    // 无界面模式下标准输出留给 JSON，提示信息走 stderr
+    ostream &log = options.headless ? cerr : cout;
 
-    for (size_t i = 0; i < contours.size(); i++)
+    VideoCapture cap;
+    unique_ptr<FrameSource> source;
+    ShmFrameSource *shmSource = nullptr;
+    bool camera = false;
+    double fps = 0;
+    if (!shmName.empty())
     {
-        Rect box = boundingRect(contours[i]);
-        // 面积过滤：如果你的物体离得远，可能需要把 500 改小
-        if (box.area() > 500)
+        // 共享内存帧环：生产者已经按源的节奏在发帧，这里不再限速，也没有"从头循环"
+        unique_ptr<ShmFrameSource> shm(new ShmFrameSource());
+        string error;
+        if (!shm->open(shmName, shmMode, &error))
         {
-            rectangle(display_img, box, draw_color, 2);
-            putText(display_img, maskWindowName, Point(box.x, box.y - 5), FONT_HERSHEY_SIMPLEX, 0.5, draw_color, 2);
+            log << error << endl;
+            return -1;
         }
+        fps = shm->fps();
+        shmSource = shm.get();
+        source = move(shm);
+        log << "从共享内存帧环 " << shmName << " 读帧 ("
+            << (shmMode == ShmFrameConsumer::Mode::Lossless ? "无损" : "最新帧") << ")" << endl;
+    }
+    else
+    {
+        // 打开视频文件，纯数字当成摄像头编号
+        camera = videoPath.find_first_not_of("0123456789") == string::npos;
+        if (camera)
+            cap.open(atoi(videoPath.c_str()));
+        else
+            cap.open(videoPath);
+        if (!cap.isOpened())
+        {
+            log << "无法打开视频！请确认 build 目录下有 " << videoPath << endl;
+            return -1;
+        }
+        fps = cap.get(CAP_PROP_FPS);
+        source.reset(new VideoCaptureSource(cap));
     }
-}
 
-int main()
-{
-    // 打开视频文件
-    VideoCapture cap("video.mp4");
+    // 如果读取不到 FPS (有时会发生)，就默认 30 帧
+    options.fps = fps > 0 ? fps : 30.0;
 
-    if (!cap.isOpened())
+    // 有界面时默认按视频帧率播放并循环；无界面时默认全速跑一遍
+    options.realtime = !options.headless && shmName.empty();
+    options.loop = !options.headless;
+    if (rate > 0)
     {
-        cout << "无法打开视频！请确认 build 目录下有 video.mp4" << endl;
-        return -1;
+        options.realtime = true;
+        options.fps = rate;
     }
+    if (noPace)
+        options.realtime = false;
 
-    double fps = cap.get(CAP_PROP_FPS);
-    int delay_ms = 1000 / fps;
+    // 直播模式：节奏由源决定 (摄像头 / 共享内存帧环自己出帧，视频文件按自身帧率模拟)，输出阶段不再限速
+    if (options.live)
+    {
+        options.livePaceFps = shmName.empty() && !camera && !noPace ? options.fps : 0;
+        options.realtime = false;
+        if (options.incremental && options.dropPolicy == LiveDropPolicy::Adaptive)
+            log << "增量模式下不支持自适应降分辨率，只按最新帧丢帧" << endl;
+    }
 
-    // 如果读取不到 FPS (有时会发生)，就默认 30 帧
-    if (fps == 0)
-        delay_ms = 33;
+    // ==========================================================
+    // 颜色识别区域
+    // ==========================================================
+    // 内置黄色 / 红色 + 5x5 核 (见 detector_config.cpp)；配置文件里的颜色按名字覆盖或追加，
+    // 显式指定的配置文件读不了直接退出
+    const DetectorConfig builtin = defaultVideoConfig();
+    DetectorConfig config = builtin;
+    string error;
+    if (loadDetectorConfig(configPath, config, &error))
+        log << "使用配置文件 " << configPath << "，颜色数: " << config.targets.size() << endl;
+    else if (configGiven)
+    {
+        log << error << endl;
+        return -1;
+    }
 
-    Mat frame;
+    if (options.incremental)
+        log << "增量模式：每 " << options.incrementalParams.fullScanInterval << " 帧全图扫描一次" << endl;
+    else if (options.pyramidScale > 1)
+        log << "金字塔模式：1/" << options.pyramidScale << " 粗检测 + 原图精修，分割线程: " << options.workers << endl;
+    else
+        log << "分割线程: " << options.workers << "，" << (options.realtime ? "实时节奏" : "不限速") << endl;
 
-    while (true)
+    ofstream jsonFile;
+    ostream *jsonOut = nullptr;
+    if (jsonPath == "-")
+    {
+        jsonOut = &cout;
+    }
+    else if (!jsonPath.empty())
     {
-        cap >> frame;
-        if (frame.empty())
+        jsonFile.open(jsonPath);
+        if (!jsonFile)
         {
-            // 视频放完了，从头开始播放（实现循环播放效果）
-            cap.set(CAP_PROP_POS_FRAMES, 0);
-            continue;
+            log << "无法写入 " << jsonPath << endl;
+            return -1;
         }
+        jsonOut = &jsonFile;
+    }
 
-        // 1. 转 HSV
-        Mat hsv;
-        cvtColor(frame, hsv, COLOR_BGR2HSV);
-
-        // ==========================================================
-        // 2. 颜色识别区域 (修改了这里)
-        // ==========================================================
-
-        // --- 黄色 (Yellow) ---
-
-        processColor(hsv, Scalar(20, 43, 46), Scalar(35, 255, 255), frame, Scalar(0, 255, 255), "Yellow");
-
-        // --- 红色 (Red) ---
+    RunReport report(jsonOut);
+    if (options.live)
+    {
+        report.setLatencyTarget(options.latencyTargetMs);
+        log << "直播模式：延迟目标 " << options.latencyTargetMs << " ms" << endl;
+    }
+    // 结果 / 带框的帧交给后台线程写，输出阶段只是入队
+    DetectionSink detectionSink;
+    if (!detectionsTarget.empty() && !detectionSink.open(detectionsTarget, &error))
+    {
+        log << error << endl;
+        return -1;
+    }
+    FrameEncoder encoder;
+    if (!recordPath.empty() && !encoder.open(recordPath, options.fps, &error))
+    {
+        log << error << endl;
+        return -1;
+    }
 
-        processColor(hsv, Scalar(170, 43, 46), Scalar(180, 255, 255), frame, Scalar(0, 0, 255), "Red");
+    FramePipeline pipeline(*source, config.targets, config.params, options);
+    pipeline.onFrame = [&](const FrameSlot &slot)
+    {
+        report.record(slot);
+        if (detectionSink.isOpen())
+            detectionSink.push(slot.index, slot.generation->config.targets, slot.detections);
+        if (encoder.isOpen())
+            encoder.push(slot.frame, slot.index);
+    };
 
-        // ==========================================================
+    // 配置文件变了就在监视线程上建好新的检测器，再原子地换进流水线
+    unique_ptr<ConfigWatcher> watcher;
+    if (watch)
+        watcher.reset(
+            new ConfigWatcher(configPath, builtin, [&pipeline](const DetectorConfig &c) { pipeline.reconfigure(c); }));
 
-        imshow("Result", frame);
+    pipeline.run();
+    watcher.reset();
+    report.addDropped(pipeline.droppedAfterLastFrame());
 
-        if (waitKey(delay_ms) == 'q')
-        {
-            break;
-        }
+    report.writeSummary(cout);
+    if (detectionSink.isOpen())
+    {
+        detectionSink.close();
+        log << "检测结果：写出 " << detectionSink.written() << " 个框，丢掉 " << detectionSink.dropped() << " 帧" << endl;
     }
+    if (encoder.isOpen())
+    {
+        encoder.close();
+        log << "录像：编码 " << encoder.encoded() << " 帧，丢掉 " << encoder.dropped() << " 帧" << endl;
+    }
+    if (options.live)
+        log << "直播模式：采集线程共读到 " << pipeline.capturedFrames() << " 帧" << endl;
+    if (shmSource && shmMode == ShmFrameConsumer::Mode::Latest)
+        log << "共享内存帧环：处理不过来跳过了 " << shmSource->skipped() << " 帧" << endl;
 
     cap.release();
-    destroyAllWindows();
+    if (!options.headless)
+        destroyAllWindows();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,215 @@
+#include <opencv2/opencv.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "detector_config.h"
+#include "frame_source.h"
+#include "json_string.h"
+#include "stream_host.h"
+
+using namespace cv;
+using namespace std;
+
+// --------------------------------------------------------------------------------
+// 多路检测：一个进程同时处理很多路视频，所有流共用一组工作线程和一个帧缓冲池
+//   ./task4_multi 源[@配置文件] [源[@配置文件] ...] [--streams 列表文件] [--workers N] [--buffers N]
+//                 [--in-flight N] [--pace] [--loop] [--frames N] [--config 文件] [--json 文件]
+//   源               : 视频文件、摄像头编号，或者 shm:名字 (task4_producer 的共享内存帧环)
+//   @配置文件        : 这一路自己的颜色配置 (detector.yml 格式)，不写就用 --config 的
+//   --streams 文件   : 每行一路 "源 [配置文件]"，# 开头的行是注释 (几十路时比命令行方便)
+//   --workers N      : 工作线程个数 (默认 CPU 核数)
+//   --buffers N      : 共享帧缓冲个数 (默认 workers * 2)，内存上界 = N x 最大一路的帧
+//   --in-flight N    : 每路最多同时在途几帧 (默认 2)
+//   --pace           : 每路按自己的帧率读 (用视频文件模拟摄像头)；默认能跑多快跑多快
+//   --loop           : 视频放完从头循环 (配合 --frames 结束)
+//   --frames N       : 每路最多处理 N 帧
+//   --config 文件    : 默认的颜色配置，默认 detector.yml，不存在时用内置的黄色/红色
+//   --json 文件      : 每一帧的检测结果写成 JSON Lines (带流名)，"-" 表示标准输出
+// 没有界面；结束时每路输出一行 JSON 统计，最后一行是总的汇总
+// --------------------------------------------------------------------------------
+
+struct StreamSpec
+{
+    string source;
+    string config;
+};
+
+static StreamSpec parseSpec(const string &text)
+{
+    StreamSpec spec;
+    const size_t at = text.rfind('@');
+    spec.source = text.substr(0, at);
+    if (at != string::npos)
+        spec.config = text.substr(at + 1);
+    return spec;
+}
+
+static bool readStreamList(const string &path, vector<StreamSpec> &specs)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    string line;
+    while (getline(in, line))
+    {
+        istringstream fields(line);
+        StreamSpec spec;
+        if (!(fields >> spec.source) || spec.source[0] == '#')
+            continue;
+        fields >> spec.config;
+        specs.push_back(spec);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    vector<StreamSpec> specs;
+    string configPath = "detector.yml";
+    bool configGiven = false;
+    string jsonPath;
+    StreamHostOptions options;
+    options.workers = max(1, getNumberOfCPUs());
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--streams" && i + 1 < argc)
+        {
+            if (!readStreamList(argv[++i], specs))
+            {
+                cerr << "无法读取流列表 " << argv[i] << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--workers" && i + 1 < argc)
+            options.workers = max(1, atoi(argv[++i]));
+        else if (arg == "--buffers" && i + 1 < argc)
+            options.buffers = max(1, atoi(argv[++i]));
+        else if (arg == "--in-flight" && i + 1 < argc)
+            options.maxInFlight = max(1, atoi(argv[++i]));
+        else if (arg == "--pace")
+            options.realtime = true;
+        else if (arg == "--loop")
+            options.loop = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            options.maxFrames = atoll(argv[++i]);
+        else if (arg == "--config" && i + 1 < argc)
+        {
+            configPath = argv[++i];
+            configGiven = true;
+        }
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            specs.push_back(parseSpec(arg));
+    }
+    if (specs.empty())
+    {
+        cerr << "用法: task4_multi 源[@配置文件] [源[@配置文件] ...] [--streams 列表文件] [--workers N] ..." << endl;
+        return -1;
+    }
+
+    // 默认颜色：和 task4 一样的黄色 / 红色，配置文件 (以及每路自己的配置) 按名字覆盖上去
+    DetectorConfig defaultConfig = defaultVideoConfig();
+    string error;
+    if (!loadDetectorConfig(configPath, defaultConfig, &error) && configGiven)
+    {
+        cerr << error << endl;
+        return -1;
+    }
+
+    // 并行来自多路流，OpenCV 内部再开线程只会和工作线程抢核
+    setNumThreads(1);
+
+    StreamHost host(options);
+    for (const StreamSpec &spec : specs)
+    {
+        DetectorConfig config = defaultConfig;
+        if (!spec.config.empty() && !loadDetectorConfig(spec.config, config, &error))
+        {
+            cerr << error << endl;
+            return -1;
+        }
+
+        unique_ptr<FrameSource> source;
+        double fps = 0;
+        if (spec.source.compare(0, 4, "shm:") == 0)
+        {
+            unique_ptr<ShmFrameSource> shm(new ShmFrameSource());
+            if (!shm->open(spec.source.substr(4), ShmFrameConsumer::Mode::Latest, &error))
+            {
+                cerr << error << endl;
+                return -1;
+            }
+            fps = shm->fps();
+            source = move(shm);
+        }
+        else
+        {
+            unique_ptr<VideoFileSource> file(new VideoFileSource());
+            if (!file->open(spec.source))
+            {
+                cerr << "无法打开视频源 " << spec.source << endl;
+                return -1;
+            }
+            fps = file->fps();
+            source = move(file);
+        }
+        host.addStream(spec.source, move(source), config, fps);
+    }
+    cerr << host.streamCount() << " 路流，工作线程: " << options.workers << "，"
+         << (options.realtime ? "实时节奏" : "不限速") << endl;
+
+    ofstream jsonFile;
+    ostream *jsonOut = nullptr;
+    if (jsonPath == "-")
+    {
+        jsonOut = &cout;
+    }
+    else if (!jsonPath.empty())
+    {
+        jsonFile.open(jsonPath);
+        if (!jsonFile)
+        {
+            cerr << "无法写入 " << jsonPath << endl;
+            return -1;
+        }
+        jsonOut = &jsonFile;
+    }
+
+    // 结果在工作线程上回调，写文件要加锁；格式和 task4 --json 一样，多一个 stream 字段
+    mutex jsonMutex;
+    if (jsonOut)
+    {
+        host.onResult = [&](const StreamFrame &f)
+        {
+            const vector<ColorTarget> &targets = host.streamTargets(f.stream);
+            ostringstream line;
+            line << "{\"stream\":" << jsonString(host.streamName(f.stream)) << ",\"frame\":" << f.index << ",\"detections\":[";
+            for (size_t i = 0; i < f.detections.size(); i++)
+            {
+                const Detection &d = f.detections[i];
+                if (i > 0)
+                    line << ',';
+                line << "{\"class\":" << jsonString(targets[d.target].name) << ",\"x\":" << d.box.x << ",\"y\":" << d.box.y
+                     << ",\"w\":" << d.box.width << ",\"h\":" << d.box.height << ",\"area\":" << d.area << fixed
+                     << setprecision(1) << ",\"cx\":" << d.centroid.x << ",\"cy\":" << d.centroid.y << '}';
+            }
+            line << "]}\n";
+            lock_guard<mutex> lock(jsonMutex);
+            *jsonOut << line.str();
+        };
+    }
+
+    host.run();
+    host.writeSummary(jsonOut == &cout ? cerr : cout);
+    return 0;
+}
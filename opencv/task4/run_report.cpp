@@ -0,0 +1,82 @@
+#include "run_report.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "json_string.h"
+
+using namespace cv;
+using namespace std;
+
+static const char *kStageNames[] = {"decode", "hsv", "inRange", "morphology", "contours", "draw", "latency", "detect_latency"};
+
+RunReport::RunReport(ostream *detectionsOut) : detectionsOut_(detectionsOut)
+{
+}
+
+void RunReport::record(const FrameSlot &slot)
+{
+    const FrameTimings &t = slot.timings;
+    stages_[kDecode].record(t.decodeMs);
+    stages_[kHsv].record(t.hsvMs);
+    stages_[kInRange].record(t.detector.inRangeMs);
+    stages_[kMorphology].record(t.detector.morphologyMs);
+    stages_[kContours].record(t.detector.contoursMs);
+    stages_[kDraw].record(t.drawMs);
+    stages_[kLatency].record(t.latencyMs);
+    stages_[kDetectLatency].record(t.detectLatencyMs);
+
+    if (frames_ == 0)
+        firstTick_ = getTickCount();
+    lastTick_ = getTickCount();
+    frames_++;
+    detections_ += (int64_t)slot.detections.size();
+    fullScans_ += slot.incremental.fullScan ? 1 : 0;
+    coverageSum_ += slot.incremental.coverage;
+    reloads_ = max(reloads_, slot.generation->generation);
+    dropped_ += slot.droppedBefore;
+    overTarget_ += latencyTargetMs_ > 0 && t.detectLatencyMs > latencyTargetMs_ ? 1 : 0;
+    downshifted_ += slot.level > 0 ? 1 : 0;
+
+    if (!detectionsOut_)
+        return;
+
+    // {"frame":12,"detections":[{"class":"Red","x":..,"y":..,"w":..,"h":..,"area":..,"cx":..,"cy":..}]}
+    const vector<ColorTarget> &targets = slot.generation->config.targets;
+    ostream &out = *detectionsOut_;
+    out << "{\"frame\":" << slot.index << ",\"detections\":[";
+    for (size_t i = 0; i < slot.detections.size(); i++)
+    {
+        const Detection &d = slot.detections[i];
+        if (i > 0)
+            out << ',';
+        out << "{\"class\":" << jsonString(targets[d.target].name) << ",\"x\":" << d.box.x << ",\"y\":" << d.box.y
+            << ",\"w\":" << d.box.width << ",\"h\":" << d.box.height << ",\"area\":" << d.area << fixed
+            << setprecision(1) << ",\"cx\":" << d.centroid.x << ",\"cy\":" << d.centroid.y << '}';
+    }
+    out << "]}\n";
+}
+
+void RunReport::writeSummary(ostream &out) const
+{
+    const double seconds = frames_ > 1 ? (double)(lastTick_ - firstTick_) / getTickFrequency() : 0.0;
+    const double fps = seconds > 0 ? (double)(frames_ - 1) / seconds : 0.0;
+
+    out << fixed << setprecision(3);
+    out << "{\"summary\":{\"frames\":" << frames_ << ",\"detections\":" << detections_ << ",\"seconds\":" << seconds
+        << ",\"fps\":" << fps << ",\"full_scans\":" << fullScans_ << ",\"config_reloads\":" << reloads_
+        << ",\"mean_coverage\":" << (frames_ ? coverageSum_ / frames_ : 0.0);
+    if (latencyTargetMs_ > 0)
+        out << ",\"dropped\":" << dropped_ << ",\"latency_target_ms\":" << latencyTargetMs_
+            << ",\"over_target\":" << overTarget_ << ",\"downshifted\":" << downshifted_;
+    out << ",\"stages_ms\":{";
+    for (int s = 0; s < kStageCount; s++)
+    {
+        const LatencyHistogram &h = stages_[s];
+        if (s > 0)
+            out << ',';
+        out << jsonString(kStageNames[s]) << ":{\"p50\":" << h.percentile(50) << ",\"p95\":" << h.percentile(95)
+            << ",\"p99\":" << h.percentile(99) << ",\"mean\":" << h.mean() << ",\"max\":" << h.max() << '}';
+    }
+    out << "}}}" << endl;
+}
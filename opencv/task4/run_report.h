@@ -0,0 +1,59 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <ostream>
+#include <vector>
+
+#include "color_detector.h"
+#include "frame_pipeline.h"
+#include "latency_histogram.h"
+
+// --------------------------------------------------------------------------------
+// 运行统计：每个阶段一个延迟直方图，结束时输出 p50/p95/p99
+// 可选地把每一帧的检测结果写成 JSON Lines (一行一帧)，方便脚本处理和回归比对
+// 只在输出阶段 (单线程) 调用，不需要加锁
+// --------------------------------------------------------------------------------
+class RunReport
+{
+public:
+    // detectionsOut 为空则不输出逐帧结果；类别名取自每帧自己的配置 (运行中可能换过)
+    explicit RunReport(std::ostream *detectionsOut);
+
+    void record(const FrameSlot &slot);
+
+    // 没有记在任何输出帧上的丢帧 (直播模式结束前最后丢掉的那些)
+    void addDropped(int64_t frames) { dropped_ += frames; }
+
+    // 直播模式的延迟目标：汇总里统计 glass-to-detection 超过目标的帧数
+    void setLatencyTarget(double ms) { latencyTargetMs_ = ms; }
+
+    // 汇总信息写成一行 JSON
+    void writeSummary(std::ostream &out) const;
+
+private:
+    enum Stage
+    {
+        kDecode,
+        kHsv,
+        kInRange,
+        kMorphology,
+        kContours,
+        kDraw,
+        kLatency,
+        kDetectLatency,
+        kStageCount
+    };
+
+    std::ostream *detectionsOut_;
+    LatencyHistogram stages_[kStageCount];
+    int64_t frames_ = 0;
+    int64_t detections_ = 0;
+    int64_t fullScans_ = 0;
+    int reloads_ = 0; // 运行中换过几次配置
+    double coverageSum_ = 0;
+    double latencyTargetMs_ = 0;
+    int64_t dropped_ = 0;     // 直播模式丢掉的帧
+    int64_t overTarget_ = 0;  // glass-to-detection 超过延迟目标的帧
+    int64_t downshifted_ = 0; // 直播模式降了分辨率处理的帧
+    cv::int64 firstTick_ = 0;
+    cv::int64 lastTick_ = 0;
+};
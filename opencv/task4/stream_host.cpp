@@ -0,0 +1,306 @@
+#include "stream_host.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "json_string.h"
+
+using namespace cv;
+using namespace std;
+
+static double elapsedMs(int64 start)
+{
+    return (double)(getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+struct StreamHost::Stream
+{
+    string name;
+    unique_ptr<FrameSource> source;
+    DetectorConfig config;
+    vector<unique_ptr<ColorDetector>> detectors; // 每个在途帧一个 (检测器里有帧间复用的缓冲，不能并发用)
+    chrono::steady_clock::duration period{0};   // 实时节奏下两帧的间隔
+
+    // 以下由 StreamHost::mutex_ 保护
+    vector<ColorDetector *> freeDetectors;
+    bool reading = false; // 有工作线程正在读这一路
+    bool ended = false;
+    int inFlight = 0;     // 已经拿了缓冲、还没检测完的帧数 (含正在读的)
+    int64_t nextIndex = 0;
+    chrono::steady_clock::time_point due; // 实时节奏下最早什么时候读下一帧
+
+    mutex statsMutex;
+    StreamStats stats;
+};
+
+StreamHost::StreamHost(const StreamHostOptions &options) : options_(options)
+{
+    options_.workers = max(1, options_.workers);
+    options_.maxInFlight = max(1, options_.maxInFlight);
+    const int buffers = options_.buffers > 0 ? options_.buffers : options_.workers * 2;
+    for (int i = 0; i < buffers; i++)
+    {
+        buffers_.emplace_back(new StreamFrame());
+        freeBuffers_.push_back(buffers_.back().get());
+    }
+}
+
+StreamHost::~StreamHost()
+{
+    stop();
+    for (auto &t : threads_)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+int StreamHost::addStream(const string &name, unique_ptr<FrameSource> source, const DetectorConfig &config,
+                          double fps)
+{
+    unique_ptr<Stream> s(new Stream());
+    s->name = name;
+    s->source = move(source);
+    s->config = config;
+    for (int i = 0; i < options_.maxInFlight; i++)
+    {
+        s->detectors.emplace_back(new ColorDetector(config.targets, config.params));
+        s->freeDetectors.push_back(s->detectors.back().get());
+    }
+    s->period = chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>(1.0 / (fps > 0 ? fps : 30.0)));
+    streams_.push_back(move(s));
+    return (int)streams_.size() - 1;
+}
+
+const string &StreamHost::streamName(int stream) const
+{
+    return streams_[stream]->name;
+}
+
+const vector<ColorTarget> &StreamHost::streamTargets(int stream) const
+{
+    return streams_[stream]->config.targets;
+}
+
+const StreamStats &StreamHost::streamStats(int stream) const
+{
+    return streams_[stream]->stats;
+}
+
+void StreamHost::run()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        activeStreams_ = (int)streams_.size();
+        const auto now = chrono::steady_clock::now();
+        for (auto &s : streams_)
+            s->due = now;
+    }
+    startTick_ = getTickCount();
+    for (int i = 0; i < options_.workers; i++)
+        threads_.emplace_back(&StreamHost::workerLoop, this);
+    for (auto &t : threads_)
+        t.join();
+    threads_.clear();
+    endTick_ = getTickCount();
+}
+
+void StreamHost::stop()
+{
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+    changed_.notify_all();
+}
+
+void StreamHost::endStream(Stream &s)
+{
+    if (!s.ended)
+    {
+        s.ended = true;
+        --activeStreams_;
+        changed_.notify_all();
+    }
+}
+
+bool StreamHost::nextWork(unique_lock<mutex> &lock, int &stream, StreamFrame *&buffer, ColorDetector *&detector)
+{
+    while (!stopping_ && activeStreams_ > 0)
+    {
+        // 从上次挑中的下一路开始轮转，找第一路能读的：没在读、在途帧没到上限、(实时节奏下) 到时间了
+        const auto now = chrono::steady_clock::now();
+        auto earliest = chrono::steady_clock::time_point::max();
+        const size_t n = streams_.size();
+        int picked = -1;
+        for (size_t k = 0; k < n && !freeBuffers_.empty(); k++)
+        {
+            const size_t i = (cursor_ + k) % n;
+            Stream &s = *streams_[i];
+            if (s.ended || s.reading || s.inFlight >= options_.maxInFlight)
+                continue;
+            if (options_.maxFrames > 0 && s.nextIndex >= options_.maxFrames)
+            {
+                // 在途的帧不受影响，还会正常检测完
+                endStream(s);
+                continue;
+            }
+            if (options_.realtime && s.due > now)
+            {
+                earliest = min(earliest, s.due);
+                continue;
+            }
+            picked = (int)i;
+            cursor_ = (i + 1) % n;
+            break;
+        }
+
+        if (picked >= 0)
+        {
+            Stream &s = *streams_[picked];
+            // 优先拿这一路上次用过的缓冲，Mat 的尺寸对得上就不用重新分配
+            size_t b = freeBuffers_.size() - 1;
+            for (size_t j = 0; j < freeBuffers_.size(); j++)
+            {
+                if (freeBuffers_[j]->stream == picked)
+                {
+                    b = j;
+                    break;
+                }
+            }
+            buffer = freeBuffers_[b];
+            freeBuffers_[b] = freeBuffers_.back();
+            freeBuffers_.pop_back();
+            detector = s.freeDetectors.back();
+            s.freeDetectors.pop_back();
+            s.reading = true;
+            s.inFlight++;
+            stream = picked;
+            return true;
+        }
+
+        if (earliest != chrono::steady_clock::time_point::max())
+            changed_.wait_until(lock, earliest);
+        else if (activeStreams_ > 0)
+            changed_.wait(lock);
+    }
+    return false;
+}
+
+void StreamHost::finishWork(int stream, StreamFrame *buffer, ColorDetector *detector)
+{
+    Stream &s = *streams_[stream];
+    freeBuffers_.push_back(buffer);
+    s.freeDetectors.push_back(detector);
+    s.inFlight--;
+    changed_.notify_all();
+}
+
+void StreamHost::workerLoop()
+{
+    unique_lock<mutex> lock(mutex_);
+    int stream = -1;
+    StreamFrame *buf = nullptr;
+    ColorDetector *detector = nullptr;
+    while (nextWork(lock, stream, buf, detector))
+    {
+        Stream &s = *streams_[stream];
+        lock.unlock();
+
+        // 读帧：这一路现在归这个线程独占，读不出来时回到开头也在独占期间做
+        // 回到开头还读不出来，说明视频源真的结束了
+        buf->stream = stream;
+        buf->captureTick = getTickCount();
+        const bool ended = !s.source->read(buf->frame) &&
+                           (!options_.loop || !s.source->rewind() || !s.source->read(buf->frame));
+        buf->decodeMs = elapsedMs(buf->captureTick);
+
+        lock.lock();
+        s.reading = false;
+        if (ended)
+        {
+            endStream(s);
+            finishWork(stream, buf, detector);
+            continue;
+        }
+        buf->index = s.nextIndex++;
+        if (options_.realtime)
+        {
+            // 和单路流水线一样：落后超过一帧不追赶，重新对齐到当前时刻
+            const auto now = chrono::steady_clock::now();
+            s.due += s.period;
+            if (s.due + s.period < now)
+                s.due = now;
+        }
+        changed_.notify_all(); // 这一路可以让别的线程接着读了
+        lock.unlock();
+
+        int64 t0 = getTickCount();
+        cvtColor(buf->frame, buf->hsv, COLOR_BGR2HSV);
+        detector->detect(buf->hsv, buf->masks, buf->detections);
+        buf->detectMs = elapsedMs(t0);
+        buf->latencyMs = elapsedMs(buf->captureTick);
+
+        {
+            lock_guard<mutex> statsLock(s.statsMutex);
+            StreamStats &st = s.stats;
+            if (st.frames == 0)
+                st.firstTick = buf->captureTick;
+            st.lastTick = getTickCount();
+            st.frames++;
+            st.detections += (int64_t)buf->detections.size();
+            st.decode.record(buf->decodeMs);
+            st.detect.record(buf->detectMs);
+            st.latency.record(buf->latencyMs);
+        }
+        if (onResult)
+            onResult(*buf);
+
+        lock.lock();
+        finishWork(stream, buf, detector);
+    }
+}
+
+static void writePercentiles(ostream &out, const char *name, const LatencyHistogram &h)
+{
+    out << ',' << jsonString(name) << ":{\"p50\":" << h.percentile(50) << ",\"p95\":" << h.percentile(95)
+        << ",\"p99\":" << h.percentile(99) << ",\"max\":" << h.max() << '}';
+}
+
+void StreamHost::writeSummary(ostream &out) const
+{
+    out << fixed << setprecision(3);
+    int64_t frames = 0;
+    int64_t detections = 0;
+    LatencyHistogram latency;
+    for (const auto &s : streams_)
+    {
+        const StreamStats &st = s->stats;
+        // 第一帧到最后一帧：N 帧只跨 N-1 个间隔 (和单路的 RunReport 算法一致)
+        const double seconds = st.frames > 1 ? (double)(st.lastTick - st.firstTick) / getTickFrequency() : 0.0;
+        out << "{\"stream\":" << jsonString(s->name) << ",\"frames\":" << st.frames << ",\"detections\":" << st.detections
+            << ",\"fps\":" << (seconds > 0 ? (double)(st.frames - 1) / seconds : 0.0);
+        writePercentiles(out, "decode_ms", st.decode);
+        writePercentiles(out, "detect_ms", st.detect);
+        writePercentiles(out, "latency_ms", st.latency);
+        out << "}\n";
+        frames += st.frames;
+        detections += st.detections;
+        latency.merge(st.latency);
+    }
+
+    // 帧缓冲池实际占了多少内存：上界是 缓冲个数 x 最大的一路的帧
+    size_t bytes = 0;
+    for (const auto &b : buffers_)
+    {
+        bytes += b->frame.total() * b->frame.elemSize() + b->hsv.total() * b->hsv.elemSize();
+        for (const Mat &m : b->masks)
+            bytes += m.total() * m.elemSize();
+    }
+    const double seconds = (double)(endTick_ - startTick_) / getTickFrequency();
+    out << "{\"summary\":{\"streams\":" << streams_.size() << ",\"workers\":" << options_.workers
+        << ",\"buffers\":" << buffers_.size() << ",\"buffer_mb\":" << (double)bytes / (1024.0 * 1024.0)
+        << ",\"frames\":" << frames << ",\"detections\":" << detections << ",\"seconds\":" << seconds
+        << ",\"fps\":" << (seconds > 0 ? (double)frames / seconds : 0.0);
+    writePercentiles(out, "latency_ms", latency);
+    out << "}}" << endl;
+}
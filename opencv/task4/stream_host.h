@@ -0,0 +1,125 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "color_detector.h"
+#include "detector_config.h"
+#include "frame_source.h"
+#include "latency_histogram.h"
+
+// --------------------------------------------------------------------------------
+// 多路视频检测宿主：一个进程打开 N 路视频源，共用一组工作线程
+//
+//   流 0 ─┐                                  ┌─> onResult (流号, 帧号, 检测结果)
+//   流 1 ─┼── 轮转挑一路可读的流 ──> 工作线程 × W ──┤
+//   ...   │           ^                      └─> 帧缓冲还回共享池
+//   流 N ─┘           └──── 共享帧缓冲池 (B 个，所有流共用) <────┘
+//
+// - 工作线程自己读帧：挑一路流 -> 从共享池拿一个帧缓冲 -> 读帧 -> 检测 -> 还缓冲。
+//   同一路流同一时刻只有一个线程在读 (VideoCapture 不能多线程读)，读完马上放开，
+//   别的线程可以接着读这一路的下一帧，检测可以并行
+// - 公平：按轮转顺序挑下一路可读的流；每路在途的帧数有上限 (maxInFlight)，
+//   解码快的流不会占满缓冲池把别的流饿死
+// - 内存有上界：帧缓冲 (原图 + HSV + 掩码) 只有 B 个，和流的个数无关；
+//   缓冲尽量还给上次用它的流，分辨率不同的流之间不用反复重新分配
+// - 每路流有自己的颜色配置 (检测器) 和统计 (帧数 / 检测数 / 读帧 / 检测 / 端到端延迟)
+// --------------------------------------------------------------------------------
+
+// 共享池里的一个帧缓冲，里面的 Mat 在帧之间复用
+struct StreamFrame
+{
+    int stream = -1;   // 这一帧属于哪一路流
+    int64_t index = 0; // 这一路里的帧号 (循环播放时继续累加)
+    cv::Mat frame;
+    cv::Mat hsv;
+    std::vector<cv::Mat> masks;
+    std::vector<Detection> detections;
+    cv::int64 captureTick = 0; // 开始读帧时的 getTickCount()
+    double decodeMs = 0;
+    double detectMs = 0;  // cvtColor + 颜色检测
+    double latencyMs = 0; // 从开始读这一帧到检测完
+};
+
+struct StreamHostOptions
+{
+    int workers = 2;       // 工作线程个数
+    int buffers = 0;       // 共享帧缓冲个数，0 表示自动 (workers * 2)
+    int maxInFlight = 2;   // 每路流最多同时在途几帧
+    bool realtime = false; // 每路按自己的帧率读 (用视频文件模拟摄像头)；否则能跑多快跑多快
+    bool loop = false;     // 视频放完后从头循环 (源支持 rewind 时)
+    int64_t maxFrames = 0; // 每路最多处理多少帧，0 表示不限
+};
+
+// 一路流的统计，run 结束后读
+struct StreamStats
+{
+    int64_t frames = 0;
+    int64_t detections = 0;
+    LatencyHistogram decode;
+    LatencyHistogram detect;
+    LatencyHistogram latency;
+    cv::int64 firstTick = 0;
+    cv::int64 lastTick = 0;
+};
+
+class StreamHost
+{
+public:
+    explicit StreamHost(const StreamHostOptions &options);
+    ~StreamHost();
+
+    // 加一路流，返回流号；必须在 run 之前调用。fps 是实时节奏下这一路的帧率
+    int addStream(const std::string &name, std::unique_ptr<FrameSource> source, const DetectorConfig &config,
+                  double fps);
+
+    // 在调用线程上等所有流结束 (或 stop)，工作线程在这里启动和回收
+    void run();
+
+    // 可以在任意线程调用，正在检测的帧做完就退出
+    void stop();
+
+    // 每检测完一帧调用一次，在工作线程上调用，多个线程可能同时调用；
+    // 按完成顺序，maxInFlight > 1 时同一路的帧号可能乱序
+    std::function<void(const StreamFrame &)> onResult;
+
+    int streamCount() const { return (int)streams_.size(); }
+    const std::string &streamName(int stream) const;
+    const std::vector<ColorTarget> &streamTargets(int stream) const;
+    const StreamStats &streamStats(int stream) const;
+
+    // 每路一行 JSON，最后一行是总的汇总 (含帧缓冲池实际占用的内存)
+    void writeSummary(std::ostream &out) const;
+
+private:
+    struct Stream;
+
+    bool nextWork(std::unique_lock<std::mutex> &lock, int &stream, StreamFrame *&buffer, ColorDetector *&detector);
+    void finishWork(int stream, StreamFrame *buffer, ColorDetector *detector);
+    void endStream(Stream &s);
+    void workerLoop();
+
+    StreamHostOptions options_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::vector<std::unique_ptr<StreamFrame>> buffers_;
+
+    // 以下由 mutex_ 保护
+    std::mutex mutex_;
+    std::condition_variable changed_; // 有缓冲还回来 / 有流可以读了 / 停止
+    std::vector<StreamFrame *> freeBuffers_;
+    size_t cursor_ = 0; // 轮转调度：下一次从这一路开始找
+    int activeStreams_ = 0;
+    bool stopping_ = false;
+
+    std::vector<std::thread> threads_;
+    cv::int64 startTick_ = 0;
+    cv::int64 endTick_ = 0;
+};